@@ -7,24 +7,101 @@
 
 #include "CTimeTable.h"
 #include "CObjectiveFunction.h"
+#include "CProgress.h"
+#include "CStoppingCriteria.h"
+#include "CSolutionPublisher.h"
+#include <chrono>
+#include <ostream>
+#include <string>
+
+// Как пчелы-разведчики обновляют исчерпанный источник. Пчелы-работники и наблюдатели не выделяют память после
+// прогрева, а разведчики во всех режимах обращаются к генератору ( CTimeTable::Perturb или GenerateTimeTable ),
+// который выделяет память при каждом вызове. Поэтому цикл, на котором исчерпан хотя бы один источник, выделяет память
+// и в режимах Perturb и Elite.
+enum class ScoutMode {
+    // Сгенерировать новое решение с нуля
+    Regenerate,
+    // Заново разместить долю случайных событий исчерпанного решения
+    Perturb,
+    // Заменить исчерпанное решение возмущенной копией лучшего
+    Elite
+};
+
+// Счетчики оператора окрестности
+struct OperatorStats {
+    // Кандидаты-перемещения, которые оператор проверил, включая отвергнутые проверкой корректности
+    size_t attempted = 0;
+    // Оператор нашел допустимое перемещение ( не больше одного на вызов )
+    size_t feasible = 0;
+    // Соседнее решение оказалось лучше и заменило источник
+    size_t accepted = 0;
+};
+
+// Статистика работы CABCOptimizer: где тратится время и сколько работы делает каждая фаза
+struct ABCStats {
+    OperatorStats swap;
+    OperatorStats move;
+    OperatorStats kempe_swap;
+
+    // Вычисления функции ошибки
+    size_t evaluations = 0;
+    // Копирования расписаний
+    size_t copies = 0;
+    // Откаты и перезапуски генератора при начальной генерации и работе пчел-разведчиков
+    GeneratorStats generator;
+
+    std::chrono::duration<double> employed_time {0};
+    std::chrono::duration<double> onlooker_time {0};
+    std::chrono::duration<double> scout_time {0};
+    std::chrono::duration<double> memorize_time {0};
+};
+
+std::ostream& operator<<(std::ostream& stream, const ABCStats& stats);
 
 class CABCOptimizer {
 protected:
 
     std::vector< std::pair<CTimeTable, size_t> > solutions_ {};
     std::pair<CTimeTable, size_t> current_best_solution_;
+    // Заготовка для соседнего решения. Переиспользуется между итерациями, поэтому шаг не выделяет память
+    CTimeTable candidate_;
 
     size_t population_size_;
-    size_t maximum_cycle_number_;
+    // Условия остановки; по умолчанию -- maximum_cycle_number циклов
+    CStoppingCriteria stopping_criteria_;
     size_t single_source_limit_;
 
+    ScoutMode scout_mode_;
+    // Доля событий, размещаемых заново в режимах ScoutMode::Perturb и ScoutMode::Elite
+    double scout_perturbation_fraction_;
+
     CObjectiveFunction cost_function_;
+    ABCStats stats_;
+    CProgressReporter progress_;
+    CSolutionPublisher best_publisher_;
+
+    // Пройдено циклов и затрачено времени, в том числе до контрольной точки, с которой продолжена работа
+    size_t cycle_;
+    std::chrono::duration<double> elapsed_time_;
+    // Файл контрольной точки ( пустой -- не записывать ) и период записи
+    std::string checkpoint_filename_;
+    std::chrono::duration<double> checkpoint_interval_;
 
-    void memorizeBestSolution();
+    ProgressCounters progressCounters(size_t cycle) const;
+
+    // Значение функции ошибки с подсчетом в stats_
+    int evaluate(const CTimeTable& solution);
+    // Скопировать расписание с подсчетом в stats_
+    void copySolution(CTimeTable& destination, const CTimeTable& source);
+
+    // Запомнить лучший источник; при улучшении опубликовать снимок, найденный на цикле cycle
+    void memorizeBestSolution(size_t cycle);
 
     void sendEmploedBees();
     void sendOnlookerBees();
     void sendScoutBees();
+    // Обновить исчерпанный источник согласно scout_mode_. false, если требуется полная генерация
+    bool scoutSource(CTimeTable& solution);
     void sendBee(std::pair<CTimeTable, size_t>& solution);
 
     int valuesSum();
@@ -32,10 +109,36 @@ protected:
 public:
 
     CABCOptimizer( CTimeTable& timetable, size_t population_size,
-                   size_t maximum_cycle_number, size_t single_source_limit );
+                   size_t maximum_cycle_number, size_t single_source_limit,
+                   ScoutMode scout_mode = ScoutMode::Regenerate, double scout_perturbation_fraction = 0.2 );
 
     void FindOptimal();
     auto GetCurrentBestSolution();
+    // Лучшее решение на данный момент. В отличие от GetCurrentBestSolution, можно вызывать из другого потока
+    // во время работы FindOptimal.
+    CSolutionSnapshotPtr GetBestSnapshot() const;
+    // Вызывать callback при каждом улучшении лучшего решения ( в потоке оптимизатора )
+    void SetImprovementCallback(CSolutionPublisher::ImprovementCallback callback);
+
+    // Записывать контрольную точку в filename раз в interval_seconds и при любой остановке FindOptimal ( в том числе
+    // по флагу отмены, который выставляется по SIGTERM )
+    void SetCheckpoint(const std::string& filename, double interval_seconds);
+    // Записать полное состояние: популяцию, лучшее решение, счетчики циклов, времени и статистики, состояние
+    // генератора случайных чисел потока. Файл заменяется атомарно. false, если записать не удалось.
+    bool SaveCheckpoint(const std::string& filename) const;
+    // Продолжить с контрольной точки: следующий FindOptimal в том же потоке продолжит работу точно так же, как
+    // продолжилась бы прерванная. Выкидывает CBadCheckpoint, если файл не читается, поврежден или записан для другой
+    // задачи или размера популяции; тогда состояние оптимизатора не меняется.
+    void LoadCheckpoint(const std::string& filename);
+    // Статистика работы; сам оптимизатор ее не выводит
+    const ABCStats& GetStats() const;
+    // Отправлять отчеты о ходе работы в sink не чаще раза в interval_seconds ( по умолчанию -- в консоль раз в
+    // секунду ). nullptr отключает отчеты.
+    void SetProgressSink(std::shared_ptr<CProgressSink> sink, double interval_seconds);
+    // Заменить условия остановки, заданные конструктором ( предел итераций и времени )
+    void SetStoppingCriteria(const CStoppingCriteria& stopping_criteria);
+    // Почему завершился последний FindOptimal
+    StopReason GetStopReason() const;
 
 };
 
@@ -10,10 +10,11 @@ class CCabinet {
 private:
 
     const std::string name_;
+    // Плотный номер: позиция имени среди всех имен того же типа ( см. IndexByName )
+    size_t index_;
     const size_t capacity_;
     const int64_t available_time_;
 
-    int64_t current_available_time_;
 
 public:
 
@@ -23,15 +24,13 @@ public:
 
     CCabinet ( const CCabinet& other ) = default;
 
-    std::string GetName() const;
+    const std::string& GetName() const;
+    size_t GetIndex() const;
     int64_t GetAvailableTime() const;
     size_t GetCapacity() const;
-    bool IsFeasible(size_t start_time, size_t duration) const;
 
-    void ReserveTime(size_t start_time, size_t duration);
-    void ReleaseTime(size_t start_time, size_t duration);
-    // Восстановить кабинет, то есть вернуть свободное время к начальному состоянию
-    void RecoverCabinet();
+    void SetIndex(size_t index);
+
 
 };
 
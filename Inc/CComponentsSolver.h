@@ -0,0 +1,55 @@
+#ifndef TIMER_CCOMPONENTSSOLVER_H
+#define TIMER_CCOMPONENTSSOLVER_H
+
+#include "CTimeTable.h"
+#include <exception>
+#include <thread>
+
+// Решить задачу по компонентам связности ( см. CTimeTableBuilder::BuildComponents ): каждая компонента
+// оптимизируется функцией solve в своем потоке, после чего решения собираются в общее расписание.
+// solve принимает CTimeTable& компоненты и ее номер ( порядок компонент одинаков при одних и тех же входных данных ) и
+// возвращает лучшее найденное для нее расписание. Если parallel == false, компоненты решаются по очереди в вызывающем
+// потоке ( когда задачи уже распределены по потокам, как в пакетном режиме ).
+// Исключение из solve ( например, CBadTimeTable ) выкидывается в вызывающем потоке после завершения всех компонент;
+// если их несколько -- исключение компоненты с меньшим номером.
+//______________________________________________________________________________________________________________________
+template <class Solver>
+CTimeTable SolveByComponents(CTimeTableBuilder& builder, Solver solve, bool parallel = true) {
+    std::vector<CTimeTable> components = builder.BuildComponents();
+
+    if ( components.size() == 1 )
+        return solve(components.front(), 0);
+
+    std::vector<CTimeTable> solutions(components);
+    if ( !parallel ) {
+        for (size_t i = 0; i < components.size(); i++)
+            solutions[i] = solve(components[i], i);
+        return builder.Merge(solutions);
+    }
+
+    std::vector<std::thread> threads;
+    threads.reserve(components.size());
+    // Исключение, вылетевшее из потока, вызвало бы std::terminate, поэтому оно передается в вызывающий поток
+    std::vector<std::exception_ptr> errors(components.size());
+
+    for (size_t i = 0; i < components.size(); i++)
+        threads.emplace_back( [&solutions, &components, &solve, &errors, i] () {
+            TRACE_SCOPE("Solve component");
+            try {
+                solutions[i] = solve(components[i], i);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        } );
+
+    for (auto& thread : threads)
+        thread.join();
+
+    for (const auto& error : errors)
+        if (error)
+            std::rethrow_exception(error);
+
+    return builder.Merge(solutions);
+}
+
+#endif //TIMER_CCOMPONENTSSOLVER_H
@@ -0,0 +1,44 @@
+#ifndef TIMER_CCONFLICTGRAPH_H
+#define TIMER_CCONFLICTGRAPH_H
+
+#include <vector>
+#include <cstdint>
+
+// Граф конфликтов предметов: вершины -- порядковые номера предметов ( CSubject::GetIndex ), ребро -- предметы
+// не могут идти одновременно, т.к. у них есть общий учитель или группа. Строки матрицы смежности хранятся плотными
+// битсетами, поэтому вопрос "с какими из данных предметов конфликтует предмет" решается одним AND по словам.
+// Общие кабинеты ребром не считаются: конфликт по кабинету зависит от того, какие кабинеты назначены событиям.
+//______________________________________________________________________________________________________________________
+class CConflictGraph {
+public:
+
+    using Row = std::vector<uint64_t>;
+
+private:
+
+    size_t subjects_number_;
+    size_t words_number_;
+    std::vector<Row> adjacency_;
+    std::vector<size_t> degrees_;
+
+public:
+
+    explicit CConflictGraph( size_t subjects_number );
+
+    size_t GetSubjectsNumber() const;
+    // Строка матрицы смежности предмета subject_index
+    const Row& GetNeighbours( size_t subject_index ) const;
+    size_t GetDegree( size_t subject_index ) const;
+    bool Conflicting( size_t first_index, size_t second_index ) const;
+    // true, если предмет конфликтует хотя бы с одним предметом из subjects ( битсет той же длины, что строки )
+    bool ConflictsWithAny( size_t subject_index, const Row& subjects ) const;
+    // Пустой битсет подходящей длины для ConflictsWithAny
+    Row MakeRow() const;
+    static void SetBit( Row& row, size_t subject_index );
+    static void ResetBit( Row& row, size_t subject_index );
+
+    void AddConflict( size_t first_index, size_t second_index );
+
+};
+
+#endif //TIMER_CCONFLICTGRAPH_H
@@ -7,20 +7,33 @@
 
 #include "CSubject.h"
 #include "CCabinet.h"
+#include "CPoolAllocator.h"
 #include <list>
 #include <map>
 
+class CEvent;
+
+// Отношение порядка на множестве событий -- их положение во времени
+//______________________________________________________________________________________________________________________
+struct EventComporator {
+    bool operator() (const CEvent* a, const CEvent* b) const;
+};
+
+// События одного предмета одной группы в CEventLinker. Узлы берутся из пула потока: при оптимизации события
+// постоянно удаляются и добавляются, и без пула каждое перемещение обращалось бы к куче.
+using CLinkedEvents = std::set<CEvent*, EventComporator, CPoolAllocator<CEvent*>>;
+
 // Событие -- класс, представляющий предмет в "пространстве-времени", т.е. предмет с кабинетом и временем начала
 //______________________________________________________________________________________________________________________
 class CEvent {
 private:
 
-    CSubject* subject_;
-    std::set<CCabinet *const, Comparator<CCabinet>> cabinets_;
+    const CSubject* subject_;
+    CCabinetSet cabinets_;
     size_t start_time_;
 
     // Итератор на себя в CEventLinker для быстрого доступа при удалении
-    std::set<CEvent*>::iterator myself_;
+    CLinkedEvents::iterator myself_;
 
     friend class CEventLinker;
 
@@ -32,14 +45,14 @@ public:
 
     std::string GetName() const;
     size_t GetId() const;
-    CSubject* GetSubject() const;
+    const CSubject* GetSubject() const;
     size_t GetStartTime() const;
-    const std::set<CTeacher *const, Comparator<CTeacher>>& GetTeachers() const;
-    const std::set<CCabinet *const, Comparator<CCabinet>>& GetCabinets() const;
+    const std::set<const CTeacher *const, Comparator<CTeacher>>& GetTeachers() const;
+    const CCabinetSet& GetCabinets() const;
     bool IsActive() const;
 
     void SetSubject(const CSubject* subject);
-    void SetCabinets(std::set<CCabinet *const, Comparator<CCabinet>> cabinet);
+    void SetCabinets(CCabinetSet cabinet);
     void SetStartTime(size_t start_time);
 
     // Освободить событие, то есть subject_ = nullptr, т.к. активность события -- это subject_ == nullptr
@@ -47,14 +60,6 @@ public:
 
 };
 
-// Отношение порядка на множестве событий -- их положение во времени
-//______________________________________________________________________________________________________________________
-struct EventComporator {
-    bool operator() (const CEvent* a, const CEvent* b) const {
-        return a->GetStartTime() < b->GetStartTime();
-    }
-};
-
 // Вспомогательный класс, служащий для того, чтобы связывать события, представляющие копии одних и тех же предметов,
 // т.е. в одним и тем же id в рамках одной группы. Например, если на неделе 10 уроков математики у 11А, то данный класс
 // предоставляет возможность итерироваться именно по списку уроков математики в 11А. Основная миссия -- быстрый доступ
@@ -64,7 +69,8 @@ struct EventComporator {
 class CEventLinker {
 private:
 
-    std::map < std::string, std::map< size_t, std::set<CEvent*, EventComporator> > > linked_events_;
+    // Номер группы x id предмета -> события
+    std::vector< std::map< size_t, CLinkedEvents > > linked_events_;
 
 public:
 
@@ -73,9 +79,9 @@ public:
 
     const auto& GetLinkedEvents() const;
 
-    void InsertEvent(std::string group_name, CEvent& event);
-    void DeleteEvent(std::string group_name, CEvent& event);
-    // Очистить все списки предметов, оставив только струткуру, т.е. group_name x id x std::set. Последние во всех
+    void InsertEvent(size_t group_index, CEvent& event);
+    void DeleteEvent(size_t group_index, CEvent& event);
+    // Очистить все списки предметов, оставив только струткуру, т.е. номер группы x id x std::set. Последние во всех
     // тройках будт пусты. Используется при восстановлении CTimeTable.
     void FreeEvents();
 
@@ -40,4 +40,42 @@ public:
     {}
 };
 
+// Расписание заведомо невозможно составить: нарушена одна из необходимых оценок ( см. CTimeTableBuilder::CheckFeasibility )
+class CInfeasibleTimeTable : public CBadTimeTable {
+public:
+    explicit CInfeasibleTimeTable(std::string msg)
+    : CBadTimeTable(msg)
+    {}
+};
+
+// Файл контрольной точки поврежден или записан для другой задачи
+class CBadCheckpoint : public CException {
+public:
+    explicit CBadCheckpoint(std::string msg)
+    : CException(msg)
+    {}
+};
+
+// Скомпилированный файл задачи поврежден или записан другой версией формата
+class CBadInstance : public CException {
+public:
+    explicit CBadInstance(std::string msg)
+    : CException(msg)
+    {}
+};
+
+// Ошибка во входном файле. Сообщение -- "file:line:column: message", без строки и столбца, если ошибка не в содержимом.
+class CParseError : public CException {
+    std::string filename_;
+    size_t line_;
+    size_t column_;
+
+public:
+    CParseError(std::string filename, size_t line, size_t column, std::string msg);
+
+    const std::string& GetFilename() const;
+    size_t GetLine() const;
+    size_t GetColumn() const;
+};
+
 #endif //TIMER_CEXCEPTION_H
@@ -10,11 +10,11 @@ class CGroup {
 private:
 
     const std::string name_;
+    // Плотный номер: позиция имени среди всех имен того же типа ( см. IndexByName )
+    size_t index_;
     const size_t students_number_;
     const int64_t available_time_;
-    int64_t current_available_time_;
 
-    int cashed_current_available_time_size_;
 
 public:
 
@@ -23,14 +23,12 @@ public:
             int64_t current_available_time );
 
     const std::string& GetName() const;
+    size_t GetIndex() const;
     size_t GetStudentsNumber() const;
     int64_t GetAvailableTime() const;
-    size_t GetAvailableTimeSize() const;
 
-    void ReserveTime(size_t start_time, size_t duration);
-    void ReleaseTime(size_t start_time, size_t duration);
-    // Восстановить группу, то есть вернуть к первоначальному состояние свободное время
-    void RecoverGroup();
+    void SetIndex(size_t index);
+
 
 };
 
@@ -0,0 +1,79 @@
+#ifndef TIMER_CINPUTTOKENIZER_H
+#define TIMER_CINPUTTOKENIZER_H
+
+#include "CException.h"
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Разбор входного файла на слова за один проход через буфер чтения: без std::getline и std::stringstream на строку.
+// Строка файла -- одна запись, слова разделены пробелами. Для каждого слова запоминается строка и столбец ( в символах
+// UTF-8, с единицы ), и ошибки разбора выкидываются как CParseError с позицией file:line:column.
+//
+//     CInputTokenizer tokenizer(filename);
+//     while ( tokenizer.NextRecord() ) {
+//         std::string name = tokenizer.ReadName("group name");
+//         size_t students_number = tokenizer.ReadNumber("students number");
+//         tokenizer.ExpectEndOfLine();
+//     }
+//______________________________________________________________________________________________________________________
+class CInputTokenizer {
+private:
+
+    std::string filename_;
+    std::ifstream file_;
+
+    std::vector<char> buffer_;
+    size_t buffer_position_;
+    size_t buffer_size_;
+
+    // Позиция следующего символа
+    size_t line_;
+    size_t column_;
+
+    // Последнее прочитанное слово и его позиция. Память слова переиспользуется.
+    std::string token_;
+    size_t token_line_;
+    size_t token_column_;
+
+    // Начало текущей записи
+    size_t record_line_;
+    size_t record_column_;
+
+    // Следующий символ или -1 в конце файла
+    int peek();
+    void advance();
+    // Пропустить пробелы внутри строки
+    void skipSpaces();
+    // Прочитать слово в token_. Если строка кончилась, ошибка "expected <expected>".
+    const std::string& nextToken(const char* expected);
+
+public:
+
+    // Выкидывает CParseError, если файл не открывается
+    explicit CInputTokenizer(const std::string& filename);
+
+    // Перейти к следующей непустой строке. false в конце файла.
+    bool NextRecord();
+    // true, если в текущей строке больше нет слов
+    bool AtEndOfLine();
+    // Ошибка, если в строке остались слова
+    void ExpectEndOfLine();
+
+    // Слово как есть. Ссылка действительна до следующего чтения.
+    const std::string& ReadName(const char* expected);
+    // Неотрицательное целое
+    size_t ReadNumber(const char* expected);
+    // Необязательное последнее неотрицательное целое. false, если строка кончилась.
+    bool TryReadNumber(const char* expected, size_t& value);
+    // Маска времени из 0 и 1, старший бит -- первый символ ( как Str2Int64 ). В length -- количество символов.
+    int64_t ReadMask(const char* expected, size_t* length = nullptr);
+
+    // Ошибка в позиции последнего прочитанного слова
+    CParseError Error(const std::string& message) const;
+    // Ошибка в позиции начала текущей записи
+    CParseError RecordError(const std::string& message) const;
+
+};
+
+#endif //TIMER_CINPUTTOKENIZER_H
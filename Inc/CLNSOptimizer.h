@@ -0,0 +1,52 @@
+#ifndef TIMER_CLNSOPTIMIZER_H
+#define TIMER_CLNSOPTIMIZER_H
+
+#include "CTimeTable.h"
+#include "CObjectiveFunction.h"
+#include "CProgress.h"
+#include "CStoppingCriteria.h"
+#include <chrono>
+
+// Оптимизатор методом поиска в большой окрестности ( ruin and recreate ). На каждой итерации из копии текущего
+// решения удаляется день, неделя группы или уроки учителя ( CTimeTable::RuinAndRecreate ), удаленное размещается
+// заново генератором. Новое решение принимается, если оно не хуже текущего.
+//______________________________________________________________________________________________________________________
+class CLNSOptimizer {
+protected:
+
+    std::pair<CTimeTable, size_t> current_best_solution_;
+    // Заготовка для соседнего решения. Переиспользуется между итерациями, поэтому шаг не выделяет память
+    CTimeTable candidate_;
+
+    // Условия остановки; по умолчанию -- maximum_iteration_number итераций или time_budget_seconds секунд
+    CStoppingCriteria stopping_criteria_;
+
+    // Количество итераций, успешно размещенных заново решений и принятых решений
+    size_t iteration_;
+    size_t evaluations_number_;
+    size_t accepted_number_;
+
+    CObjectiveFunction cost_function_;
+    CProgressReporter progress_;
+
+    void makeStep();
+    ProgressCounters progressCounters() const;
+
+public:
+
+    CLNSOptimizer( CTimeTable& timetable, size_t maximum_iteration_number, double time_budget_seconds );
+
+    void FindOptimal();
+    auto GetCurrentBestSolution();
+    // Отправлять отчеты о ходе работы в sink не чаще раза в interval_seconds ( по умолчанию -- в консоль раз в
+    // секунду ). nullptr отключает отчеты.
+    void SetProgressSink(std::shared_ptr<CProgressSink> sink, double interval_seconds);
+    // Заменить условия остановки, заданные конструктором ( предел итераций и времени )
+    void SetStoppingCriteria(const CStoppingCriteria& stopping_criteria);
+    // Почему завершился последний FindOptimal
+    StopReason GetStopReason() const;
+
+};
+
+
+#endif //TIMER_CLNSOPTIMIZER_H
@@ -0,0 +1,66 @@
+#ifndef TIMER_CMAPPEDFILE_H
+#define TIMER_CMAPPEDFILE_H
+
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+// Файл, отображенный в память только для чтения. Страницы подгружаются системой по мере чтения и разделяются всеми
+// процессами, открывшими тот же файл. Выкидывает CException, если файл не открывается.
+//______________________________________________________________________________________________________________________
+class CMappedFile {
+private:
+
+    const char* data_;
+    size_t size_;
+
+public:
+
+    explicit CMappedFile(const std::string& filename);
+    ~CMappedFile();
+
+    CMappedFile( const CMappedFile& ) = delete;
+    CMappedFile& operator=( const CMappedFile& ) = delete;
+
+    const char* GetData() const;
+    size_t GetSize() const;
+
+};
+
+// Последовательное чтение двоичных значений из памяти. Как и у потоков, ошибка запоминается: чтение за концом
+// возвращает нулевое значение, и вызывающая сторона проверяет IsValid.
+//______________________________________________________________________________________________________________________
+class CMemoryReader {
+private:
+
+    const char* position_;
+    const char* end_;
+    bool valid_;
+
+    // true и сдвиг на size байт, если они есть
+    bool take(size_t size);
+
+public:
+
+    CMemoryReader(const char* data, size_t size);
+
+    template <class T>
+    T Read() {
+        static_assert(std::is_trivially_copyable<T>::value, "only trivially copyable values are read as bytes");
+        T value {};
+        const char* position = position_;
+        if ( take(sizeof(T)) )
+            std::memcpy(&value, position, sizeof(T));
+        return value;
+    }
+    // Строка, записанная как длина uint32_t и байты ( см. WriteBinaryString )
+    std::string ReadString();
+    // true, если следующие size байт равны bytes; они пропускаются
+    bool Expect(const char* bytes, size_t size);
+
+    bool IsValid() const;
+    bool IsAtEnd() const;
+
+};
+
+#endif //TIMER_CMAPPEDFILE_H
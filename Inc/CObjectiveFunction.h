@@ -6,8 +6,15 @@
 #define TIMER_COBJECTIVEFUNCTION_H
 
 #include "CTimeTable.h"
+#include "CWeekGeometry.h"
 
 class CObjectiveFunction {
+private:
+
+    // Значение для конкретного размера недели ( CWeekGeometry или CRuntimeWeekGeometry )
+    template <class Geometry>
+    static int value(const CTimeTable& timetable, const Geometry& geometry);
+
 public:
 
     static int Value(const CTimeTable& timetable);
@@ -0,0 +1,55 @@
+#ifndef TIMER_COCCUPANCY_H
+#define TIMER_COCCUPANCY_H
+
+#include <vector>
+#include <map>
+#include <string>
+#include <cstdint>
+
+class CTeacher;
+class CGroup;
+class CCabinet;
+class CSubject;
+
+// Изменяемая часть расписания: свободное в данный момент время учителей, групп и кабинетов по их номерам.
+// Сами учителя, группы и кабинеты неизменны и общие для всех копий расписания ( CProblemInstance ), поэтому
+// занимаемое и освобождаемое время хранится здесь, в каждой копии CTimeTable своя занятость.
+//______________________________________________________________________________________________________________________
+class COccupancy {
+private:
+
+    std::vector<int64_t> teachers_time_;
+    std::vector<int64_t> groups_time_;
+    std::vector<int64_t> cabinets_time_;
+
+public:
+
+    // Все свободны в соответствии со своим начальным свободным временем
+    COccupancy( const std::map< std::string, CTeacher >& teachers,
+                const std::map< std::string, CGroup >& groups,
+                const std::map< std::string, CCabinet >& cabinets );
+
+    int64_t GetTeacherTime(const CTeacher* teacher) const;
+    int64_t GetGroupTime(const CGroup* group) const;
+    int64_t GetCabinetTime(const CCabinet* cabinet) const;
+    // true, если кабинет свободен на duration уроков, начиная со start_time
+    bool IsCabinetFeasible(const CCabinet* cabinet, size_t start_time, size_t duration) const;
+
+    // Время, в которое свободны все учителя и группы предмета и которое допустимо для самого предмета
+    int64_t GetSubjectAvailableTime(const CSubject* subject) const;
+    int64_t GetSubjectAvailableStartTime(const CSubject* subject, size_t days_in_week, size_t lessons_in_day) const;
+    size_t GetSubjectAvailableTimeSize(const CSubject* subject) const;
+
+    void ReserveTeacher(const CTeacher* teacher, size_t start_time, size_t duration);
+    void ReleaseTeacher(const CTeacher* teacher, size_t start_time, size_t duration);
+    void ReserveGroup(const CGroup* group, size_t start_time, size_t duration);
+    void ReleaseGroup(const CGroup* group, size_t start_time, size_t duration);
+    void ReserveCabinet(const CCabinet* cabinet, size_t start_time, size_t duration);
+    void ReleaseCabinet(const CCabinet* cabinet, size_t start_time, size_t duration);
+    // Занять или освободить время всех учителей и групп предмета на всю его длину
+    void ReserveSubject(const CSubject* subject, size_t start_time);
+    void ReleaseSubject(const CSubject* subject, size_t start_time);
+
+};
+
+#endif //TIMER_COCCUPANCY_H
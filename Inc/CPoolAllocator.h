@@ -0,0 +1,109 @@
+#ifndef TIMER_CPOOLALLOCATOR_H
+#define TIMER_CPOOLALLOCATOR_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+// Аллокатор узлов ( std::set, std::map ) со списком свободных блоков в каждом потоке. Освобожденный узел не
+// возвращается в кучу, а кладется в список потока и отдается при следующем выделении, поэтому при установившемся
+// числе узлов, как в CEventLinker во время оптимизации, обращений к куче нет. Блоки, освобожденные в другом потоке,
+// попадают в его список. Массивы ( n != 1 ) выделяются обычным образом.
+//______________________________________________________________________________________________________________________
+template <class T>
+class CPoolAllocator {
+private:
+
+    // Свободный блок хранит указатель на следующий свободный блок
+    struct CFreeBlock {
+        CFreeBlock* next;
+    };
+
+    static constexpr size_t BLOCK_SIZE = sizeof(T) > sizeof(CFreeBlock) ? sizeof(T) : sizeof(CFreeBlock);
+    static constexpr size_t BLOCK_ALIGNMENT = alignof(T) > alignof(CFreeBlock) ? alignof(T) : alignof(CFreeBlock);
+
+    // Список свободных блоков потока. Блоки возвращаются в кучу при завершении потока.
+    struct CFreeList {
+        CFreeBlock* head = nullptr;
+
+        ~CFreeList() {
+            while (head) {
+                CFreeBlock* next = head->next;
+                ::operator delete( head, std::align_val_t(BLOCK_ALIGNMENT) );
+                head = next;
+            }
+            listDestroyed() = true;
+        }
+    };
+
+    // Флаг тривиально разрушаем, поэтому его можно читать и после разрушения списка -- например, из деструкторов
+    // thread_local контейнеров ( буфер цепочки Кемпе в CTimeTable ), созданных раньше списка и поэтому
+    // разрушаемых позже него
+    static bool& listDestroyed() {
+        static thread_local bool destroyed = false;
+        return destroyed;
+    }
+
+    // nullptr, если список потока уже разрушен: тогда блоки выделяются и освобождаются напрямую в куче
+    static CFreeList* freeList() {
+        if ( listDestroyed() )
+            return nullptr;
+        static thread_local CFreeList free_list;
+        return &free_list;
+    }
+
+public:
+
+    using value_type = T;
+    using is_always_equal = std::true_type;
+
+    template <class U>
+    struct rebind {
+        using other = CPoolAllocator<U>;
+    };
+
+    CPoolAllocator() = default;
+    template <class U>
+    CPoolAllocator(const CPoolAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        if (n != 1)
+            return static_cast<T*>( ::operator new( n * sizeof(T), std::align_val_t(alignof(T)) ) );
+
+        CFreeList* free_list = freeList();
+        if ( !free_list || !free_list->head )
+            return static_cast<T*>( ::operator new( BLOCK_SIZE, std::align_val_t(BLOCK_ALIGNMENT) ) );
+
+        CFreeBlock* block = free_list->head;
+        free_list->head = block->next;
+        return reinterpret_cast<T*>(block);
+    }
+
+    void deallocate(T* pointer, size_t n) {
+        if (n != 1) {
+            ::operator delete( pointer, std::align_val_t(alignof(T)) );
+            return;
+        }
+
+        CFreeList* free_list = freeList();
+        if (!free_list) {
+            ::operator delete( pointer, std::align_val_t(BLOCK_ALIGNMENT) );
+            return;
+        }
+        CFreeBlock* block = reinterpret_cast<CFreeBlock*>(pointer);
+        block->next = free_list->head;
+        free_list->head = block;
+    }
+
+    template <class U>
+    bool operator==(const CPoolAllocator<U>&) const {
+        return true;
+    }
+    template <class U>
+    bool operator!=(const CPoolAllocator<U>&) const {
+        return false;
+    }
+
+};
+
+#endif //TIMER_CPOOLALLOCATOR_H
@@ -0,0 +1,61 @@
+#ifndef TIMER_CPROBLEMINSTANCE_H
+#define TIMER_CPROBLEMINSTANCE_H
+
+#include "CTeacher.h"
+#include "CCabinet.h"
+#include "CGroup.h"
+#include "CSubject.h"
+#include "CConflictGraph.h"
+#include <cstdint>
+#include <memory>
+
+// Неизменная часть задачи: учителя, кабинеты, группы, предметы со связями между ними, размер недели и граф
+// конфликтов. Создается один раз при построении CTimeTable и разделяется всеми его копиями через
+// std::shared_ptr<const CProblemInstance>, поэтому копия расписания хранит только свою занятость и события.
+//______________________________________________________________________________________________________________________
+class CProblemInstance {
+private:
+
+    std::map< std::string, CTeacher > teachers_;
+    std::map< std::string, CCabinet > cabinets_;
+    std::map< std::string, CGroup > groups_;
+    std::map< std::string, CSubject > subjects_;
+
+    size_t days_in_week_, lessons_in_day_;
+
+    std::shared_ptr<const CConflictGraph> conflict_graph_;
+
+    // Хеш имен, номеров и связей всех объектов задачи и размера недели
+    uint64_t fingerprint_;
+
+    friend class CTimeTable;
+
+public:
+
+    // Учителя, кабинеты и группы копируются и нумеруются заново ( в части задачи из BuildComponents есть не все
+    // из них ), предметы перестраиваются с указателями на скопированные объекты.
+    CProblemInstance( const std::map< std::string, CTeacher >& teachers,
+                      const std::map< std::string, CCabinet >& cabinets,
+                      const std::map< std::string, CGroup >& groups,
+                      const std::map< std::string, CSubject >& subjects,
+                      std::shared_ptr<const CConflictGraph> conflict_graph,
+                      size_t days_in_week, size_t lessons_in_day );
+
+    // Объект неперемещаем: на учителей, кабинеты, группы и предметы ссылаются указатели
+    CProblemInstance( const CProblemInstance& ) = delete;
+    CProblemInstance& operator=( const CProblemInstance& ) = delete;
+
+    const std::map< std::string, CTeacher >& GetTeachers() const;
+    const std::map< std::string, CCabinet >& GetCabinets() const;
+    const std::map< std::string, CGroup >& GetGroups() const;
+    const std::map< std::string, CSubject >& GetSubjects() const;
+    size_t GetDaysInWeek() const;
+    size_t GetLessonsInDay() const;
+    const CConflictGraph& GetConflictGraph() const;
+    // Совпадает у задач с одинаковыми учителями, кабинетами, группами, предметами и их связями; по нему контрольная
+    // точка проверяет, что она записана для той же задачи
+    uint64_t GetFingerprint() const;
+
+};
+
+#endif //TIMER_CPROBLEMINSTANCE_H
@@ -0,0 +1,168 @@
+#ifndef TIMER_CPROGRESS_H
+#define TIMER_CPROGRESS_H
+
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Накопленные с начала работы счетчики оптимизатора, которые он передает в CProgressReporter::Update
+struct ProgressCounters {
+    size_t iteration = 0;
+    // 0, если предел итераций не задан
+    size_t maximum_iteration_number = 0;
+    size_t best_cost = 0;
+    // Вычисления функции ошибки
+    size_t evaluations = 0;
+    // Предложенные и принятые соседние решения
+    size_t attempted = 0;
+    size_t accepted = 0;
+};
+
+// Отчет о ходе работы. Скорость вычислений и доля принятых решений -- за время с предыдущего отчета.
+struct ProgressReport {
+    const char* optimizer;
+    size_t iteration;
+    size_t maximum_iteration_number;
+    double elapsed_seconds;
+    size_t best_cost;
+    double evaluations_per_second;
+    double acceptance_rate;
+    // Последний отчет, отправляется по завершении работы
+    bool final;
+    // Задача пакетного режима ( пустая строка вне его ) и номер компоненты, см. CLabelledProgressSink
+    std::string job;
+    size_t component = 0;
+};
+
+// Вывести text в консоль целиком. Компоненты и задачи пакетного режима решаются в нескольких потоках, поэтому
+// сообщения оптимизаторов ( причина остановки, статистика ) выводятся под общим мьютексом -- тем же, что у
+// CConsoleProgressSink, -- и строки разных потоков не перемешиваются.
+void WriteConsole(const std::string& text);
+
+// Приемник отчетов. Может вызываться из нескольких потоков ( компоненты решаются параллельно ).
+//______________________________________________________________________________________________________________________
+class CProgressSink {
+public:
+
+    virtual ~CProgressSink() = default;
+    virtual void Report(const ProgressReport& report) = 0;
+
+};
+
+// Строка состояния в консоли, как раньше: процент и лучшая оценка, перезаписываемые через '\r'
+//______________________________________________________________________________________________________________________
+class CConsoleProgressSink : public CProgressSink {
+public:
+
+    void Report(const ProgressReport& report) override;
+
+};
+
+// Один JSON-объект на строку для машинной обработки ( JSON Lines ). Файл пишет отдельный поток: Report только
+// кладет отчет в очередь, поэтому поток поиска не ждет диска. Деструктор дописывает очередь и дожидается потока.
+//______________________________________________________________________________________________________________________
+class CJsonLinesProgressSink : public CProgressSink {
+private:
+
+    std::ofstream file_;
+
+    std::mutex mutex_;
+    std::condition_variable queue_changed_;
+    std::vector<ProgressReport> queue_;
+    bool stopping_;
+
+    // Запускается последним, когда остальные поля уже созданы
+    std::thread writer_;
+
+    void write();
+
+public:
+
+    explicit CJsonLinesProgressSink(const std::string& filename);
+    ~CJsonLinesProgressSink() override;
+
+    CJsonLinesProgressSink( const CJsonLinesProgressSink& ) = delete;
+    CJsonLinesProgressSink& operator=( const CJsonLinesProgressSink& ) = delete;
+
+    void Report(const ProgressReport& report) override;
+
+};
+
+// Подписывает отчеты задачей job и компонентой component и передает их в sink. Через нее отчеты нескольких задач
+// и компонент, идущие в один приемник ( общий файл JSON Lines в пакетном режиме ), можно различить.
+//______________________________________________________________________________________________________________________
+class CLabelledProgressSink : public CProgressSink {
+private:
+
+    std::shared_ptr<CProgressSink> sink_;
+    std::string job_;
+    size_t component_;
+
+public:
+
+    CLabelledProgressSink(std::shared_ptr<CProgressSink> sink, std::string job, size_t component);
+
+    void Report(const ProgressReport& report) override;
+
+};
+
+// Хранит последний отчет, чтобы его можно было запросить из другого потока ( состояние задачи в режиме службы )
+//______________________________________________________________________________________________________________________
+class CLatestProgressSink : public CProgressSink {
+private:
+
+    mutable std::mutex mutex_;
+    ProgressReport report_;
+    bool reported_;
+
+public:
+
+    CLatestProgressSink();
+
+    void Report(const ProgressReport& report) override;
+
+    // false, если отчетов еще не было
+    bool Get(ProgressReport& report) const;
+
+};
+
+// Ограничитель частоты отчетов. Оптимизатор вызывает Update на каждой итерации, приемник же получает отчет не чаще
+// раза в interval, поэтому вывод не замедляет поиск: между отчетами Update только сравнивает время.
+//______________________________________________________________________________________________________________________
+class CProgressReporter {
+private:
+
+    const char* optimizer_;
+    std::shared_ptr<CProgressSink> sink_;
+    std::chrono::duration<double> interval_;
+
+    std::chrono::steady_clock::time_point start_;
+    std::chrono::steady_clock::time_point last_report_;
+    ProgressCounters last_counters_;
+
+    void report(const ProgressCounters& counters, std::chrono::steady_clock::time_point now, bool final);
+
+public:
+
+    // Без приемника отчеты не отправляются
+    CProgressReporter( const char* optimizer,
+                       std::shared_ptr<CProgressSink> sink = std::make_shared<CConsoleProgressSink>(),
+                       double interval_seconds = 1 );
+
+    void SetSink(std::shared_ptr<CProgressSink> sink, double interval_seconds);
+
+    // Начать отсчет времени работы
+    void Start();
+    // Передать отчет приемнику, если с предыдущего прошло не меньше interval
+    void Update(const ProgressCounters& counters);
+    // Передать последний отчет
+    void Finish(const ProgressCounters& counters);
+
+};
+
+#endif //TIMER_CPROGRESS_H
@@ -0,0 +1,86 @@
+#ifndef TIMER_CSAOPTIMIZER_H
+#define TIMER_CSAOPTIMIZER_H
+
+#include "CTimeTable.h"
+#include "CObjectiveFunction.h"
+#include "CProgress.h"
+#include "CStoppingCriteria.h"
+#include <chrono>
+#include <random>
+
+// Закон понижения температуры. После повторного нагрева линейный и логарифмический законы отсчитываются заново:
+// начальной считается температура нагрева.
+enum class CoolingSchedule {
+    // T = T * cooling_rate
+    Geometric,
+    // Линейное убывание от начальной до конечной температуры за maximum_iteration_number итераций
+    Linear,
+    // T = T0 / ( 1 + cooling_rate * ln(1 + k) )
+    Logarithmic
+};
+
+// Оптимизатор методом имитации отжига. В отличие от CABCOptimizer хранит одно текущее решение,
+// поэтому итерация стоит одну копию расписания. Окрестность -- CTimeTable::RandomSwap и CTimeTable::RandomMove.
+//______________________________________________________________________________________________________________________
+class CSAOptimizer {
+protected:
+
+    std::pair<CTimeTable, size_t> current_solution_;
+    std::pair<CTimeTable, size_t> current_best_solution_;
+    // Заготовка для соседнего решения. Переиспользуется между итерациями, поэтому шаг не выделяет память
+    CTimeTable candidate_;
+
+    double initial_temperature_;
+    double final_temperature_;
+    double cooling_rate_;
+    CoolingSchedule cooling_schedule_;
+
+    size_t maximum_iteration_number_;
+    // Количество итераций без улучшения лучшего решения, после которого происходит повторный нагрев
+    size_t reheat_limit_;
+    // Доля начальной температуры, до которой происходит повторный нагрев
+    double reheat_ratio_;
+    // Условия остановки; по умолчанию -- maximum_iteration_number итераций или time_budget_seconds секунд
+    CStoppingCriteria stopping_criteria_;
+
+    double temperature_;
+    // Температура, от которой отсчитываются линейный и логарифмический законы: начальная, после нагрева --
+    // температура нагрева
+    double reheat_temperature_;
+    // Номер итерации с момента последнего нагрева, по нему считается температура
+    size_t schedule_step_;
+    size_t iterations_without_improvement_;
+    // Количество выполненных и принятых шагов
+    size_t steps_number_;
+    size_t accepted_number_;
+
+    CObjectiveFunction cost_function_;
+    std::mt19937 random_generator_;
+    CProgressReporter progress_;
+
+    void coolDown();
+    void reheat();
+    bool accept(int delta);
+    void makeStep();
+    ProgressCounters progressCounters() const;
+
+public:
+
+    CSAOptimizer( CTimeTable& timetable, double initial_temperature, double final_temperature,
+                  double cooling_rate, CoolingSchedule cooling_schedule, size_t maximum_iteration_number,
+                  size_t reheat_limit, double reheat_ratio, double time_budget_seconds );
+
+    void FindOptimal();
+    auto GetCurrentBestSolution();
+    // Отправлять отчеты о ходе работы в sink не чаще раза в interval_seconds ( по умолчанию -- в консоль раз в
+    // секунду ). nullptr отключает отчеты.
+    void SetProgressSink(std::shared_ptr<CProgressSink> sink, double interval_seconds);
+    // Заменить условия остановки, заданные конструктором ( предел итераций и времени )
+    void SetStoppingCriteria(const CStoppingCriteria& stopping_criteria);
+    // Почему завершился последний FindOptimal
+    StopReason GetStopReason() const;
+
+};
+
+
+#endif //TIMER_CSAOPTIMIZER_H
@@ -0,0 +1,90 @@
+#ifndef TIMER_CSCHEDULINGSERVER_H
+#define TIMER_CSCHEDULINGSERVER_H
+
+#include "CSchedulingService.h"
+#include <atomic>
+#include <chrono>
+#include <string>
+
+// Соединение с клиентом через сокет с буферизованным чтением. Ошибка, конец данных или истечение срока соединения
+// запоминаются, как у потоков: после них чтение возвращает false. Срок общий для всех чтений и записей, поэтому
+// клиент, присылающий данные по байту, не удержит соединение дольше него.
+//______________________________________________________________________________________________________________________
+class CSocketConnection {
+private:
+
+    int descriptor_;
+    std::chrono::steady_clock::time_point deadline_;
+    std::string buffer_;
+    size_t position_;
+    bool valid_;
+
+    // Дождаться events ( POLLIN или POLLOUT ); false, если срок соединения истек
+    bool wait(short events);
+    // Дочитать в буфер; false при ошибке, конце данных или истечении срока
+    bool fill();
+
+public:
+
+    // Соединение закрывается деструктором. Чтения и записи возвращают false через timeout_seconds после создания.
+    CSocketConnection(int descriptor, double timeout_seconds);
+    ~CSocketConnection();
+
+    CSocketConnection( const CSocketConnection& ) = delete;
+    CSocketConnection& operator=( const CSocketConnection& ) = delete;
+
+    // Строка без '\n'; false, если строка длиннее max_size или данные кончились раньше
+    bool ReadLine(std::string& line, size_t max_size);
+    // Ровно size байт
+    bool ReadBytes(std::string& bytes, size_t size);
+    bool Write(const std::string& data);
+
+};
+
+// Служба расписаний на локальном сокете ( Unix domain socket ). Каждое соединение -- один запрос и один ответ:
+//
+//     SUBMIT <priority> <path>             -> OK <id>
+//     SUBMIT_DATA <priority> <name>        -> OK <id>
+//         и затем четыре файла, каждый как "<filename> <size>\n" и size байт содержимого
+//     STATUS <id>                          -> OK <status>
+//     LIST                                 -> OK <n>, затем n строк <status>
+//     RESULT <id> GROUPS|TEACHERS          -> OK <size>, затем size байт LaTeX
+//     CANCEL <id>                          -> OK
+//     FORGET <id>                          -> OK
+//     SHUTDOWN                             -> OK
+//
+// <status> -- пары key=value через пробел: id, state, priority, seconds, затем, если есть, optimizer, component,
+// iteration, best_cost ( ход работы текущей компоненты ), provisional_cost ( промежуточное расписание ) и cost
+// ( итоговое расписание ), последними -- name и message до конца строки. Ошибка -- "ERR <message>". Задача с большим
+// priority запускается раньше. RESULT решаемой задачи возвращает ее промежуточное расписание. FORGET удаляет
+// завершенную задачу вместе с ее папкой.
+//______________________________________________________________________________________________________________________
+class CSchedulingServer {
+private:
+
+    CSchedulingService& service_;
+    std::string socket_path_;
+    int listener_;
+    bool shutdown_requested_;
+
+    void handle(CSocketConnection& connection);
+    std::string submitData(CSocketConnection& connection, int priority, const std::string& name);
+    std::string result(size_t id, const std::string& kind) const;
+
+public:
+
+    // Создает сокет socket_path с доступом только для владельца и группы. Выкидывает CException, если сокет
+    // уже обслуживается другим процессом или его нельзя создать; оставшийся от упавшего процесса файл удаляется.
+    CSchedulingServer(CSchedulingService& service, std::string socket_path);
+    // Закрывает и удаляет сокет
+    ~CSchedulingServer();
+
+    CSchedulingServer( const CSchedulingServer& ) = delete;
+    CSchedulingServer& operator=( const CSchedulingServer& ) = delete;
+
+    // Обслуживать запросы, пока не придет SHUTDOWN или *stop_flag не станет true
+    void Run(const std::atomic<bool>* stop_flag);
+
+};
+
+#endif //TIMER_CSCHEDULINGSERVER_H
@@ -0,0 +1,150 @@
+#ifndef TIMER_CSCHEDULINGSERVICE_H
+#define TIMER_CSCHEDULINGSERVICE_H
+
+#include "CProgress.h"
+#include "CSolutionPublisher.h"
+#include "CThreadPool.h"
+#include "CTimeTable.h"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+enum class JobState {
+    Queued,
+    Running,
+    Done,
+    Failed,
+    // Отменена в очереди или во время работы; во втором случае записано лучшее найденное расписание
+    Cancelled
+};
+
+const char* JobStateName(JobState state);
+
+// Состояние задачи на момент запроса
+struct JobStatus {
+    size_t id;
+    std::string name;
+    int priority;
+    JobState state;
+    // Последний отчет оптимизатора текущей компоненты; has_progress == false, если отчетов еще не было
+    bool has_progress;
+    ProgressReport progress;
+    // Расписание записано, cost -- его оценка
+    bool has_result;
+    size_t cost;
+    // Решаемая задача уже опубликовала промежуточное расписание, provisional_cost -- его оценка
+    bool has_provisional;
+    size_t provisional_cost;
+    // Время работы ( без ожидания в очереди )
+    double seconds;
+    // Ошибка, если задача не решена
+    std::string message;
+};
+
+// Очередь задач долгоживущей службы. Задачи решаются на общем пуле потоков по убыванию приоритета; состояние,
+// ход работы и расписание каждой можно запросить, пока задача не забыта. Входные данные и расписания задачи хранятся
+// в папке work_folder/job-<id>/ ( GOutput.tex и TOutput.tex ). Завершенная задача забывается по Forget или
+// автоматически, когда завершенных становится больше max_finished_jobs ( сначала самые старые ), -- тогда удаляется
+// и ее папка. Пока задача решается, можно запросить ее промежуточное расписание -- лучшее из опубликованных
+// решателем через on_improvement.
+//______________________________________________________________________________________________________________________
+class CSchedulingService {
+public:
+
+    // Читает задачу из input ( папка с четырьмя текстовыми файлами или скомпилированный файл ) и решает ее.
+    // Должен останавливаться, когда *cancel_flag станет true, и отправлять отчеты о ходе работы в sink. Может
+    // публиковать промежуточные расписания через on_improvement ( из любого потока ).
+    using Solver = std::function<CTimeTable( const std::string& input, const std::atomic<bool>* cancel_flag,
+                                             std::shared_ptr<CProgressSink> sink,
+                                             CSolutionPublisher::ImprovementCallback on_improvement )>;
+
+    // Файлы, из которых состоит задача, переданная содержимым
+    static const std::vector<std::string> INPUT_FILES;
+
+private:
+
+    struct Job {
+        size_t id;
+        std::string name;
+        int priority;
+        std::string input;
+        std::string folder;
+        std::atomic<bool> cancel_requested;
+        std::shared_ptr<CLatestProgressSink> progress;
+
+        // Под mutex_ службы
+        JobState state;
+        std::chrono::steady_clock::time_point start;
+        double seconds;
+        bool has_result;
+        size_t cost;
+        std::string message;
+        // Последнее промежуточное расписание; сбрасывается, когда задача завершается
+        CSolutionSnapshotPtr provisional;
+    };
+
+    std::string work_folder_;
+    Solver solver_;
+    size_t max_finished_jobs_;
+
+    mutable std::mutex mutex_;
+    std::map< size_t, std::shared_ptr<Job> > jobs_;
+    size_t next_id_;
+    // Для имен временных файлов промежуточных расписаний
+    std::atomic<size_t> next_provisional_file_;
+
+    // Объявлен последним, поэтому разрушается первым и дожидается задач, пока остальные поля еще живы
+    CThreadPool pool_;
+
+    std::string createJobFolder(size_t id) const;
+    // Удалить папку задачи с файлами, которые в нее пишет служба
+    static void removeJobFolder(const std::string& folder);
+    // Завершенная задача: ее больше не запустит пул и не изменит поток решения. Под mutex_.
+    static bool isFinished(const Job& job);
+    // Забыть самые старые завершенные задачи сверх max_finished_jobs_. Под mutex_; возвращает папки для удаления.
+    std::vector<std::string> evictFinished();
+    size_t enqueue(size_t id, std::string name, int priority, std::string input);
+    void run(const std::shared_ptr<Job>& job);
+    JobStatus status(const Job& job) const;
+
+public:
+
+    // Папка work_folder создается, если ее нет. Выкидывает CException, если ее нельзя создать.
+    CSchedulingService(std::string work_folder, size_t threads_number, Solver solver, size_t max_finished_jobs);
+    // Отменяет все задачи и дожидается их завершения
+    ~CSchedulingService();
+
+    CSchedulingService( const CSchedulingService& ) = delete;
+    CSchedulingService& operator=( const CSchedulingService& ) = delete;
+
+    // Поставить в очередь задачу из папки или скомпилированного файла input. Возвращает номер задачи.
+    size_t Submit(const std::string& input, int priority);
+    // Поставить в очередь задачу, переданную содержимым файлов INPUT_FILES ( имя файла -> содержимое ).
+    // Выкидывает CException, если набор файлов не совпадает с INPUT_FILES.
+    size_t SubmitData(const std::string& name, const std::map<std::string, std::string>& files, int priority);
+
+    std::optional<JobStatus> GetStatus(size_t id) const;
+    // Состояния всех задач по возрастанию номера
+    std::vector<JobStatus> GetStatuses() const;
+    // Файл с расписанием групп ( teachers == false ) или учителей; пустая строка, если расписания нет
+    std::string GetResultFile(size_t id, bool teachers) const;
+    // Записать промежуточное расписание решаемой задачи в ее папку ( provisional-GOutput.tex или
+    // provisional-TOutput.tex ) и вернуть имя файла; пустая строка, если задача не решается или еще ничего
+    // не опубликовала. Файл подменяется атомарно, поэтому одновременные запросы не видят частично записанного.
+    std::string WriteProvisionalResult(size_t id, bool teachers);
+
+    // false, если задачи нет или она уже завершена
+    bool Cancel(size_t id);
+    void CancelAll();
+    // Забыть завершенную задачу и удалить ее папку. false, если задачи нет или она еще в очереди или решается.
+    bool Forget(size_t id);
+
+};
+
+#endif //TIMER_CSCHEDULINGSERVICE_H
@@ -0,0 +1,58 @@
+#ifndef TIMER_CSOLUTIONPUBLISHER_H
+#define TIMER_CSOLUTIONPUBLISHER_H
+
+#include "CTimeTable.h"
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+// Неизменяемый снимок лучшего решения на момент публикации
+struct SolutionSnapshot {
+    CTimeTable timetable;
+    size_t cost;
+    // Итерация ( цикл ) оптимизатора, на которой найдено решение
+    size_t iteration;
+    double elapsed_seconds;
+};
+
+using CSolutionSnapshotPtr = std::shared_ptr<const SolutionSnapshot>;
+
+// Публикует лучшее решение оптимизатора, пока тот работает. Оптимизатор при каждом улучшении создает новый снимок
+// и подменяет указатель на него; читатель из любого потока забирает копию указателя и дальше работает со своим
+// снимком, не видя частично скопированного расписания. Указатель защищен мьютексом, но под ним только копируется
+// или подменяется shared_ptr: расписание копируется до блокировки, а старый снимок освобождается после нее, поэтому
+// поиск ждет читателя не дольше копирования указателя. Старый снимок освобождается, когда его отпустит последний
+// читатель.
+//______________________________________________________________________________________________________________________
+class CSolutionPublisher {
+public:
+
+    // Вызывается в потоке оптимизатора после публикации, поэтому должен работать быстро
+    using ImprovementCallback = std::function<void(const CSolutionSnapshotPtr& snapshot)>;
+
+private:
+
+    mutable std::mutex mutex_;
+    CSolutionSnapshotPtr snapshot_;
+    ImprovementCallback callback_;
+    std::chrono::steady_clock::time_point start_;
+
+public:
+
+    CSolutionPublisher();
+
+    // Задавать до запуска оптимизатора
+    void SetCallback(ImprovementCallback callback);
+
+    // Начать отсчет времени работы
+    void Start();
+    // Скопировать расписание в новый снимок и опубликовать его
+    void Publish(const CTimeTable& timetable, size_t cost, size_t iteration);
+
+    // Последний опубликованный снимок или nullptr. Можно вызывать из любого потока.
+    CSolutionSnapshotPtr Get() const;
+
+};
+
+#endif //TIMER_CSOLUTIONPUBLISHER_H
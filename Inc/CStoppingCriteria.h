@@ -0,0 +1,76 @@
+#ifndef TIMER_CSTOPPINGCRITERIA_H
+#define TIMER_CSTOPPINGCRITERIA_H
+
+#include <atomic>
+#include <chrono>
+#include <optional>
+
+// Почему оптимизатор остановился
+enum class StopReason {
+    // Работа продолжается
+    None,
+    IterationLimit,
+    TimeBudget,
+    TargetCost,
+    // Лучшая оценка не улучшалась заданное число итераций или секунд
+    NoImprovement,
+    // Выставлен внешний флаг отмены
+    Cancelled
+};
+
+const char* StopReasonName(StopReason reason);
+
+// Условия остановки оптимизатора. Задаются любым набором сеттеров; оптимизатор останавливается, как только
+// выполнено любое из заданных условий. Не заданное условие не проверяется.
+//
+//     CStoppingCriteria criteria;
+//     criteria.SetTimeBudget(300).SetNoImprovementTime(60).SetCancelFlag(&cancel);
+//     optimizer.SetStoppingCriteria(criteria);
+//
+// Каждый оптимизатор хранит свою копию, поэтому одни и те же условия можно отдать оптимизаторам всех компонент.
+// Флаг отмены общий: он не копируется, а хранится по указателю.
+//______________________________________________________________________________________________________________________
+class CStoppingCriteria {
+private:
+
+    std::optional<size_t> iteration_limit_;
+    std::optional< std::chrono::duration<double> > time_budget_;
+    std::optional<size_t> target_cost_;
+    std::optional<size_t> no_improvement_iterations_;
+    std::optional< std::chrono::duration<double> > no_improvement_time_;
+    const std::atomic<bool>* cancel_flag_;
+
+    // Состояние текущего запуска
+    std::chrono::steady_clock::time_point start_;
+    std::chrono::steady_clock::time_point last_improvement_time_;
+    size_t last_improvement_iteration_;
+    size_t best_cost_;
+    StopReason reason_;
+
+public:
+
+    CStoppingCriteria();
+
+    CStoppingCriteria& SetIterationLimit(size_t iteration_limit);
+    CStoppingCriteria& SetTimeBudget(double seconds);
+    // Остановиться, когда лучшая оценка не больше target_cost
+    CStoppingCriteria& SetTargetCost(size_t target_cost);
+    CStoppingCriteria& SetNoImprovementIterations(size_t iterations);
+    CStoppingCriteria& SetNoImprovementTime(double seconds);
+    // Остановиться, когда *cancel_flag станет true. Флаг должен жить дольше оптимизатора.
+    CStoppingCriteria& SetCancelFlag(const std::atomic<bool>* cancel_flag);
+
+    // Предел итераций или 0, если он не задан ( для отчетов о ходе работы )
+    size_t GetIterationLimit() const;
+    // Причина последней остановки
+    StopReason GetReason() const;
+
+    // Начать отсчет времени и итераций без улучшения. При продолжении с контрольной точки передаются итерация
+    // и время, уже отработанные до нее: предел итераций и бюджет времени считаются от начала всей работы.
+    void Start(size_t best_cost, size_t iteration = 0, double elapsed_seconds = 0);
+    // true, если нужно остановиться перед итерацией iteration при лучшей оценке best_cost. Причина -- GetReason().
+    bool ShouldStop(size_t iteration, size_t best_cost);
+
+};
+
+#endif //TIMER_CSTOPPINGCRITERIA_H
@@ -13,7 +13,14 @@
 #include <map>
 #include "CTeacher.h"
 #include "CGroup.h"
+#include "CConflictGraph.h"
+#include "COccupancy.h"
 #include "ServiceFunctions.h"
+#include "CPoolAllocator.h"
+
+// Множество кабинетов предмета или события. Узлы берутся из пула потока ( CPoolAllocator ): множества кабинетов
+// событий создаются и копируются при каждой проверке перестановки и переноса.
+using CCabinetSet = std::set<const CCabinet *const, Comparator<CCabinet>, CPoolAllocator<const CCabinet *const>>;
 
 //______________________________________________________________________________________________________________________
 class CSubject {
@@ -23,30 +30,49 @@ private:
     // вспомогательный класс CSubjectBuilder ( метод Build )
     CSubject( std::string name,
               size_t id,
+              size_t index,
+              size_t lesson,
+              size_t copy_index,
               size_t difficulty_rating,
               size_t duration,
               size_t required_cabinets_number,
               int64_t feasible_time_,
-              const std::set<CTeacher *const, Comparator<CTeacher>>& teachers,
-              const std::set<CGroup *const, Comparator<CGroup>>& groups,
-              const std::set<CCabinet *const, Comparator<CCabinet>>& cabinets,
+              int64_t start_domain,
+              const std::set<const CTeacher *const, Comparator<CTeacher>>& teachers,
+              const std::set<const CGroup *const, Comparator<CGroup>>& groups,
+              const CCabinetSet& cabinets,
               size_t total_participants );
 
     const std::string name_;
     const size_t id_;
+    // Порядковый номер предмета в расписании. В отличие от id_, уникален для каждого предмета
+    const size_t index_;
+    // Урок, копией которого является предмет. Копии одного урока ( одинаковые id, учителя, группы, кабинеты,
+    // длительность и допустимое время ) взаимозаменяемы, поэтому генератор не перебирает их перестановки,
+    // а операторы окрестности не меняют их местами.
+    const size_t lesson_;
+    const size_t copy_index_;
     const size_t difficulty_rating_;
     const size_t duration_;
     const size_t required_cabinets_number_;
     const int64_t feasible_time_;
-    const std::set<CTeacher *const, Comparator<CTeacher>> teachers_;
-    const std::set<CGroup *const, Comparator<CGroup>> groups_;
-    const std::set<CCabinet *const, Comparator<CCabinet>> cabinets_;
+    // Времена начала, оставшиеся после распространения ограничений ( CTimeTableBuilder::PropagateDomains )
+    const int64_t start_domain_;
+    const std::set<const CTeacher *const, Comparator<CTeacher>> teachers_;
+    const std::set<const CGroup *const, Comparator<CGroup>> groups_;
+    const CCabinetSet cabinets_;
     const size_t total_participants_;
 
 public:
 
-    std::string GetName() const;
+    const std::string& GetName() const;
     size_t GetId() const;
+    size_t GetIndex() const;
+    size_t GetLesson() const;
+    size_t GetCopyIndex() const;
+    // true, если предметы -- взаимозаменяемые копии одного урока
+    bool IsCopyOf(const CSubject& other) const;
+    size_t GetDifficultyRating() const;
     size_t GetDuration() const;
     size_t GetRequiredCabinetsNumber() const;
     size_t GetParticipantsNumber() const;
@@ -54,16 +80,17 @@ public:
     const auto& GetGroups() const;
     const auto& GetTeachers() const;
     const auto& GetCabinets() const;
+    // Свободное время по начальному свободному времени учителей и групп. Занятость в конкретном расписании
+    // учитывает COccupancy.
     int64_t GetAvailableTime() const;
 
     int64_t GetFeasibleTime() const;
+    int64_t GetStartDomain() const;
     int64_t GetAvailableStartTime( size_t days_in_week, size_t lessons_in_day ) const;
+    // Времена начала при свободном времени available_time
+    int64_t GetAvailableStartTime( int64_t available_time, size_t days_in_week, size_t lessons_in_day ) const;
     int64_t GetGroupAvailableTime() const;
     int64_t GetTeachersAvailableTime() const;
-    size_t GetTeachersAvailableTimeSize() const;
-
-    void ReserveTime(size_t start_time);
-    void ReleaseTime(size_t start_time);
 
     friend class CSubjectBuilder;
 
@@ -78,26 +105,35 @@ private:
 
     std::string name_;
     size_t id_;
+    size_t index_ = 0;
+    size_t lesson_ = 0;
+    size_t copy_index_ = 0;
     size_t difficulty_rating_;
     size_t duration_;
     size_t required_cabinets_number_;
     int64_t feasible_time_;
-    std::set<CTeacher *const, Comparator<CTeacher>> teachers_;
-    std::set<CGroup *const, Comparator<CGroup>> groups_;
-    std::set<CCabinet *const, Comparator<CCabinet>> cabinets_;
+    int64_t start_domain_ = ~static_cast<int64_t>(0);
+    std::set<const CTeacher *const, Comparator<CTeacher>> teachers_;
+    std::set<const CGroup *const, Comparator<CGroup>> groups_;
+    CCabinetSet cabinets_;
     size_t total_participants_;
 
 public:
 
     void SetSubjectName(std::string name);
     void SetSubjectId(size_t id);
+    void SetSubjectIndex(size_t index);
+    void SetSubjectLesson(size_t lesson, size_t copy_index);
+    // Взять все поля, кроме имени и порядкового номера, у существующего предмета
+    void SetFromSubject(const CSubject& subject);
     void SetSubjectDifficultyRating(size_t difficulty_rating);
     void SetSubjectDuration(size_t duration);
     void SetRequiredCabinetNumber(size_t required_cabinets_number);
     void SetFeasibleTime(int64_t feasible_time);
-    void SetSubjectTeachers(std::set<CTeacher *const, Comparator<CTeacher>> teachers);
-    void SetSubjectGroups(std::set<CGroup *const, Comparator<CGroup>> groups);
-    void SetSubjectCabinets(std::set<CCabinet *const, Comparator<CCabinet>> cabinets);
+    void SetStartDomain(int64_t start_domain);
+    void SetSubjectTeachers(std::set<const CTeacher *const, Comparator<CTeacher>> teachers);
+    void SetSubjectGroups(std::set<const CGroup *const, Comparator<CGroup>> groups);
+    void SetSubjectCabinets(CCabinetSet cabinets);
 
     CSubject Build() const;
 
@@ -105,9 +141,26 @@ public:
 
 // Отношение порядка на множестве предметов -- мощность множества доступных времен начала
 //______________________________________________________________________________________________________________________
+// ( при равенстве раньше идут предметы с большей степенью в графе конфликтов, если он задан,
+//   затем копии одного урока в порядке номеров копий )
+//______________________________________________________________________________________________________________________
 struct SubjectComporator {
+    // Занятость расписания, по которой считается свободное время предметов
+    const COccupancy* occupancy;
+    const CConflictGraph* conflict_graph = nullptr;
+
     bool operator() (const CSubject* a, const CSubject* b) const {
-        return a->GetTeachersAvailableTimeSize() < b->GetTeachersAvailableTimeSize();
+        size_t a_size = occupancy->GetSubjectAvailableTimeSize(a);
+        size_t b_size = occupancy->GetSubjectAvailableTimeSize(b);
+        if (a_size != b_size)
+            return a_size < b_size;
+        if ( conflict_graph ) {
+            size_t a_degree = conflict_graph->GetDegree(a->GetIndex());
+            size_t b_degree = conflict_graph->GetDegree(b->GetIndex());
+            if (a_degree != b_degree)
+                return a_degree > b_degree;
+        }
+        return a->GetCopyIndex() < b->GetCopyIndex();
     }
 };
 
@@ -119,29 +172,48 @@ struct SubjectComporator {
 class CTimeTableGeneratorSupporter {
 private:
 
-    std::vector<CSubject*> stack_;
-    std::multiset<CSubject *const, SubjectComporator> priority_queue_;
+    std::vector<const CSubject*> stack_;
+    // Узлы из пула потока: помощник создается заново при каждом повторном размещении ( Perturb, RuinAndRecreate )
+    std::multiset<const CSubject *const, SubjectComporator, CPoolAllocator<const CSubject *const>> priority_queue_;
     std::vector< std::vector<size_t> > times_stack_;
+    // Для каждого предмета в стеке -- маска уже перебранных и отброшенных времен начала
+    std::vector<int64_t> tried_times_stack_;
 
+    // Занятость расписания, для которого генерируется размещение
+    const COccupancy* occupancy_;
     size_t days_in_week_, lessons_in_day_;
     bool is_last_successful_;
+    // Маска разрешенных времен начала. Используется при повторном размещении части расписания
+    int64_t allowed_start_time_;
 
     // Переместить в очередь предмет с вершины стека
     void moveTopToQueue();
     // Push первого по приоритету элемента очереди в стек
     void moveMinToStack();
+    // Отбросить время начала на вершине стека времени предмета с вершины стека, запомнив его как перебранное
+    void popTime();
+    // Маска времен начала, которые не нужно перебирать для subject, так как они уже перебраны его копиями
+    int64_t copiesSymmetryMask(const CSubject* subject) const;
 
     // Произвести откат, занеся в вектор пары ( премет, время начала ), которые нужно удалить из расписания
-    void backTrack(std::vector< std::pair<CSubject *, size_t> >& subjects_to_delete);
+    void backTrack(std::vector< std::pair<const CSubject *, size_t> >& subjects_to_delete);
 
 public:
 
-    CTimeTableGeneratorSupporter( std::map< std::string,CSubject >& subjects,
-                                  size_t days_in_week, size_t lessons_in_day );
+    // conflict_graph, если задан, используется для порядка размещения ( см. SubjectComporator )
+    CTimeTableGeneratorSupporter( const std::map< std::string,CSubject >& subjects,
+                                  const COccupancy& occupancy,
+                                  size_t days_in_week, size_t lessons_in_day,
+                                  const CConflictGraph* conflict_graph = nullptr );
+    // Помощник для размещения только части предметов и только на времена начала из allowed_start_time
+    CTimeTableGeneratorSupporter( const std::vector<const CSubject*>& subjects, int64_t allowed_start_time,
+                                  const COccupancy& occupancy,
+                                  size_t days_in_week, size_t lessons_in_day,
+                                  const CConflictGraph* conflict_graph = nullptr );
 
     // Совершить очередную итерацию при генерации: или перенос из очереди в стек, если предыдущая итерация прошла
     // успешно, или совершить откат
-    void MakeIteration(std::vector< std::pair<CSubject *, size_t> >& subjects_to_delete);
+    void MakeIteration(std::vector< std::pair<const CSubject *, size_t> >& subjects_to_delete);
     // Поставить флаг, обозначающий неудачно выполненную итерацию: is_last_successful_ = false
     void SetFailureFlag();
     // Удачна ли предыдущая итерация
@@ -156,7 +228,7 @@ public:
     bool CurrentSubjectTimesStackEmpty() const;
 
     // Получить элемент с вершины стека предметов, т.е. текущий для размещения
-    CSubject *const GetCurrentSubject() const;
+    const CSubject *const GetCurrentSubject() const;
     size_t GetCurrentSubjectStartTime() const;
 
 };
@@ -0,0 +1,74 @@
+#ifndef TIMER_CTABUOPTIMIZER_H
+#define TIMER_CTABUOPTIMIZER_H
+
+#include "CTimeTable.h"
+#include "CObjectiveFunction.h"
+#include "CProgress.h"
+#include "CStoppingCriteria.h"
+#include <chrono>
+#include <random>
+#include <unordered_map>
+
+// Оптимизатор методом поиска с запретами. На каждой итерации строится случайная выборка соседей текущего решения
+// ( CTimeTable::RandomSwap, CTimeTable::RandomMove ), из которой выбирается лучший незапрещенный сосед.
+// Запрещенными считаются возвраты предмета на время начала, с которого он недавно был перенесен. Запрет снимается,
+// если сосед лучше лучшего найденного решения ( критерий стремления ).
+//______________________________________________________________________________________________________________________
+class CTabuOptimizer {
+protected:
+
+    std::pair<CTimeTable, size_t> current_solution_;
+    std::pair<CTimeTable, size_t> current_best_solution_;
+
+    // Заготовки для соседей и их атрибутов. Переиспользуются между итерациями, поэтому шаг не выделяет память
+    CTimeTable candidate_;
+    std::vector<MoveAttribute> candidate_attributes_;
+    std::pair<CTimeTable, size_t> best_candidate_;
+    std::vector<MoveAttribute> best_candidate_attributes_;
+
+    // Количество соседей, просматриваемых за итерацию
+    size_t candidates_number_;
+    // Количество итераций, в течение которых атрибут остается запрещенным
+    size_t tabu_tenure_;
+    // Условия остановки; по умолчанию -- maximum_iteration_number итераций или time_budget_seconds секунд
+    CStoppingCriteria stopping_criteria_;
+
+    // Список запретов: ( порядковый номер предмета, время начала ) -> номер итерации, до которой действует запрет.
+    // Ключ -- subject_index * time_slots_number_ + start_time, поэтому проверка и запись за O(1).
+    std::unordered_map<size_t, size_t> tabu_list_;
+    size_t time_slots_number_;
+    size_t iteration_;
+    // Количество вычислений функции ошибки и итераций, на которых произошел переход
+    size_t evaluations_number_;
+    size_t moves_number_;
+
+    CObjectiveFunction cost_function_;
+    std::mt19937 random_generator_;
+    CProgressReporter progress_;
+
+    size_t attributeKey(size_t subject_index, size_t start_time) const;
+    bool isTabu(const std::vector<MoveAttribute>& attributes) const;
+    void makeTabu(const std::vector<MoveAttribute>& attributes);
+
+    void makeStep();
+    ProgressCounters progressCounters() const;
+
+public:
+
+    CTabuOptimizer( CTimeTable& timetable, size_t candidates_number, size_t tabu_tenure,
+                    size_t maximum_iteration_number, double time_budget_seconds );
+
+    void FindOptimal();
+    auto GetCurrentBestSolution();
+    // Отправлять отчеты о ходе работы в sink не чаще раза в interval_seconds ( по умолчанию -- в консоль раз в
+    // секунду ). nullptr отключает отчеты.
+    void SetProgressSink(std::shared_ptr<CProgressSink> sink, double interval_seconds);
+    // Заменить условия остановки, заданные конструктором ( предел итераций и времени )
+    void SetStoppingCriteria(const CStoppingCriteria& stopping_criteria);
+    // Почему завершился последний FindOptimal
+    StopReason GetStopReason() const;
+
+};
+
+
+#endif //TIMER_CTABUOPTIMIZER_H
@@ -11,11 +11,11 @@ class CTeacher {
 private:
 
     const std::string name_;
+    // Плотный номер: позиция имени среди всех имен того же типа ( см. IndexByName )
+    size_t index_;
     const int64_t available_time_;
     const std::vector<size_t> time_rating_;
-    int64_t current_available_time_;
 
-    int cashed_current_available_time_size_;
 
 public:
 
@@ -25,13 +25,13 @@ public:
 
     CTeacher( const CTeacher& other ) = default;
 
-    std::string GetName() const;
+    const std::string& GetName() const;
+    size_t GetIndex() const;
     int64_t GetAvailableTime() const;
-    size_t GetAvailableTimeSize() const;
+    const std::vector<size_t>& GetTimeRating() const;
+
+    void SetIndex(size_t index);
 
-    void ReserveTime(size_t start_time, size_t duration);
-    void ReleaseTime(size_t start_time, size_t duration);
-    void RecoverTeacher();
 
 };
 
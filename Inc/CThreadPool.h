@@ -0,0 +1,59 @@
+#ifndef TIMER_CTHREADPOOL_H
+#define TIMER_CTHREADPOOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Пул потоков с общей очередью задач. Задачи выполняются по убыванию приоритета, с равным приоритетом -- в порядке
+// добавления, не больше threads_number одновременно. Деструктор дожидается всех добавленных задач.
+//______________________________________________________________________________________________________________________
+class CThreadPool {
+private:
+
+    // Ключ очереди -- ( приоритет, номер добавления )
+    using TaskKey = std::pair<int, size_t>;
+
+    // Порядок запуска: по убыванию приоритета, с равным приоритетом -- по возрастанию номера добавления. Приоритет
+    // сравнивается как есть: отрицание переполнилось бы на INT_MIN.
+    struct TaskOrder {
+        bool operator()( const TaskKey& first, const TaskKey& second ) const;
+    };
+
+    std::vector<std::thread> workers_;
+    // Первой идет следующая задача
+    std::map< TaskKey, std::function<void()>, TaskOrder > tasks_;
+    size_t submitted_;
+
+    std::mutex mutex_;
+    std::condition_variable task_added_;
+    std::condition_variable task_finished_;
+    // Выполняемые сейчас задачи
+    size_t active_tasks_;
+    bool stopping_;
+
+    void work();
+
+public:
+
+    explicit CThreadPool(size_t threads_number = std::thread::hardware_concurrency());
+    ~CThreadPool();
+
+    CThreadPool( const CThreadPool& ) = delete;
+    CThreadPool& operator=( const CThreadPool& ) = delete;
+
+    // Задача не должна выбрасывать исключения: их некому перехватить
+    // Начатые задачи не прерываются задачами с большим приоритетом.
+    void Submit(std::function<void()> task, int priority = 0);
+    // Дождаться, пока очередь опустеет и все задачи завершатся
+    void Wait();
+
+    size_t GetThreadsNumber() const;
+
+};
+
+#endif //TIMER_CTHREADPOOL_H
@@ -9,61 +9,123 @@
 #include "CCabinet.h"
 #include "CGroup.h"
 #include "CEvent.h"
+#include "CConflictGraph.h"
+#include "COccupancy.h"
+#include "CProblemInstance.h"
+#include "CTrace.h"
+#include <istream>
+#include <memory>
+#include <ostream>
 
 class CTimeTableBuilder;
 class CTimeTableGeneratorSupporter;
+struct CNeighbourhoodOrder;
+
+// Атрибут перемещения: предмет с порядковым номером subject_index перенесен со времени from_time на время to_time.
+// Заполняется операторами окрестности ( RandomSwap, RandomMove, RandomKempeSwap ), используется для запретов в CTabuOptimizer.
+//______________________________________________________________________________________________________________________
+struct MoveAttribute {
+    size_t subject_index;
+    size_t from_time;
+    size_t to_time;
+};
+
+// Счетчики генератора: откаты ( неудачные размещения предмета ) и перезапуски генерации с нуля.
+// Заполняются CTimeTable::GenerateTimeTable и CTimeTable::Perturb, если им передан указатель.
+struct GeneratorStats {
+    size_t backtracks = 0;
+    size_t restarts = 0;
+};
+
+// Что удаляется из расписания в CTimeTable::RuinAndRecreate
+enum class RuinType {
+    // Все события случайного дня
+    Day,
+    // Все уроки случайного учителя
+    Teacher,
+    // Неделя случайной группы
+    Group
+};
 
 // Основной класс, содержащий само расписание,
 // данные о группах, кабинетах, учителях, предметах, времени на неделе,
 // обладающий интерфейсы для работы с классами оптимизации :
-// GenerateTimeTable, RandomSwap, RandomMove.
+// GenerateTimeTable, RandomSwap, RandomMove, RandomKempeSwap.
 //______________________________________________________________________________________________________________________
 class CTimeTable {
 private:
 
-    // Данные для построения расписсания.
-    // Каждая копия CTimeTable хранит свои данные,
-    // так как при построении происходит оперирование с указателями на данные.
-    std::map< std::string, CTeacher > teachers_;
-    std::map< std::string, CCabinet > cabinets_;
-    std::map< std::string, CGroup > groups_;
-
-    std::map< std::string, CSubject > subjects_;
+    // Неизменяемые данные задачи ( учителя, кабинеты, группы, предметы, граф конфликтов ).
+    // Не меняются после построения, поэтому общие для всех копий расписания.
+    std::shared_ptr<const CProblemInstance> problem_;
 
     size_t days_in_week_, lessons_in_day_;
 
-    // Само расписание: Группа x N -> Событие
-    std::map< std::string, std::vector<CEvent> > time_table_;
+    // Занятое время участников. Единственное, что меняется при построении расписания, кроме самих событий.
+    COccupancy occupancy_;
+
+    // Само расписание: Номер группы x N -> Событие
+    std::vector< std::vector<CEvent> > time_table_;
 
     // Специальный объект для связи событий, представляющих копии одних и тех же предметов.
     CEventLinker event_linker_;
 
+    // Время -> битсет предметов, события которых идут в это время ( строки графа конфликтов ). Позволяет отбросить
+    // перестановку или перенос, конфликтующие по учителю или группе, без изменения расписания.
+    std::vector<CConflictGraph::Row> slot_subjects_;
+    // Рабочий битсет conflictsAt, чтобы проверка не обращалась к куче
+    CConflictGraph::Row conflicts_row_;
+
     // Конструктор недоступен. Для создания используется
     // вспомогательный класс CTimeTableBuilder ( метод Build )
     CTimeTable( std::map< std::string, CTeacher >& teachers,
                 std::map< std::string, CCabinet >& cabinets,
                 std::map< std::string, CGroup >& groups,
                 std::map< std::string, CSubject >& subjects,
+                std::shared_ptr<const CConflictGraph> conflict_graph,
                 size_t days_in_week, size_t lessons_in_day );
 
+    // Занести в связыватель все события расписания ( после копирования time_table_ )
+    void linkEvents();
+
     // Добавить событие в расписание ( предмет в указанное время в указанных(ом) кабинетах(те) ).
     // При добавлении, время, занимаемое событием, блокируется у всех участников, т.е. учителей,
     // групп и классов.
-    void insertEvent( CSubject *const subject,
-                      const std::set<CCabinet *const, Comparator<CCabinet>>& cabinets,
+    void insertEvent( const CSubject *const subject,
+                      const CCabinetSet& cabinets,
                       size_t start_time );
     // Удалить событие в расписание ( предмет в указанное время ).
     // При удалении, время, занимаемое событием, освобождается у всех участников, т.е. учителей,
     // групп и классов.
-    void deleteEvent( CSubject *const subject,
+    void deleteEvent( const CSubject *const subject,
                       size_t start_time );
 
     // Найти подходящий кабинет по состоянию помощника (CTimeTableGeneratorSupporter).
     // В качестве предмета берется предмет на вершине стека предметов,
     // в качестве времени -- время на вершине стека времени.
-    auto findFeasibleCabinet( CTimeTableGeneratorSupporter& supporter ) const;
+    // Если жадно кабинеты не находятся, кабинеты уже размещенных событий перераспределяются ( reassignCabinets ).
+    // Если moved_events не nullptr, в него добавляются пересаженные события с их прежними кабинетами.
+    auto findFeasibleCabinet( CTimeTableGeneratorSupporter& supporter, std::vector<CEvent>* moved_events = nullptr );
     // Найти кабинет непосредственно для предмета subject с началом в start_time.
-    auto findFeasibleCabinet( CSubject* subject, size_t start_time ) const;
+    auto findFeasibleCabinet( const CSubject* subject, size_t start_time ) const;
+    // true, если для предмета subject с началом в start_time свободно нужное количество кабинетов. То же, что
+    // findFeasibleCabinet, но без построения множества.
+    bool hasFeasibleCabinets( const CSubject* subject, size_t start_time ) const;
+    // Найти кабинеты для предмета subject с началом в start_time, перераспределив кабинеты событий, пересекающихся
+    // с ним по времени и претендующих на те же кабинеты ( транзитивно ), паросочетанием в двудольном графе
+    // "требуемый кабинет события -- кабинет". true и кабинеты предмета в cabinets, если распределение существует,
+    // -- тогда события переносятся в новые кабинеты, а их копии с прежними кабинетами добавляются в moved_events
+    // ( если он не nullptr ). Иначе false, и расписание остается прежним.
+    bool reassignCabinets( const CSubject* subject, size_t start_time,
+                           CCabinetSet& cabinets, std::vector<CEvent>* moved_events = nullptr );
+
+    // true, если предмет subject с началом в start_time пересекся бы по учителю или группе с событием, идущим в это
+    // время, кроме события предмета ignored ( nullptr -- без исключений ). Необходимое условие невозможности
+    // размещения: занятость участников и кабинеты при этом не проверяются.
+    bool conflictsAt( const CSubject* subject, size_t start_time, const CSubject* ignored );
+
+    // Случайные перестановки номеров групп и времен для RandomSwap, RandomMove, RandomKempeSwap
+    const CNeighbourhoodOrder& randomNeighbourhoodOrder() const;
 
     // true, если можно поменять местами события без нарушения коректности.
     // false, иначе.
@@ -83,6 +145,31 @@ private:
     // Перенести начало события на новое время. Проверка коректности не производится.
     bool move(const CEvent& from, size_t new_start_time);
 
+    // Разместить в расписании предметы из очереди помощника с откатами. false, если превышено max_iteration_count
+    // итераций, -- тогда часть предметов может остаться размещенной, и вызывающая сторона должна это исправить.
+    // Если stats не nullptr, в него добавляется количество откатов. Если moved_events не nullptr, в него добавляются
+    // уже стоявшие события, которым при размещении сменили кабинеты, с их прежними кабинетами.
+    bool placeSubjects( CTimeTableGeneratorSupporter& supporter, int max_iteration_count,
+                        GeneratorStats* stats = nullptr, std::vector<CEvent>* moved_events = nullptr );
+    // Собрать копии событий, относящихся к случайному дню, учителю или группе ( см. RuinType )
+    void collectEvents( RuinType ruin_type, std::vector<CEvent>& events ) const;
+    // Удалить из расписания события ruined_events и разместить их предметы заново генератором на времена начала из
+    // allowed_start_time. При неудаче события возвращаются на свои места и возвращается false.
+    bool recreateEvents( const std::vector<CEvent>& ruined_events, int64_t allowed_start_time,
+                         GeneratorStats* stats = nullptr );
+    // Собрать копии событий, начинающихся в start_time, по одному на предмет
+    void eventsStartingAt( size_t start_time, std::vector<CEvent>& events ) const;
+    // true, если у событий есть общий учитель, группа ( по графу конфликтов ) или кабинет
+    bool conflicting( const CEvent& first, const CEvent& second ) const;
+    // Построить цепь Кемпе для события event и времени other_time. false, если цепь содержит события, которые
+    // нельзя переносить целиком ( длительность больше единицы ).
+    bool kempeChain( const CEvent& event, size_t other_time, std::vector<CEvent>& chain ) const;
+    // Перенести события цепи с first_time на second_time и обратно. Если какое-то событие запрещено на новом
+    // времени масками доступности, расписание возвращается в исходное состояние и возвращается false.
+    bool kempeSwap( const std::vector<CEvent>& chain, size_t first_time, size_t second_time );
+    // Удалить из расписания события указанных предметов, если они в нем есть
+    void removeSubjects( const std::set<const CSubject*>& subjects );
+
     friend class CTimeTableGeneratorSupporter;
     friend class CTimeTableBuilder;
     friend class CObjectiveFunction;
@@ -92,14 +179,49 @@ public:
     CTimeTable(const CTimeTable& timetable);
     CTimeTable& operator=(const CTimeTable& timetable);
 
-    // Сгенерировать случайное корректное расписание
-    void GenerateTimeTable();
+    // Сгенерировать случайное корректное расписание. Если stats не nullptr, в него добавляются откаты и перезапуски.
+    void GenerateTimeTable( GeneratorStats* stats = nullptr );
     // Восстановить состояние объекта к начальному
     void RecoverTimeTable();
-    // Произвести случайную перестановку случайных объектов без потери коректности
-    void RandomSwap();
-    // Произвести случайный перенос случайного события на случайное новое время
-    void RandomMove();
+    // Удалить часть расписания ( день, учителя или группу ) и разместить удаленные предметы заново генератором,
+    // разрешая только освободившиеся времена начала. При неудаче расписание возвращается в исходное состояние и
+    // возвращается false.
+    bool RuinAndRecreate(RuinType ruin_type);
+    // Удалить долю fraction случайных событий и разместить их заново на любые времена. При неудаче расписание
+    // возвращается в исходное состояние и возвращается false. Если stats не nullptr, в него добавляются откаты.
+    // Списки событий здесь и в RuinAndRecreate берутся из буферов потока, но генератор выделяет память при каждом
+    // вызове: перестановка времен начала на каждый размещаемый предмет, стеки помощника и исключения откатов.
+    bool Perturb( double fraction, GeneratorStats* stats = nullptr );
+    // Произвести случайную перестановку случайных объектов без потери коректности.
+    // Возвращает false, если переставить нечего. Если attributes не nullptr, в него добавляются атрибуты перемещений.
+    // Если rejected не nullptr, к нему прибавляется количество проверенных и отвергнутых кандидатов ( здесь и в
+    // RandomMove, RandomKempeSwap ).
+    bool RandomSwap( std::vector<MoveAttribute>* attributes = nullptr, size_t* rejected = nullptr );
+    // Произвести случайный перенос случайного события на случайное новое время.
+    // Возвращает false, если перенести нечего. Если attributes не nullptr, в него добавляются атрибуты перемещений.
+    bool RandomMove( std::vector<MoveAttribute>* attributes = nullptr, size_t* rejected = nullptr );
+    // Поменять местами два времени для цепи Кемпе случайного события, т.е. для всех событий этих времен, связанных
+    // с ним через общих учителей, группы и кабинеты. Возвращает false, если подходящей цепи не нашлось.
+    bool RandomKempeSwap( std::vector<MoveAttribute>* attributes = nullptr, size_t* rejected = nullptr );
+
+    size_t GetTimeSlotsNumber() const;
+    // Количество нарушений корректности: учитель или кабинет заняты двумя событиями в одно время, событие
+    // отсутствует у одной из своих групп. 0 у корректного расписания. Для проверок, не для оптимизации.
+    size_t CountConflicts() const;
+    const CConflictGraph& GetConflictGraph() const;
+    const COccupancy& GetOccupancy() const;
+
+    // Перенести в расписание события из part -- расписания части задачи с теми же именами учителей, групп,
+    // кабинетов и предметов. Проверка на коректность не производится.
+    void ImportEvents(const CTimeTable& part);
+
+    // Записать события расписания в двоичном виде: предмет, время начала и кабинеты по номерам. Данные задачи не
+    // записываются, только их отпечаток -- Load читает в расписание той же задачи.
+    void Save(std::ostream& stream) const;
+    // Заменить события расписания прочитанными из stream. Выкидывает CBadCheckpoint, если запись повреждена, сделана
+    // для другой задачи, содержит не все предметы или повторяет какой-то из них, или если ее события занимают
+    // одного учителя, группу или кабинет одновременно.
+    void Load(std::istream& stream);
 
     // Получить ссылку на событие группы group_name во время start_time
     const CEvent& GetEvent(std::string group_name, size_t start_time) const;
@@ -126,9 +248,29 @@ private:
     std::map< std::string, CCabinet > cabinets_;
     std::map< std::string, CGroup > groups_;
     std::map< std::string, CSubject > subjects_;
+    // Количество уроков в неделю для каждой строки файла предметов
+    std::map< std::string, size_t > lessons_per_week_;
 
     size_t days_in_week_, lessons_in_day_;
 
+    // Замечания к входным файлам, не мешающие построению ( например, повторяющиеся имена )
+    std::vector<std::string> warnings_;
+
+    // CheckFeasibility и PropagateDomains уже выполнены для текущих данных. Сбрасывается всеми SetTimeTable*.
+    bool analysed_ = false;
+
+    // Проверить и сузить задачу ( CheckFeasibility, PropagateDomains ), если это еще не сделано для текущих данных
+    void analyse();
+
+    // Раскрыть уроки, проводимые несколько раз в неделю, в отдельные предметы-копии. Выкидывает CParseError, если
+    // имя копии совпало с именем другого предмета.
+    void expandLessons(const std::string& subjects_filename);
+    // Найти взаимозаменяемые предметы и пронумеровать их как копии одного урока
+    void assignLessons();
+    // Построить граф конфликтов предметов subjects. Номер вершины -- позиция предмета в subjects, она же
+    // его порядковый номер в построенном CTimeTable.
+    static std::shared_ptr<const CConflictGraph> buildConflictGraph( const std::map< std::string, CSubject >& subjects );
+
 public:
 
     void SetTimeTableTeachers(std::string teachers_filename);
@@ -136,8 +278,39 @@ public:
     void SetTimeTableGroups(std::string groups_filename);
     void SetTimeTableSubjects(std::string subjects_filename);
     void SetTimeTableSize(size_t days_in_week, size_t lessons_in_day);
+    // Предупреждения SetTimeTable* в формате file:line:column: message. Ошибки во входных файлах ( неверное
+    // количество полей, не число, неизвестное имя учителя, группы или кабинета ) выкидываются как CParseError.
+    const std::vector<std::string>& GetWarnings() const;
+    // Количество предметов с раскрытыми копиями уроков, т.е. сумма по компонентам BuildComponents
+    size_t GetSubjectsNumber() const;
+
+    // Записать прочитанную задачу ( после всех SetTimeTable* ) в двоичный файл: учителя, группы, кабинеты и предметы
+    // с уже раскрытыми копиями уроков, связи -- плотными номерами. Порядок байтов -- машины, на которой записан файл.
+    void CompileInstance(const std::string& instance_filename) const;
+    // Заменить все SetTimeTable* чтением файла CompileInstance: файл отображается в память и читается без разбора
+    // текста и поиска имен. Выкидывает CBadInstance, если файл поврежден или другой версии, если в неделе не от 1 до 63
+    // уроков, или если у предмета длина не от 1 до числа уроков в дне, нет групп или кабинетов меньше требуемого.
+    void SetTimeTableInstance(const std::string& instance_filename);
+
+    // Быстрая проверка необходимых условий существования расписания: часы учителей и групп против их свободного
+    // времени, наличие времени начала и вместительного кабинета у каждого предмета, паросочетание
+    // ( предмет, кабинет ) x ( кабинет, время ). Выкидывает CInfeasibleTimeTable со списком всех нарушений.
+    // Вызывается из Build и BuildComponents один раз после последнего SetTimeTable*.
+    void CheckFeasibility() const;
+    // Сузить множества допустимых времен начала предметов до генерации: убрать времена, на которые не хватает
+    // вместительных свободных кабинетов, и времена, занятые у учителей и групп предметами, у которых осталось
+    // единственное время начала ( такие предметы фиксируются, вместе с кабинетами, если выбора кабинетов нет ).
+    // Повторяется до неподвижной точки. Выкидывает CInfeasibleTimeTable, если у предмета не осталось времен.
+    // Вызывается из Build и BuildComponents один раз после последнего SetTimeTable*.
+    void PropagateDomains();
 
     CTimeTable Build();
+    // Разбить задачу на компоненты связности: предметы связаны, если у них есть общий учитель, группа или
+    // возможный кабинет. Компоненты не влияют друг на друга ни через ограничения, ни через функцию ошибки, поэтому
+    // их можно решать независимо. Каждая компонента -- отдельный CTimeTable со своими учителями, группами и кабинетами.
+    std::vector<CTimeTable> BuildComponents();
+    // Собрать общее расписание из решенных компонент, полученных BuildComponents
+    CTimeTable Merge(const std::vector<CTimeTable>& components);
 
 };
 
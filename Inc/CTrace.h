@@ -0,0 +1,94 @@
+#ifndef TIMER_CTRACE_H
+#define TIMER_CTRACE_H
+
+#include "Defines.h"
+
+// Трассировка в формате Chrome trace-event ( JSON, открывается в Perfetto или chrome://tracing ). Каждый поток --
+// отдельная дорожка. Включается определением TIMER_TRACE ( см. Defines.h ), без него TRACE_SCOPE и TRACE_WRITE
+// ничего не делают и в код не попадают.
+//
+//     TRACE_SCOPE("GenerateTimeTable");      // интервал от этой строки до конца блока
+//     TRACE_WRITE("trace.json");             // записать все завершенные интервалы
+#ifdef TIMER_TRACE
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Завершенный интервал. Время в микросекундах от создания CTracer.
+struct TraceEvent {
+    const char* name;
+    int64_t start;
+    int64_t duration;
+};
+
+// Интервалы одного потока. Пишутся без блокировок, в общий список переносятся при завершении потока или записи.
+struct TraceBuffer {
+    size_t lane;
+    std::vector<TraceEvent> events;
+
+    TraceBuffer();
+    ~TraceBuffer();
+};
+
+//______________________________________________________________________________________________________________________
+class CTracer {
+private:
+
+    std::mutex mutex_;
+    // Интервалы завершившихся потоков: дорожка x интервал
+    std::vector< std::pair<size_t, TraceEvent> > events_;
+    size_t lanes_number_;
+    const std::chrono::steady_clock::time_point origin_;
+
+    CTracer();
+
+    void merge(TraceBuffer& buffer);
+
+    friend struct TraceBuffer;
+
+public:
+
+    static CTracer& Instance();
+    // Интервалы текущего потока
+    static TraceBuffer& ThreadBuffer();
+
+    int64_t Now() const;
+
+    // Записать интервалы всех завершившихся потоков и текущего потока в файл filename
+    void Write(const std::string& filename);
+
+};
+
+// Интервал от создания до уничтожения объекта. name должен жить до записи трассы ( строковый литерал ).
+//______________________________________________________________________________________________________________________
+class CTraceScope {
+private:
+
+    const char* name_;
+    int64_t start_;
+
+public:
+
+    explicit CTraceScope(const char* name);
+    ~CTraceScope();
+
+    CTraceScope(const CTraceScope&) = delete;
+    CTraceScope& operator=(const CTraceScope&) = delete;
+
+};
+
+#define TRACE_CONCAT_IMPL(first, second) first##second
+#define TRACE_CONCAT(first, second) TRACE_CONCAT_IMPL(first, second)
+#define TRACE_SCOPE(name) CTraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#define TRACE_WRITE(filename) CTracer::Instance().Write(filename)
+
+#else
+
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_WRITE(filename) ((void)0)
+
+#endif //TIMER_TRACE
+
+#endif //TIMER_CTRACE_H
@@ -0,0 +1,117 @@
+#ifndef TIMER_CWEEKGEOMETRY_H
+#define TIMER_CWEEKGEOMETRY_H
+
+#include <array>
+#include <cstdint>
+#include "Defines.h"
+
+// Маски времени, не зависящие от размера недели: DURATION_MASKS[duration] -- duration подряд идущих единиц,
+// начиная с младшего бита.
+//______________________________________________________________________________________________________________________
+constexpr std::array<int64_t, INT64_SIZE> MakeDurationMasks() {
+    std::array<int64_t, INT64_SIZE> masks {};
+    for (size_t duration = 1; duration < INT64_SIZE; duration++)
+        masks[duration] = (masks[duration - 1] << 1) | 1;
+    return masks;
+}
+
+constexpr std::array<int64_t, INT64_SIZE> DURATION_MASKS = MakeDurationMasks();
+
+// Маска времени длины duration, начинающегося в start_time
+constexpr int64_t TimeMask(size_t start_time, size_t duration) {
+    return DURATION_MASKS[duration] << start_time;
+}
+
+// Размер недели, известный во время компиляции. Все маски -- constexpr таблицы, циклы по дням и урокам
+// имеют постоянные границы.
+// DAY_MASKS[day] -- все уроки дня day,
+// START_MASKS[duration] -- времена, с которых предмет длины duration помещается в день до его конца.
+//______________________________________________________________________________________________________________________
+template <size_t Days, size_t Lessons>
+class CWeekGeometry {
+private:
+
+    static constexpr std::array<int64_t, Days> makeDayMasks() {
+        std::array<int64_t, Days> masks {};
+        for (size_t day = 0; day < Days; day++)
+            masks[day] = DURATION_MASKS[Lessons] << (day * Lessons);
+        return masks;
+    }
+
+    static constexpr std::array<int64_t, Lessons + 1> makeStartMasks() {
+        std::array<int64_t, Lessons + 1> masks {};
+        for (size_t duration = 1; duration <= Lessons; duration++)
+            for (size_t day = 0; day < Days; day++)
+                masks[duration] |= DURATION_MASKS[Lessons - duration + 1] << (day * Lessons);
+        return masks;
+    }
+
+public:
+
+    static_assert(Days * Lessons < INT64_SIZE, "Week does not fit into int64_t mask");
+
+    static constexpr std::array<int64_t, Days> DAY_MASKS = makeDayMasks();
+    static constexpr std::array<int64_t, Lessons + 1> START_MASKS = makeStartMasks();
+
+    static constexpr size_t DaysInWeek() { return Days; }
+    static constexpr size_t LessonsInDay() { return Lessons; }
+    static constexpr size_t TimeSlotsNumber() { return Days * Lessons; }
+    static constexpr int64_t StartMask(size_t duration) {
+        return duration <= Lessons ? START_MASKS[duration] : 0;
+    }
+
+};
+
+// Размер недели, известный только во время выполнения. Тот же интерфейс, что у CWeekGeometry, маски считаются на
+// месте. Используется для редких размеров недели, для которых нет специализации в DispatchWeekGeometry.
+//______________________________________________________________________________________________________________________
+class CRuntimeWeekGeometry {
+private:
+
+    size_t days_in_week_, lessons_in_day_;
+
+public:
+
+    CRuntimeWeekGeometry( size_t days_in_week, size_t lessons_in_day )
+            : days_in_week_(days_in_week), lessons_in_day_(lessons_in_day) {}
+
+    size_t DaysInWeek() const { return days_in_week_; }
+    size_t LessonsInDay() const { return lessons_in_day_; }
+    size_t TimeSlotsNumber() const { return days_in_week_ * lessons_in_day_; }
+    int64_t StartMask(size_t duration) const {
+        if ( duration > lessons_in_day_ )
+            return 0;
+        int64_t mask(0);
+        for (size_t day = 0; day < days_in_week_; day++)
+            mask |= DURATION_MASKS[lessons_in_day_ - duration + 1] << (day * lessons_in_day_);
+        return mask;
+    }
+
+};
+
+// Вызвать function с объектом размера недели: CWeekGeometry для частых размеров 5x7, 5x8, 6x7,
+// CRuntimeWeekGeometry для остальных
+//______________________________________________________________________________________________________________________
+template <class Function>
+decltype(auto) DispatchWeekGeometry( size_t days_in_week, size_t lessons_in_day, Function&& function ) {
+    if ( days_in_week == 5 && lessons_in_day == 7 )
+        return function( CWeekGeometry<5, 7>() );
+    if ( days_in_week == 5 && lessons_in_day == 8 )
+        return function( CWeekGeometry<5, 8>() );
+    if ( days_in_week == 6 && lessons_in_day == 7 )
+        return function( CWeekGeometry<6, 7>() );
+    return function( CRuntimeWeekGeometry(days_in_week, lessons_in_day) );
+}
+
+// Маска времен начала предмета длины duration, при которых он целиком попадает в свободное время available_time
+// и не выходит за конец дня
+//______________________________________________________________________________________________________________________
+template <class Geometry>
+int64_t AvailableStartTime( const Geometry& geometry, int64_t available_time, size_t duration ) {
+    int64_t start_time = geometry.StartMask(duration);
+    for (size_t shift = 0; shift < duration; shift++)
+        start_time &= available_time >> shift;
+    return start_time;
+}
+
+#endif //TIMER_CWEEKGEOMETRY_H
@@ -8,4 +8,7 @@
 #define INT64_SIZE 64
 #define NONCASHED -1
 
+// Трассировка в Chrome trace-event JSON ( CTrace.h ). Раскомментировать или собрать с -DTIMER_TRACE.
+// #define TIMER_TRACE
+
 #endif //TIMER_DEFINES_H
@@ -3,49 +3,179 @@
 //
 
 #include <vector>
+#include <map>
+#include <string>
 #include <random>
 #include <algorithm>
+#include <numeric>
+#include <istream>
+#include <ostream>
+#include <type_traits>
 
 #ifndef TIMER_SERVICEFUNCTIONS_H
 #define TIMER_SERVICEFUNCTIONS_H
 
-std::vector<size_t> RandomPermutation(int64_t time) {
-    std::vector<size_t> result;
-    result.reserve(sizeof(long long) * 8);
+// Генератор случайных чисел потока. Создается один раз: std::random_device на каждый вызов обходится дорого.
+std::mt19937& RandomGenerator() {
+    static thread_local std::mt19937 generator( std::random_device{}() );
+    return generator;
+}
+
+// Номера единичных битов time в случайном порядке. result переиспользуется, поэтому при достаточной емкости
+// обращения к куче нет.
+void RandomPermutation(int64_t time, std::vector<size_t>& result) {
+    result.clear();
 
     for ( int i = 0; i < sizeof(long long) * 8; i++ )
         if (time & (static_cast<int64_t>(1) << i))
             result.push_back(i);
 
-    std::random_device rd;
-    std::mt19937 g(rd());
+    std::shuffle(result.begin(), result.end(), RandomGenerator());
+}
 
-    std::shuffle(result.begin(), result.end(), g);
+std::vector<size_t> RandomPermutation(int64_t time) {
+    std::vector<size_t> result;
+    result.reserve(sizeof(long long) * 8);
+    RandomPermutation(time, result);
 
     return std::move(result);
-
 }
 
 template <typename T>
 void RandomPermutation(std::vector<T>& vec) {
+    std::shuffle(vec.begin(), vec.end(), RandomGenerator());
+}
 
-    std::random_device rd;
-    std::mt19937 g(rd());
+// Заполнить order числами [0, n) в случайном порядке, переиспользуя его память
+void RandomOrder(size_t n, std::vector<size_t>& order) {
+    order.resize(n);
+    std::iota(order.begin(), order.end(), 0);
+    RandomPermutation(order);
+}
+
+// Количество единичных битов
+size_t BitsNumber(int64_t mask) {
+    size_t counter(0);
+    for (uint64_t bits = static_cast<uint64_t>(mask); bits; bits &= bits - 1)
+        counter++;
+    return counter;
+}
 
-    std::shuffle(vec.begin(), vec.end(), g);
+// Номер младшего единичного бита ( mask != 0 )
+size_t BitScan(int64_t mask) {
+    size_t position(0);
+    while ( !((mask >> position) & 1) )
+        position++;
+    return position;
+}
+
+// Случайное число из [0, n)
+size_t RandomIndex(size_t n) {
+    std::uniform_int_distribution<size_t> distribution(0, n - 1);
 
+    return distribution(RandomGenerator());
 }
 
+// Порядок учителей, групп и кабинетов -- по плотным номерам, которые совпадают с порядком имен ( см. IndexByName )
 template <class T>
 struct Comparator {
     bool operator() (T *const a, T *const b) const {
-        return a->GetName() < b->GetName();
+        return a->GetIndex() < b->GetIndex();
     }
     bool operator() (const T *const a, const T *const b) const {
-        return a->GetName() < b->GetName();
+        return a->GetIndex() < b->GetIndex();
     }
 };
 
+// Пронумеровать объекты подряд в порядке имен. Номера используются как ключи вместо имен; имена остаются только для
+// ввода и вывода. Нумеровать можно только пока на объекты нет указателей в упорядоченных множествах.
+template <class T>
+void IndexByName(std::map<std::string, T>& entities) {
+    size_t index(0);
+    for (auto& [name, entity] : entities)
+        entity.SetIndex(index++);
+}
+
+// true, если у упорядоченных множеств есть общий элемент
+template <class Set>
+bool Intersects(const Set& first, const Set& second) {
+    auto first_it = first.begin();
+    auto second_it = second.begin();
+    auto compare = first.key_comp();
+
+    while ( first_it != first.end() && second_it != second.end() ) {
+        if ( compare(*first_it, *second_it) )
+            first_it++;
+        else if ( compare(*second_it, *first_it) )
+            second_it++;
+        else
+            return true;
+    }
+
+    return false;
+}
+
+// Поиск увеличивающей цепи в алгоритме Куна. adjacency -- списки смежности левой доли,
+// match -- для каждой вершины правой доли номер вершины левой доли или -1.
+bool FindAugmentingPath( size_t left, const std::vector< std::vector<size_t> >& adjacency,
+                         std::vector<int>& match, std::vector<bool>& visited ) {
+    for (size_t right : adjacency[left]) {
+        if ( visited[right] )
+            continue;
+        visited[right] = true;
+        if ( match[right] == -1 || FindAugmentingPath(match[right], adjacency, match, visited) ) {
+            match[right] = static_cast<int>(left);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Записать значение в двоичном виде ( байты как в памяти, т.е. в порядке байтов машины )
+template <class T>
+void WriteBinary(std::ostream& stream, const T& value) {
+    static_assert(std::is_trivially_copyable<T>::value, "only trivially copyable values are written as bytes");
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// Записать строку: длина uint32_t и байты
+void WriteBinaryString(std::ostream& stream, const std::string& str) {
+    WriteBinary<uint32_t>(stream, str.size());
+    stream.write(str.data(), str.size());
+}
+
+// Прочитать значение, записанное WriteBinary. Ошибку чтения вызывающая сторона проверяет по состоянию stream.
+template <class T>
+T ReadBinary(std::istream& stream) {
+    static_assert(std::is_trivially_copyable<T>::value, "only trivially copyable values are read as bytes");
+    T value {};
+    stream.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return value;
+}
+
+// Дописать байты value к хешу hash ( FNV-1a ). Начальное значение хеша -- FNV_OFFSET_BASIS.
+const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+
+void HashBytes(uint64_t& hash, const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+}
+
+template <class T>
+void HashValue(uint64_t& hash, const T& value) {
+    static_assert(std::is_trivially_copyable<T>::value, "only trivially copyable values are hashed as bytes");
+    HashBytes(hash, &value, sizeof(T));
+}
+
+// Длина хешируется вместе со строкой, чтобы "ab" + "c" и "a" + "bc" давали разный хеш
+void HashString(uint64_t& hash, const std::string& str) {
+    HashValue<uint64_t>(hash, str.size());
+    HashBytes(hash, str.data(), str.size());
+}
+
 int64_t Str2Int64(std::string str) {
     int64_t result(0);
 
@@ -6,6 +6,14 @@
 #define TIMER_TESTS_H
 
 #include "ServiceFunctions.h"
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <sys/stat.h>
+#include <thread>
 
 void StartGroupsTimeTests(const std::string& test_folder_path) {
 
@@ -126,15 +134,968 @@ void ReserveReleaseTimeTests(const std::string& test_folder_path) {
     auto& groups = table.GetSubject("Математика").GetGroups();
 
     auto& group = *groups.begin();
-    group->ReserveTime(3,3);
+    COccupancy occupancy = table.GetOccupancy();
+    occupancy.ReserveGroup(group, 3, 3);
 
-    assert(group->GetAvailableTime() == Str2Int64("1000111"));
+    assert(occupancy.GetGroupTime(group) == Str2Int64("1000111"));
     std::cout << "RESERVE  TIME  TEST  OK" << std::endl;
 
-    group->ReleaseTime(3,3);
+    occupancy.ReleaseGroup(group, 3, 3);
 
-    assert(group->GetAvailableTime() == Str2Int64("1111111"));
+    assert(occupancy.GetGroupTime(group) == Str2Int64("1111111"));
     std::cout << "RELEASE  TIME  TEST  OK" << std::endl;
 }
 
+// Прочитать задачу из папки folder
+void ReadTestInput(CTimeTableBuilder& table_builder, const std::string& folder) {
+    table_builder.SetTimeTableCabinets(folder + "cabinets.txt");
+    table_builder.SetTimeTableTeachers(folder + "teachers.txt");
+    table_builder.SetTimeTableGroups(folder + "groups.txt");
+    table_builder.SetTimeTableSubjects(folder + "subjects.txt");
+    table_builder.SetTimeTableSize(5, 7);
+}
+
+// Скопировать задачу из test_folder_path во временную папку name, дописав строки extra_* в соответствующие файлы.
+// Возвращает путь к копии.
+std::string MakeTestInput( const std::string& test_folder_path, const std::string& name,
+                           const std::string& extra_subjects, const std::string& extra_teachers = "",
+                           const std::string& extra_groups = "", const std::string& extra_cabinets = "" ) {
+    std::string folder = "/tmp/timer-test-" + name + "/";
+    mkdir(folder.c_str(), 0755);
+    const std::map<std::string, std::string> extra { {"teachers.txt", extra_teachers}, {"groups.txt", extra_groups},
+                                                     {"cabinets.txt", extra_cabinets}, {"subjects.txt", extra_subjects} };
+    for (const auto& [filename, lines] : extra) {
+        std::ifstream input(test_folder_path + filename, std::ios::binary);
+        std::ostringstream content;
+        content << input.rdbuf();
+        // Последняя строка исходного файла может быть без перевода строки
+        std::string text = content.str();
+        if ( !text.empty() && text.back() != '\n' && !lines.empty() )
+            text += '\n';
+        std::ofstream output(folder + filename, std::ios::binary);
+        output << text << lines;
+    }
+    return folder;
+}
+
+// Строки отдельной части школы для MakeTestInput: учителя ТестовыйА и ТестовыйБ, группа Тест-1 и кабинет 999,
+// свободные всю неделю 5x7. Предметы с ними не связаны с остальной задачей и образуют свою компоненту.
+const std::string TEST_WEEK_MASK(35, '1');
+
+std::string TestTeacherLine(const std::string& name) {
+    std::string line = name + " " + TEST_WEEK_MASK;
+    for (size_t time = 0; time < TEST_WEEK_MASK.size(); time++)
+        line += " 0";
+    return line + "\n";
+}
+
+const std::string TEST_TEACHERS = TestTeacherLine("ТестовыйА") + TestTeacherLine("ТестовыйБ");
+const std::string TEST_GROUPS = "Тест-1 20 " + TEST_WEEK_MASK + "\n";
+const std::string TEST_CABINETS = "999 30 " + TEST_WEEK_MASK + "\n";
+
+// Строка предмета отдельной части школы: один урок длины 1 в кабинете 999 с временем feasible_time
+std::string TestSubjectLine( const std::string& name, size_t id, const std::string& teacher,
+                             const std::string& feasible_time ) {
+    return name + " " + std::to_string(id) + " 1 1 1 " + feasible_time + " 1 " + teacher + " 1 Тест-1 1 999\n";
+}
+
+void LessonMultiplicityTests(const std::string& test_folder_path) {
+
+    CTimeTableBuilder table_builder;
+    ReadTestInput(table_builder, test_folder_path);
+    CTimeTable table = table_builder.Build();
+
+    // Физика-10А-1 и Физика-10А-2 записаны в 8-11 строками с одинаковыми полями -- это копии одного урока
+    assert(table.GetSubject("Физика-10А-1").IsCopyOf(table.GetSubject("Физика-10А-2")));
+    assert(!table.GetSubject("Физика-10А-1").IsCopyOf(table.GetSubject("Физика-11А-1")));
+    std::cout << "SAME  FIELDS  TEST  OK" << std::endl;
+
+    // Строка с lessons_per_week == 3 раскрывается в три копии
+    std::string folder = MakeTestInput( test_folder_path, "multiplicity",
+            "Тест-9А 17 4 1 1 11111111111111111111111111111111111 1 ЛяшенкоЮГ 1 9А 1 401 3\n" );
+    CTimeTableBuilder multiplicity_builder;
+    ReadTestInput(multiplicity_builder, folder);
+    CTimeTable multiplicity_table = multiplicity_builder.Build();
+    const CSubject& first = multiplicity_table.GetSubject("Тест-9А-1");
+    for (const std::string copy : {"Тест-9А-2", "Тест-9А-3"}) {
+        assert(multiplicity_table.GetSubject(copy).IsCopyOf(first));
+        assert(multiplicity_table.GetSubject(copy).GetCopyIndex() != first.GetCopyIndex());
+    }
+    std::cout << "LESSONS  PER  WEEK  TEST  OK" << std::endl;
+
+    // ФизРа-9А-1 записана в 8-11 тремя одинаковыми строками -- это три урока в неделю, копии одного урока
+    const CSubject& repeated = table.GetSubject("ФизРа-9А-1-1");
+    assert(table.GetSubject("ФизРа-9А-1-3").GetLesson() == repeated.GetLesson());
+    std::cout << "REPEATED  LINES  TEST  OK" << std::endl;
+
+    // Под тем же именем другой урок ( другой учитель ) -- ошибка, а не потерянная строка
+    folder = MakeTestInput( test_folder_path, "redefined",
+            "ФизРа-9А-1 17 4 1 1 11111111111111111111111111111111111 1 ЛяшенкоЮГ 1 9А 1 401\n" );
+    bool rejected = false;
+    try {
+        CTimeTableBuilder redefined_builder;
+        ReadTestInput(redefined_builder, folder);
+    } catch (CParseError& ex) {
+        rejected = ex.GetLine() > 0;
+    }
+    assert(rejected);
+
+    // Отличается только сложность -- тоже другой урок
+    folder = MakeTestInput( test_folder_path, "redefined-difficulty",
+            "ФизРа-9А-1 11 9 1 1 11111111111111111111111111111111111 1 ХрулевОА 1 9А 2 Зал1 Зал2\n" );
+    rejected = false;
+    try {
+        CTimeTableBuilder redefined_builder;
+        ReadTestInput(redefined_builder, folder);
+    } catch (CParseError& ex) {
+        rejected = ex.GetLine() > 0;
+    }
+    assert(rejected);
+    std::cout << "REDEFINED  SUBJECT  TEST  OK" << std::endl;
+
+    // Имя копии ФизРа-9А-1-2 совпадает с именем отдельной строки
+    folder = MakeTestInput( test_folder_path, "collision",
+            "ФизРа-9А-1-2 17 4 1 1 11111111111111111111111111111111111 1 ЛяшенкоЮГ 1 9А 1 401\n" );
+    rejected = false;
+    try {
+        CTimeTableBuilder collision_builder;
+        ReadTestInput(collision_builder, folder);
+    } catch (CParseError& ex) {
+        rejected = true;
+    }
+    assert(rejected);
+    std::cout << "LESSON  NAME  COLLISION  TEST  OK" << std::endl;
+}
+
+// Неудачные Perturb и RuinAndRecreate должны возвращать расписание в точности к исходному, в том числе кабинеты
+// событий, пересаженных при поиске кабинетов паросочетанием
+void RecreateRollbackTests(const std::string& test_folder_path) {
+
+    CTimeTableBuilder table_builder;
+    ReadTestInput(table_builder, test_folder_path);
+    CTimeTable table = table_builder.Build();
+    table.GenerateTimeTable();
+
+    const RuinType ruin_types[] = {RuinType::Day, RuinType::Teacher, RuinType::Group};
+    size_t failures(0);
+    for (size_t i = 0; i < 1000; i++) {
+        std::ostringstream before;
+        table.Save(before);
+
+        bool recreated = i % 2 ? table.Perturb(0.2) : table.RuinAndRecreate(ruin_types[i / 2 % 3]);
+        assert(table.CountConflicts() == 0);
+        if (recreated)
+            continue;
+
+        failures++;
+        std::ostringstream after;
+        table.Save(after);
+        assert(before.str() == after.str());
+    }
+
+    assert(failures > 0);
+    std::cout << "RECREATE  ROLLBACK  TEST  OK" << std::endl;
+}
+
+// Каждый оптимизатор возвращает расписание без конфликтов, оценка которого совпадает с вычисленной заново
+void OptimizersTests(const std::string& test_folder_path) {
+
+    CTimeTableBuilder table_builder;
+    ReadTestInput(table_builder, test_folder_path);
+    CTimeTable table = table_builder.Build();
+    CObjectiveFunction objective_function;
+
+    auto check = [&objective_function] (auto& optimizer, const char* name) {
+        optimizer.SetProgressSink(nullptr, 1);
+        optimizer.FindOptimal();
+        auto best = optimizer.GetCurrentBestSolution();
+        assert(static_cast<size_t>( objective_function.Value(best.first) ) == best.second);
+        assert(best.first.CountConflicts() == 0);
+        assert(optimizer.GetStopReason() == StopReason::IterationLimit);
+        std::cout << name << "  OPTIMIZER  TEST  OK" << std::endl;
+    };
+
+    CSAOptimizer sa_optimizer(table, 300, 1, 0.999, CoolingSchedule::Geometric, 3000, 500, 0.5, 3600);
+    check(sa_optimizer, "SA");
+    CTabuOptimizer tabu_optimizer(table, 5, 10, 100, 3600);
+    check(tabu_optimizer, "TABU");
+    CLNSOptimizer lns_optimizer(table, 50, 3600);
+    check(lns_optimizer, "LNS");
+    CABCOptimizer abc_optimizer(table, 4, 20, 10, ScoutMode::Elite, 0.1);
+    check(abc_optimizer, "ABC");
+}
+
+// Доступ к шагам охлаждения CSAOptimizer
+class CTestSAOptimizer : public CSAOptimizer {
+public:
+
+    using CSAOptimizer::CSAOptimizer;
+    using CSAOptimizer::reheat;
+    using CSAOptimizer::coolDown;
+    using CSAOptimizer::temperature_;
+
+};
+
+// После повторного нагрева линейный и логарифмический законы не возвращают начальную температуру
+void SAReheatTests(const std::string& test_folder_path) {
+
+    CTimeTableBuilder table_builder;
+    ReadTestInput(table_builder, test_folder_path);
+    CTimeTable table = table_builder.Build();
+
+    for (CoolingSchedule schedule : {CoolingSchedule::Linear, CoolingSchedule::Logarithmic}) {
+        CTestSAOptimizer optimizer(table, 300, 1, 0.999, schedule, 3000, 500, 0.5, 3600);
+        optimizer.reheat();
+        assert(optimizer.temperature_ == 150);
+        optimizer.coolDown();
+        assert(optimizer.temperature_ < 150 && optimizer.temperature_ > 1);
+    }
+    std::cout << "SA  REHEAT  TEST  OK" << std::endl;
+}
+
+// Имена групп из файла groups.txt папки folder
+std::vector<std::string> TestGroupNames(const std::string& folder) {
+    std::vector<std::string> group_names;
+    std::ifstream groups(folder + "groups.txt");
+    for (std::string line; std::getline(groups, line); )
+        if ( !line.empty() )
+            group_names.push_back( line.substr(0, line.find(' ')) );
+    return group_names;
+}
+
+// Перестановка цепи Кемпе не создает наложений и либо меняет расписание, либо оставляет его прежним
+void KempeSwapTests(const std::string& test_folder_path) {
+
+    CTimeTableBuilder table_builder;
+    ReadTestInput(table_builder, test_folder_path);
+    CTimeTable table = table_builder.Build();
+    table.GenerateTimeTable();
+
+    size_t swaps(0);
+    for (size_t i = 0; i < 1000; i++) {
+        std::ostringstream before;
+        table.Save(before);
+
+        bool swapped = table.RandomKempeSwap();
+        assert(table.CountConflicts() == 0);
+        std::ostringstream after;
+        table.Save(after);
+        assert(swapped || before.str() == after.str());
+        swaps += swapped;
+    }
+
+    assert(swaps > 0);
+    std::cout << "KEMPE  SWAP  TEST  OK" << std::endl;
+}
+
+// Независимая часть школы решается отдельной компонентой, и ее события попадают в общее расписание
+void ComponentsTests(const std::string& test_folder_path) {
+
+    std::string folder = MakeTestInput( test_folder_path, "components",
+            TestSubjectLine("Тест-А", 100, "ТестовыйА", TEST_WEEK_MASK), TEST_TEACHERS, TEST_GROUPS, TEST_CABINETS );
+    CTimeTableBuilder table_builder;
+    ReadTestInput(table_builder, folder);
+    assert(table_builder.BuildComponents().size() >= 2);
+
+    std::atomic<size_t> solved(0);
+    auto solve = [&solved] (CTimeTable& table, size_t) {
+        solved++;
+        table.GenerateTimeTable();
+        return table;
+    };
+    CTimeTable table = SolveByComponents(table_builder, solve);
+    assert(solved >= 2);
+
+    assert(table.CountConflicts() == 0);
+    bool placed = false;
+    for (size_t time = 0; time < table.GetTimeSlotsNumber(); time++)
+        placed |= table.GetEvent("Тест-1", time).IsActive();
+    assert(placed);
+    std::cout << "COMPONENTS  MERGE  TEST  OK" << std::endl;
+}
+
+// Исключение компоненты передается в вызывающий поток после завершения всех компонент
+void ComponentsErrorTests(const std::string& test_folder_path) {
+
+    std::string folder = MakeTestInput( test_folder_path, "components",
+            TestSubjectLine("Тест-А", 100, "ТестовыйА", TEST_WEEK_MASK), TEST_TEACHERS, TEST_GROUPS, TEST_CABINETS );
+    CTimeTableBuilder table_builder;
+    ReadTestInput(table_builder, folder);
+
+    std::atomic<size_t> solved(0);
+    auto solve = [&solved] (CTimeTable& table, size_t component) {
+        solved++;
+        if (component == 1)
+            throw CBadTimeTable("component failed");
+        table.GenerateTimeTable();
+        return table;
+    };
+
+    bool rethrown = false;
+    try {
+        SolveByComponents(table_builder, solve, true);
+    } catch (CBadTimeTable& ex) {
+        rethrown = ex.GetMessage() == "component failed";
+    }
+    assert(rethrown);
+    assert(solved >= 2);
+    std::cout << "COMPONENTS  ERROR  TEST  OK" << std::endl;
+}
+
+// Маска времени 5x7, в которой свободен только урок slot ( старший символ -- последний урок недели )
+std::string SingleSlotMask(size_t slot) {
+    std::string mask(35, '0');
+    mask[mask.size() - 1 - slot] = '1';
+    return mask;
+}
+
+// Необходимые условия: вместимость кабинетов и паросочетание ( кабинет, время )
+void FeasibilityTests(const std::string& test_folder_path) {
+
+    CTimeTableBuilder table_builder;
+    ReadTestInput(table_builder, test_folder_path);
+    table_builder.CheckFeasibility();
+
+    // Два предмета могут идти только первым уроком, а кабинет 999 один
+    std::string folder = MakeTestInput( test_folder_path, "matching",
+            TestSubjectLine("Тест-А", 100, "ТестовыйА", SingleSlotMask(0)) +
+            TestSubjectLine("Тест-Б", 101, "ТестовыйБ", SingleSlotMask(0)),
+            TEST_TEACHERS, TEST_GROUPS, TEST_CABINETS );
+    std::string message;
+    try {
+        CTimeTableBuilder matching_builder;
+        ReadTestInput(matching_builder, folder);
+        matching_builder.CheckFeasibility();
+    } catch (CInfeasibleTimeTable& ex) {
+        message = ex.GetMessage();
+    }
+    assert(message.find("Not enough cabinet time") != std::string::npos);
+    std::cout << "CABINET  MATCHING  TEST  OK" << std::endl;
+
+    // Проверка запоминается до следующего SetTimeTable*: после замены предметов Build проверяет задачу заново
+    CTimeTableBuilder rebuilt_builder;
+    ReadTestInput( rebuilt_builder, MakeTestInput( test_folder_path, "components",
+            TestSubjectLine("Тест-А", 100, "ТестовыйА", TEST_WEEK_MASK), TEST_TEACHERS, TEST_GROUPS, TEST_CABINETS ) );
+    rebuilt_builder.Build();
+    rebuilt_builder.Build();
+    rebuilt_builder.SetTimeTableSubjects(folder + "subjects.txt");
+    message.clear();
+    try {
+        rebuilt_builder.Build();
+    } catch (CInfeasibleTimeTable& ex) {
+        message = ex.GetMessage();
+    }
+    assert(message.find("Not enough cabinet time") != std::string::npos);
+
+    // В группе 20 человек, а кабинет 999 вмещает 10
+    folder = MakeTestInput( test_folder_path, "capacity", TestSubjectLine("Тест-А", 100, "ТестовыйА", TEST_WEEK_MASK),
+                            TEST_TEACHERS, TEST_GROUPS, "999 10 " + TEST_WEEK_MASK + "\n" );
+    message.clear();
+    try {
+        CTimeTableBuilder capacity_builder;
+        ReadTestInput(capacity_builder, folder);
+        capacity_builder.CheckFeasibility();
+    } catch (CInfeasibleTimeTable& ex) {
+        message = ex.GetMessage();
+    }
+    assert(message.find("large enough") != std::string::npos);
+    std::cout << "CABINET  CAPACITY  TEST  OK" << std::endl;
+}
+
+// Предмет с единственным временем начала фиксируется, и это время убирается у предметов его группы
+void PropagationTests(const std::string& test_folder_path) {
+
+    std::string folder = MakeTestInput( test_folder_path, "propagation",
+            TestSubjectLine("Тест-А", 100, "ТестовыйА", SingleSlotMask(0)) +
+            TestSubjectLine("Тест-Б", 101, "ТестовыйБ", TEST_WEEK_MASK),
+            TEST_TEACHERS, TEST_GROUPS, TEST_CABINETS );
+    CTimeTableBuilder table_builder;
+    ReadTestInput(table_builder, folder);
+    CTimeTable table = table_builder.Build();
+
+    // Первый урок свободен у учителя и группы предмета Тест-Б, но занят предметом Тест-А той же группы
+    const int64_t first_lesson(1);
+    assert(table.GetSubject("Тест-А").GetStartDomain() == first_lesson);
+    assert(table.GetSubject("Тест-Б").GetAvailableTime() & first_lesson);
+    assert( !(table.GetSubject("Тест-Б").GetStartDomain() & first_lesson) );
+    assert( !(table.GetSubject("Тест-Б").GetAvailableStartTime(5, 7) & first_lesson) );
+    std::cout << "DOMAIN  PROPAGATION  TEST  OK" << std::endl;
+}
+
+// Тест-А может идти в кабинетах 999 и 9999, Тест-Б -- только в 999, и оба -- только первым уроком. Если генератор
+// отдаст 999 предмету Тест-А, Тест-Б встанет только после пересадки Тест-А в 9999 паросочетанием.
+void CabinetMatchingTests(const std::string& test_folder_path) {
+
+    std::string folder = MakeTestInput( test_folder_path, "reassign",
+            "Тест-А 100 1 1 1 " + SingleSlotMask(0) + " 1 ТестовыйА 1 Тест-1 2 999 9999\n" +
+            "Тест-Б 101 1 1 1 " + SingleSlotMask(0) + " 1 ТестовыйБ 1 Тест-2 1 999\n",
+            TEST_TEACHERS, TEST_GROUPS + "Тест-2 20 " + TEST_WEEK_MASK + "\n",
+            TEST_CABINETS + "9999 30 " + TEST_WEEK_MASK + "\n" );
+    CTimeTableBuilder table_builder;
+    ReadTestInput(table_builder, folder);
+    CTimeTable table = table_builder.Build();
+    table.GenerateTimeTable();
+
+    const CEvent& first = table.GetEvent("Тест-1", 0);
+    const CEvent& second = table.GetEvent("Тест-2", 0);
+    assert(first.IsActive() && second.IsActive());
+    assert(second.GetCabinets().size() == 1 && (*second.GetCabinets().begin())->GetName() == "999");
+    assert(first.GetCabinets().size() == 1 && (*first.GetCabinets().begin())->GetName() == "9999");
+    assert(table.CountConflicts() == 0);
+    std::cout << "CABINET  REASSIGNMENT  TEST  OK" << std::endl;
+}
+
+// Ребро графа конфликтов -- общий учитель или группа
+void ConflictGraphTests(const std::string& test_folder_path) {
+
+    CTimeTableBuilder table_builder;
+    ReadTestInput(table_builder, test_folder_path);
+    CTimeTable table = table_builder.Build();
+    table.GenerateTimeTable();
+    const CConflictGraph& graph = table.GetConflictGraph();
+
+    // Каждый предмет стоит в расписании своих групп
+    std::vector<const CSubject*> subjects( graph.GetSubjectsNumber() );
+    for (const auto& group_name : TestGroupNames(test_folder_path))
+        for (size_t time = 0; time < table.GetTimeSlotsNumber(); time++)
+            if ( table.GetEvent(group_name, time).IsActive() ) {
+                const CSubject* subject = table.GetEvent(group_name, time).GetSubject();
+                subjects[ subject->GetIndex() ] = subject;
+            }
+    assert( std::find(subjects.begin(), subjects.end(), nullptr) == subjects.end() );
+
+    for (size_t first = 0; first < subjects.size(); first++) {
+        size_t degree(0);
+        for (size_t second = 0; second < subjects.size(); second++) {
+            bool shared = first != second &&
+                          ( Intersects(subjects[first]->GetTeachers(), subjects[second]->GetTeachers()) ||
+                            Intersects(subjects[first]->GetGroups(), subjects[second]->GetGroups()) );
+            assert(graph.Conflicting(first, second) == shared);
+            degree += shared;
+        }
+        assert(graph.GetDegree(first) == degree);
+    }
+
+    // Запрос по битсету предметов, идущих в одно время, совпадает с попарной проверкой
+    for (size_t time = 0; time < table.GetTimeSlotsNumber(); time++) {
+        CConflictGraph::Row row = graph.MakeRow();
+        std::vector<size_t> busy;
+        for (const auto& group_name : TestGroupNames(test_folder_path))
+            if ( table.GetEvent(group_name, time).IsActive() ) {
+                size_t index = table.GetEvent(group_name, time).GetSubject()->GetIndex();
+                CConflictGraph::SetBit(row, index);
+                busy.push_back(index);
+            }
+        for (size_t subject = 0; subject < subjects.size(); subject++) {
+            bool conflicting = std::any_of(busy.begin(), busy.end(),
+                                           [&graph, subject] (size_t other) { return graph.Conflicting(subject, other); });
+            assert(graph.ConflictsWithAny(subject, row) == conflicting);
+        }
+        for (size_t index : busy)
+            CConflictGraph::ResetBit(row, index);
+        assert( row == graph.MakeRow() );
+    }
+    std::cout << "CONFLICT  GRAPH  TEST  OK" << std::endl;
+}
+
+// Маски времен начала одинаковы у CWeekGeometry и CRuntimeWeekGeometry и не выходят за конец дня
+void WeekGeometryTests() {
+
+    CWeekGeometry<5, 7> geometry;
+    CRuntimeWeekGeometry runtime_geometry(5, 7);
+    for (size_t duration = 1; duration <= 8; duration++)
+        assert(geometry.StartMask(duration) == runtime_geometry.StartMask(duration));
+
+    // Урок длины 2 не начинается последним уроком дня
+    assert( (geometry.StartMask(2) >> 5) & 1 );
+    assert( !((geometry.StartMask(2) >> 6) & 1) );
+    assert(geometry.StartMask(8) == 0);
+
+    // В свободных уроках 2, 3, 4 урок длины 2 начинается вторым или третьим
+    assert(AvailableStartTime(geometry, TimeMask(2, 3), 2) == TimeMask(2, 2));
+    std::cout << "WEEK  GEOMETRY  TEST  OK" << std::endl;
+}
+
+// Копии расписания делят данные задачи, но ходы в копии не меняют исходное расписание и его занятость
+void TimeTableCopyTests(const std::string& test_folder_path) {
+
+    CTimeTableBuilder table_builder;
+    ReadTestInput(table_builder, test_folder_path);
+    CTimeTable table = table_builder.Build();
+    table.GenerateTimeTable();
+    std::ostringstream original;
+    table.Save(original);
+    COccupancy original_occupancy = table.GetOccupancy();
+    CTimeTable copy(table);
+    assert(&copy.GetSubject("Физика-10А-1") == &table.GetSubject("Физика-10А-1"));
+    for (size_t i = 0; i < 100; i++)
+        copy.RandomSwap();
+    std::ostringstream changed;
+    copy.Save(changed);
+    assert(changed.str() != original.str());
+    assert(copy.CountConflicts() == 0);
+
+    std::ostringstream unchanged;
+    table.Save(unchanged);
+    assert(unchanged.str() == original.str());
+    for (const auto& group_name : TestGroupNames(test_folder_path))
+        for (size_t time = 0; time < table.GetTimeSlotsNumber(); time++)
+            if ( table.GetEvent(group_name, time).IsActive() ) {
+                const CSubject* subject = table.GetEvent(group_name, time).GetSubject();
+                assert(table.GetOccupancy().GetSubjectAvailableTime(subject) ==
+                       original_occupancy.GetSubjectAvailableTime(subject));
+            }
+    std::cout << "TIMETABLE  COPY  TEST  OK" << std::endl;
+}
+
+// Счетчики ABC согласованы: каждая рабочая пчела делает попытку в каждом цикле, принятых не больше допустимых,
+// а допустимых меньше проверенных кандидатов
+void ABCStatsTests(const std::string& test_folder_path) {
+
+    CTimeTableBuilder table_builder;
+    ReadTestInput(table_builder, test_folder_path);
+    CTimeTable table = table_builder.Build();
+
+    CABCOptimizer optimizer(table, 4, 20, 10);
+    optimizer.FindOptimal();
+    const ABCStats& stats = optimizer.GetStats();
+
+    size_t attempted(0), feasible(0);
+    for (const OperatorStats* operator_stats : {&stats.swap, &stats.move, &stats.kempe_swap}) {
+        assert(operator_stats->accepted <= operator_stats->feasible);
+        assert(operator_stats->feasible <= operator_stats->attempted);
+        attempted += operator_stats->attempted;
+        feasible += operator_stats->feasible;
+    }
+    assert(attempted >= 4 * 20);
+    // Операторы перебирают кандидатов, и часть из них отвергается
+    assert(feasible < attempted);
+    assert(stats.evaluations > 0 && stats.copies > 0);
+    std::cout << "ABC  STATS  TEST  OK" << std::endl;
+}
+
+#ifdef TIMER_TRACE
+// Интервалы главного и завершившегося потока попадают в файл трассы
+void TraceTests() {
+
+    {
+        TRACE_SCOPE("TraceTestsMain");
+    }
+    std::thread( [] () { TRACE_SCOPE("TraceTestsThread"); } ).join();
+    TRACE_WRITE("/tmp/timer-test-trace.json");
+
+    std::ifstream file("/tmp/timer-test-trace.json");
+    std::ostringstream content;
+    content << file.rdbuf();
+    assert(content.str().find("\"traceEvents\"") != std::string::npos);
+    assert(content.str().find("\"TraceTestsMain\"") != std::string::npos);
+    assert(content.str().find("\"TraceTestsThread\"") != std::string::npos);
+    std::cout << "TRACE  TEST  OK" << std::endl;
+}
+#endif
+
+// Приемник, запоминающий все отчеты
+class CTestProgressSink : public CProgressSink {
+public:
+
+    std::vector<ProgressReport> reports;
+
+    void Report(const ProgressReport& report) override {
+        reports.push_back(report);
+    }
+
+};
+
+// Отчеты приходят по ходу работы, лучшая оценка в них не растет, последний отчет -- итоговый
+void ProgressTests(const std::string& test_folder_path) {
+
+    CTimeTableBuilder table_builder;
+    ReadTestInput(table_builder, test_folder_path);
+    CTimeTable table = table_builder.Build();
+
+    CSAOptimizer optimizer(table, 300, 1, 0.999, CoolingSchedule::Geometric, 3000, 500, 0.5, 3600);
+    auto sink = std::make_shared<CTestProgressSink>();
+    optimizer.SetProgressSink(sink, 0);
+    optimizer.FindOptimal();
+
+    const std::vector<ProgressReport>& reports = sink->reports;
+    assert(reports.size() > 1);
+    for (size_t i = 1; i < reports.size(); i++) {
+        assert(reports[i].iteration >= reports[i - 1].iteration);
+        assert(reports[i].best_cost <= reports[i - 1].best_cost);
+        assert(!reports[i - 1].final);
+    }
+    assert(reports.back().final);
+    assert(reports.back().best_cost == optimizer.GetCurrentBestSolution().second);
+    assert(reports.back().job.empty() && reports.back().component == 0);
+    std::cout << "PROGRESS  REPORTS  TEST  OK" << std::endl;
+
+    // Отчеты задач пакетного режима в общем файле подписаны задачей и компонентой
+    const std::string progress_file = "/tmp/timer-test-progress.jsonl";
+    {
+        auto json_sink = std::make_shared<CJsonLinesProgressSink>(progress_file);
+        CLabelledProgressSink labelled(json_sink, "школа \"1\"", 2);
+        labelled.Report(reports.back());
+    }
+    std::ifstream progress(progress_file);
+    std::string line;
+    std::getline(progress, line);
+    assert(line.find("\"job\":\"школа \\\"1\\\"\",\"component\":2,") != std::string::npos);
+    std::cout << "PROGRESS  LABELS  TEST  OK" << std::endl;
+}
+
+// Оптимизатор останавливается по первому выполненному условию и сообщает его
+void StoppingCriteriaTests(const std::string& test_folder_path) {
+
+    CStoppingCriteria iterations;
+    iterations.SetIterationLimit(5).SetTargetCost(10);
+    iterations.Start(100);
+    assert(!iterations.ShouldStop(4, 50) && iterations.ShouldStop(5, 50));
+    assert(iterations.GetReason() == StopReason::IterationLimit);
+    iterations.Start(100);
+    assert(iterations.ShouldStop(1, 10) && iterations.GetReason() == StopReason::TargetCost);
+
+    // Нулевая целевая оценка -- тоже условие: останавливаемся только на расписании без штрафов
+    CStoppingCriteria zero_target;
+    zero_target.SetTargetCost(0);
+    zero_target.Start(100);
+    assert(!zero_target.ShouldStop(1, 1) && zero_target.ShouldStop(2, 0));
+    assert(zero_target.GetReason() == StopReason::TargetCost);
+
+    // Улучшение на итерации 2 откладывает остановку до итерации 5
+    CStoppingCriteria no_improvement;
+    no_improvement.SetNoImprovementIterations(3);
+    no_improvement.Start(100);
+    assert(!no_improvement.ShouldStop(1, 100) && !no_improvement.ShouldStop(2, 90));
+    assert(!no_improvement.ShouldStop(4, 90) && no_improvement.ShouldStop(5, 90));
+    assert(no_improvement.GetReason() == StopReason::NoImprovement);
+    std::cout << "STOPPING  CRITERIA  TEST  OK" << std::endl;
+
+    CTimeTableBuilder table_builder;
+    ReadTestInput(table_builder, test_folder_path);
+    CTimeTable table = table_builder.Build();
+
+    // Оптимизатор, отмененный до запуска, останавливается на первой же проверке
+    std::atomic<bool> cancel(true);
+    CLNSOptimizer optimizer(table, 1000000, 3600);
+    optimizer.SetProgressSink(nullptr, 1);
+    optimizer.SetStoppingCriteria( CStoppingCriteria().SetCancelFlag(&cancel) );
+    optimizer.FindOptimal();
+    assert(optimizer.GetStopReason() == StopReason::Cancelled);
+    std::cout << "CANCEL  FLAG  TEST  OK" << std::endl;
+}
+
+// Снимки, прочитанные из другого потока во время работы ABC, целы: их оценка совпадает с оценкой их расписания
+void SolutionSnapshotTests(const std::string& test_folder_path) {
+
+    CTimeTableBuilder table_builder;
+    ReadTestInput(table_builder, test_folder_path);
+    CTimeTable table = table_builder.Build();
+
+    CABCOptimizer optimizer(table, 4, 200, 10);
+    optimizer.SetProgressSink(nullptr, 1);
+    std::vector<size_t> improvements;
+    optimizer.SetImprovementCallback( [&improvements] (const CSolutionSnapshotPtr& snapshot) {
+        improvements.push_back(snapshot->cost);
+    } );
+
+    std::atomic<bool> finished(false);
+    std::thread reader( [&optimizer, &finished] () {
+        CObjectiveFunction objective_function;
+        while (!finished) {
+            CSolutionSnapshotPtr snapshot = optimizer.GetBestSnapshot();
+            if (snapshot)
+                assert(static_cast<size_t>( objective_function.Value(snapshot->timetable) ) == snapshot->cost);
+        }
+    } );
+    optimizer.FindOptimal();
+    finished = true;
+    reader.join();
+
+    assert(!improvements.empty());
+    for (size_t i = 1; i < improvements.size(); i++)
+        assert(improvements[i] < improvements[i - 1]);
+    assert(optimizer.GetBestSnapshot()->cost == optimizer.GetCurrentBestSolution().second);
+    assert(optimizer.GetBestSnapshot()->cost == improvements.back());
+    std::cout << "SOLUTION  SNAPSHOT  TEST  OK" << std::endl;
+}
+
+// Контрольная точка ABC восстанавливает лучшее решение; запись для другой популяции или оборванная отвергается
+void CheckpointTests(const std::string& test_folder_path) {
+
+    CTimeTableBuilder table_builder;
+    ReadTestInput(table_builder, test_folder_path);
+    CTimeTable table = table_builder.Build();
+    const std::string checkpoint = "/tmp/timer-test-checkpoint";
+
+    CABCOptimizer optimizer(table, 4, 20, 10, ScoutMode::Elite, 0.1);
+    optimizer.SetProgressSink(nullptr, 1);
+    optimizer.SetCheckpoint(checkpoint, 1e9);
+    optimizer.FindOptimal();
+
+    CABCOptimizer resumed(table, 4, 20, 10, ScoutMode::Elite, 0.1);
+    resumed.LoadCheckpoint(checkpoint);
+    std::ostringstream expected, loaded;
+    optimizer.GetCurrentBestSolution().first.Save(expected);
+    resumed.GetCurrentBestSolution().first.Save(loaded);
+    assert(expected.str() == loaded.str());
+    assert(resumed.GetCurrentBestSolution().second == optimizer.GetCurrentBestSolution().second);
+    std::cout << "CHECKPOINT  ROUNDTRIP  TEST  OK" << std::endl;
+
+    bool rejected = false;
+    try {
+        CABCOptimizer other_population(table, 5, 20, 10);
+        other_population.LoadCheckpoint(checkpoint);
+    } catch (CBadCheckpoint& ex) {
+        rejected = true;
+    }
+    assert(rejected);
+
+    // Оборванная запись расписания
+    std::string saved = expected.str();
+    std::istringstream truncated( saved.substr(0, saved.size() / 2) );
+    CTimeTable loaded_table = optimizer.GetCurrentBestSolution().first;
+    rejected = false;
+    try {
+        loaded_table.Load(truncated);
+    } catch (CBadCheckpoint& ex) {
+        rejected = true;
+    }
+    assert(rejected);
+
+    // Расписание из двух одинаковых событий: отпечаток, количество событий 2 и первое событие дважды
+    size_t event_size = 3 * sizeof(uint32_t) + sizeof(uint32_t) * *reinterpret_cast<const uint32_t*>(
+            saved.data() + sizeof(uint64_t) + 3 * sizeof(uint32_t) );
+    std::string event = saved.substr(sizeof(uint64_t) + sizeof(uint32_t), event_size);
+    std::ostringstream repeated;
+    WriteBinary<uint64_t>(repeated, *reinterpret_cast<const uint64_t*>( saved.data() ));
+    WriteBinary<uint32_t>(repeated, 2);
+    repeated << event << event;
+
+    std::istringstream repeated_stream(repeated.str());
+    rejected = false;
+    try {
+        loaded_table.Load(repeated_stream);
+    } catch (CBadCheckpoint& ex) {
+        rejected = ex.GetMessage().find("two events") != std::string::npos;
+    }
+    // Отвергнутая запись оставляет расписание пустым, а не частично прочитанным
+    assert(rejected && loaded_table.CountConflicts() == 0);
+    std::cout << "CHECKPOINT  VALIDATION  TEST  OK" << std::endl;
+}
+
+// Скомпилированная задача читается в ту же задачу; файл, не являющийся скомпилированной задачей, и неверный размер
+// недели отвергаются
+void CompiledInstanceTests(const std::string& test_folder_path) {
+
+    CTimeTableBuilder table_builder;
+    ReadTestInput(table_builder, test_folder_path);
+    table_builder.CompileInstance("/tmp/timer-test-instance");
+
+    CTimeTableBuilder compiled_builder;
+    compiled_builder.SetTimeTableInstance("/tmp/timer-test-instance");
+    compiled_builder.CompileInstance("/tmp/timer-test-instance-2");
+
+    std::ifstream first("/tmp/timer-test-instance", std::ios::binary), second("/tmp/timer-test-instance-2", std::ios::binary);
+    std::ostringstream first_content, second_content;
+    first_content << first.rdbuf();
+    second_content << second.rdbuf();
+    assert(first_content.str() == second_content.str());
+
+    // Копии уроков сохраняются, и задача из файла решается
+    CTimeTable table = compiled_builder.Build();
+    assert(table.GetSubject("Физика-10А-1").IsCopyOf(table.GetSubject("Физика-10А-2")));
+    table.GenerateTimeTable();
+    std::cout << "COMPILED  INSTANCE  ROUNDTRIP  TEST  OK" << std::endl;
+
+    bool rejected = false;
+    try {
+        CTimeTableBuilder invalid_builder;
+        invalid_builder.SetTimeTableInstance(test_folder_path + "subjects.txt");
+    } catch (CBadInstance& ex) {
+        rejected = true;
+    }
+    assert(rejected);
+
+    // Неделя из 64 уроков не помещается в маску времени
+    table_builder.SetTimeTableSize(8, 8);
+    table_builder.CompileInstance("/tmp/timer-test-instance");
+    rejected = false;
+    try {
+        CTimeTableBuilder invalid_builder;
+        invalid_builder.SetTimeTableInstance("/tmp/timer-test-instance");
+    } catch (CBadInstance& ex) {
+        rejected = true;
+    }
+    assert(rejected);
+    std::cout << "COMPILED  INSTANCE  VALIDATION  TEST  OK" << std::endl;
+}
+
+// Ошибка во входном файле указывает файл, строку и столбец
+void TokenizerTests(const std::string& test_folder_path) {
+
+    size_t lines_number(0);
+    std::ifstream subjects(test_folder_path + "subjects.txt");
+    for (std::string line; std::getline(subjects, line); )
+        lines_number++;
+
+    const std::pair<std::string, std::string> bad_lines[] = {
+        {"number", "ФизРа-9А-9 17 4 один 1 11111111111111111111111111111111111 1 ЛяшенкоЮГ 1 9А 1 401\n"},
+        {"teacher", "ФизРа-9А-9 17 4 1 1 11111111111111111111111111111111111 1 НеизвестныйУчитель 1 9А 1 401\n"}
+    };
+    for (const auto& [name, line] : bad_lines) {
+        std::string folder = MakeTestInput(test_folder_path, "tokenizer-" + name, line);
+        bool rejected = false;
+        try {
+            CTimeTableBuilder table_builder;
+            ReadTestInput(table_builder, folder);
+        } catch (CParseError& ex) {
+            rejected = ex.GetLine() == lines_number + 1 && ex.GetColumn() > 0 &&
+                       ex.GetFilename() == folder + "subjects.txt";
+        }
+        assert(rejected);
+    }
+    std::cout << "TOKENIZER  ERROR  POSITION  TEST  OK" << std::endl;
+}
+
+// Wait дожидается всех задач; пул из одного потока выполняет их в порядке постановки
+void ThreadPoolTests() {
+
+    std::atomic<size_t> finished(0);
+    CThreadPool pool(4);
+    for (size_t i = 0; i < 100; i++)
+        pool.Submit( [&finished] () {
+            std::this_thread::sleep_for( std::chrono::microseconds(100) );
+            finished++;
+        } );
+    pool.Wait();
+    assert(finished == 100);
+
+    std::vector<int> order;
+    {
+        CThreadPool single_pool(1);
+        for (int i = 0; i < 10; i++)
+            single_pool.Submit( [&order, i] () { order.push_back(i); } );
+        single_pool.Wait();
+    }
+    for (int i = 0; i < 10; i++)
+        assert(order[i] == i);
+    std::cout << "THREAD  POOL  TEST  OK" << std::endl;
+}
+
+// Задачи, ожидающие в очереди, запускаются по убыванию приоритета
+void ThreadPoolPriorityTests() {
+
+    std::mutex mutex;
+    std::vector<int> order;
+    std::atomic<bool> submitted(false);
+    {
+        CThreadPool pool(1);
+        // Первая задача занимает единственный поток, пока остальные не окажутся в очереди
+        pool.Submit( [&submitted] () { while (!submitted) std::this_thread::yield(); } );
+        // Крайние значения int не переполняют порядок очереди
+        for (int priority : {1, std::numeric_limits<int>::min(), 3, std::numeric_limits<int>::max(), 2})
+            pool.Submit( [&mutex, &order, priority] () {
+                std::lock_guard<std::mutex> lock(mutex);
+                order.push_back(priority);
+            }, priority );
+        submitted = true;
+        pool.Wait();
+    }
+
+    assert( (order == std::vector<int>{std::numeric_limits<int>::max(), 3, 2, 1, std::numeric_limits<int>::min()}) );
+    std::cout << "THREAD  POOL  PRIORITY  TEST  OK" << std::endl;
+}
+
+// Служба решает задачи по очереди, хранит их расписания, сообщает об ошибках решателя и забывает старые задачи
+void SchedulingServiceTests(const std::string& test_folder_path) {
+
+    auto solver = [] (const std::string& input, const std::atomic<bool>*, std::shared_ptr<CProgressSink>,
+                      CSolutionPublisher::ImprovementCallback) {
+        CTimeTableBuilder table_builder;
+        ReadTestInput(table_builder, input);
+        CTimeTable table = table_builder.Build();
+        table.GenerateTimeTable();
+        return table;
+    };
+
+    CSchedulingService service("/tmp/timer-test-service/", 1, solver, 2);
+    size_t solved = service.Submit(test_folder_path, 0);
+    size_t failed = service.Submit("/tmp/timer-test-missing/", 0);
+
+    auto finished = [&service] (size_t id) {
+        auto status = service.GetStatus(id);
+        return status && status->state != JobState::Queued && status->state != JobState::Running;
+    };
+    while ( !finished(solved) || !finished(failed) )
+        std::this_thread::sleep_for( std::chrono::milliseconds(10) );
+
+    auto status = service.GetStatus(solved);
+    assert(status->state == JobState::Done && status->has_result);
+    assert( std::ifstream( service.GetResultFile(solved, false) ).is_open() );
+    assert( std::ifstream( service.GetResultFile(solved, true) ).is_open() );
+    assert( !service.Cancel(solved) );
+
+    status = service.GetStatus(failed);
+    assert(status->state == JobState::Failed && !status->has_result && !status->message.empty());
+    assert(service.GetResultFile(failed, false).empty());
+    assert(service.GetStatuses().size() == 2);
+
+    // Хранятся только две завершенные задачи: третья вытесняет самую старую
+    size_t third = service.Submit(test_folder_path, 0);
+    while ( !finished(third) )
+        std::this_thread::sleep_for( std::chrono::milliseconds(10) );
+    assert( !service.GetStatus(solved) && service.GetStatus(failed) );
+
+    std::string result_file = service.GetResultFile(third, false);
+    assert( std::ifstream(result_file).is_open() );
+    assert( service.Forget(third) );
+    assert( !std::ifstream(result_file).is_open() );
+    assert( !service.GetStatus(third) );
+
+    bool rejected = false;
+    try {
+        service.SubmitData("incomplete", { {"teachers.txt", ""} }, 0);
+    } catch (CException& ex) {
+        rejected = true;
+    }
+    assert(rejected);
+
+    // Решатель публикует начальное расписание и работает до отмены: пока он работает, доступно промежуточное
+    auto publishing_solver = [] (const std::string& input, const std::atomic<bool>* cancel_flag,
+                                 std::shared_ptr<CProgressSink>,
+                                 CSolutionPublisher::ImprovementCallback on_improvement) {
+        CTimeTableBuilder table_builder;
+        ReadTestInput(table_builder, input);
+        CTimeTable table = table_builder.Build();
+        table.GenerateTimeTable();
+        size_t cost = CObjectiveFunction().Value(table);
+        on_improvement( std::make_shared<const SolutionSnapshot>( SolutionSnapshot {table, cost, 0, 0} ) );
+        while ( !*cancel_flag )
+            std::this_thread::sleep_for( std::chrono::milliseconds(10) );
+        return table;
+    };
+
+    CSchedulingService publishing_service("/tmp/timer-test-provisional/", 1, publishing_solver, 2);
+    size_t running = publishing_service.Submit(test_folder_path, 0);
+    while ( !publishing_service.GetStatus(running)->has_provisional )
+        std::this_thread::sleep_for( std::chrono::milliseconds(10) );
+
+    status = publishing_service.GetStatus(running);
+    assert(status->state == JobState::Running && !status->has_result);
+    assert( publishing_service.GetResultFile(running, false).empty() );
+    std::string provisional_file = publishing_service.WriteProvisionalResult(running, false);
+    assert( std::ifstream(provisional_file).is_open() );
+    assert( std::ifstream( publishing_service.WriteProvisionalResult(running, true) ).is_open() );
+
+    assert( publishing_service.Cancel(running) );
+    while ( publishing_service.GetStatus(running)->state == JobState::Running )
+        std::this_thread::sleep_for( std::chrono::milliseconds(10) );
+    status = publishing_service.GetStatus(running);
+    assert(status->state == JobState::Cancelled && status->has_result && !status->has_provisional);
+    assert( publishing_service.WriteProvisionalResult(running, false).empty() );
+    assert( !std::ifstream(provisional_file).is_open() );
+    std::cout << "SCHEDULING  SERVICE  TEST  OK" << std::endl;
+}
+
 #endif //TIMER_TESTS_H
@@ -4,76 +4,181 @@
 
 #include "CABCOptimizer.h"
 
+#include "CException.h"
 #include <random>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstring>
 
+// Заголовок файла контрольной точки и версия формата
+const char CHECKPOINT_MAGIC[8] = {'T', 'I', 'M', 'E', 'R', 'A', 'B', 'C'};
+const uint32_t CHECKPOINT_VERSION = 2;
 
+std::ostream& operator<<(std::ostream& stream, const ABCStats& stats) {
+    auto print_operator = [&stream] (const char* name, const OperatorStats& operator_stats) {
+        stream << "  " << std::left << std::setw(12) << name << std::right
+               << " attempted " << std::setw(10) << operator_stats.attempted
+               << "   feasible " << std::setw(10) << operator_stats.feasible
+               << "   accepted " << std::setw(10) << operator_stats.accepted << '\n';
+    };
+
+    stream << "Operators:\n";
+    print_operator("swap", stats.swap);
+    print_operator("move", stats.move);
+    print_operator("kempe swap", stats.kempe_swap);
+
+    stream << "Evaluations: " << stats.evaluations << "   copies: " << stats.copies << '\n'
+           << "Generator backtracks: " << stats.generator.backtracks
+           << "   restarts: " << stats.generator.restarts << '\n'
+           << "Phases, s:   employed " << stats.employed_time.count()
+           << "   onlooker " << stats.onlooker_time.count()
+           << "   scout " << stats.scout_time.count()
+           << "   memorize " << stats.memorize_time.count() << '\n';
+
+    return stream;
+}
+
+// Выполнить фазу алгоритма и добавить время ее работы к elapsed
+template <class Phase>
+void measurePhase(std::chrono::duration<double>& elapsed, Phase phase) {
+    auto start = std::chrono::steady_clock::now();
+    phase();
+    elapsed += std::chrono::steady_clock::now() - start;
+}
 
 CABCOptimizer::CABCOptimizer( CTimeTable& timetable, size_t population_size,
-                              size_t maximum_cycle_number, size_t single_source_limit )
+                              size_t maximum_cycle_number, size_t single_source_limit,
+                              ScoutMode scout_mode, double scout_perturbation_fraction )
         : current_best_solution_( std::make_pair(timetable, 0) ),
+          candidate_(timetable),
           population_size_(population_size),
-          maximum_cycle_number_(maximum_cycle_number),
-          single_source_limit_(single_source_limit) {
+          single_source_limit_(single_source_limit),
+          scout_mode_(scout_mode),
+          scout_perturbation_fraction_(scout_perturbation_fraction),
+          progress_("ABC"),
+          cycle_(0),
+          elapsed_time_(0),
+          checkpoint_interval_(0) {
 
+    stopping_criteria_.SetIterationLimit(maximum_cycle_number);
     solutions_.reserve(population_size_);
 
-    current_best_solution_.first.GenerateTimeTable();
-    current_best_solution_.second = cost_function_.Value(current_best_solution_.first);
+    current_best_solution_.first.GenerateTimeTable(&stats_.generator);
+    current_best_solution_.second = evaluate(current_best_solution_.first);
 
     for (int i = 0; i < population_size_; i++)
         solutions_.emplace_back( std::make_pair(current_best_solution_.first, 0) );
+    stats_.copies += population_size_;
+
+    best_publisher_.Publish(current_best_solution_.first, current_best_solution_.second, 0);
+}
+
+int CABCOptimizer::evaluate(const CTimeTable& solution) {
+    stats_.evaluations++;
+    return cost_function_.Value(solution);
+}
+
+void CABCOptimizer::copySolution(CTimeTable& destination, const CTimeTable& source) {
+    stats_.copies++;
+    destination = source;
 }
 
-void CABCOptimizer::memorizeBestSolution() {
+void CABCOptimizer::memorizeBestSolution(size_t cycle) {
+    TRACE_SCOPE("ABC memorize");
+    bool improved(false);
     for (auto& [solution, changes_counter] : solutions_) {
-        int current_cost = cost_function_.Value(solution);
+        int current_cost = evaluate(solution);
         if ( current_best_solution_.second > current_cost ) {
-            current_best_solution_ = std::make_pair(solution, current_cost);
+            copySolution(current_best_solution_.first, solution);
+            current_best_solution_.second = current_cost;
+            improved = true;
         }
     }
+
+    // Один снимок на цикл, даже если лучшее решение менялось несколько раз
+    if (improved)
+        best_publisher_.Publish(current_best_solution_.first, current_best_solution_.second, cycle);
 }
 
 void CABCOptimizer::sendEmploedBees() {
-    srand( time(NULL) );
+    TRACE_SCOPE("ABC employed");
     for (auto& solution : solutions_) {
         sendBee(solution);
     }
 }
 
 void CABCOptimizer::sendOnlookerBees() {
+    TRACE_SCOPE("ABC onlooker");
     int values_sum = valuesSum();
     double previous_prob_sum(0), current_prob_sum(0);
-    srand( time(NULL) );
     for (auto& solution : solutions_) {
-        current_prob_sum = static_cast<double>( cost_function_.Value(solution.first) ) / values_sum * 1000;
-        int choiser = rand() % 1000;
+        current_prob_sum = static_cast<double>( evaluate(solution.first) ) / values_sum * 1000;
+        int choiser = RandomIndex(1000);
         if ( choiser < current_prob_sum / (1000 - previous_prob_sum) )
             sendBee(solution);
     }
 }
 
 void CABCOptimizer::sendScoutBees() {
+    TRACE_SCOPE("ABC scout");
     for (auto& [solution, changes_counter] : solutions_) {
         if ( changes_counter > single_source_limit_ ) {
-            solution.RecoverTimeTable();
-            solution.GenerateTimeTable();
+            if ( !scoutSource(solution) ) {
+                solution.RecoverTimeTable();
+                solution.GenerateTimeTable(&stats_.generator);
+            }
             changes_counter = 0;
         }
     }
 }
 
+bool CABCOptimizer::scoutSource(CTimeTable& solution) {
+    switch (scout_mode_) {
+        case ScoutMode::Regenerate:
+            return false;
+        case ScoutMode::Perturb:
+            return solution.Perturb(scout_perturbation_fraction_, &stats_.generator);
+        case ScoutMode::Elite: {
+            copySolution(candidate_, current_best_solution_.first);
+            if ( !candidate_.Perturb(scout_perturbation_fraction_, &stats_.generator) )
+                return false;
+            copySolution(solution, candidate_);
+            return true;
+        }
+    }
+    return false;
+}
+
 void CABCOptimizer::sendBee(std::pair<CTimeTable, size_t> &solution) {
-    CTimeTable new_solution(solution.first);
-    int choiser = rand() % 1000;
-    if (choiser < 600) {
-        new_solution.RandomSwap();
+    copySolution(candidate_, solution.first);
+    int choiser = RandomIndex(1000);
+    OperatorStats* operator_stats;
+    bool moved;
+    // Оператор перебирает кандидатов, пока не найдет допустимое перемещение; отвергнутые тоже считаются попытками
+    size_t rejected(0);
+    if (choiser < 450) {
+        operator_stats = &stats_.swap;
+        moved = candidate_.RandomSwap(nullptr, &rejected);
+    } else if (choiser < 750) {
+        operator_stats = &stats_.move;
+        moved = candidate_.RandomMove(nullptr, &rejected);
     } else {
-        new_solution.RandomMove();
+        operator_stats = &stats_.kempe_swap;
+        moved = candidate_.RandomKempeSwap(nullptr, &rejected);
     }
-    if ( cost_function_.Value(new_solution) >= cost_function_.Value(solution.first) )
+    operator_stats->attempted += rejected;
+    if (moved) {
+        operator_stats->attempted++;
+        operator_stats->feasible++;
+    }
+
+    if ( evaluate(candidate_) >= evaluate(solution.first) )
         solution.second++;
     else {
-        solution.first = new_solution;
+        operator_stats->accepted++;
+        copySolution(solution.first, candidate_);
         solution.second = 0;
     }
 }
@@ -81,25 +186,199 @@ void CABCOptimizer::sendBee(std::pair<CTimeTable, size_t> &solution) {
 int CABCOptimizer::valuesSum() {
     int values_sum(0);
     for( const auto& [solution, change_counter] : solutions_ )
-        values_sum += cost_function_.Value(solution);
+        values_sum += evaluate(solution);
     return values_sum;
 }
 
+ProgressCounters CABCOptimizer::progressCounters(size_t cycle) const {
+    ProgressCounters counters;
+    counters.iteration = cycle;
+    counters.maximum_iteration_number = stopping_criteria_.GetIterationLimit();
+    counters.best_cost = current_best_solution_.second;
+    counters.evaluations = stats_.evaluations;
+    // Предложенные соседние решения -- найденные перемещения, а не все проверенные кандидаты
+    for (const OperatorStats* operator_stats : { &stats_.swap, &stats_.move, &stats_.kempe_swap }) {
+        counters.attempted += operator_stats->feasible;
+        counters.accepted += operator_stats->accepted;
+    }
+    return counters;
+}
+
 void CABCOptimizer::FindOptimal() {
+    progress_.Start();
+    best_publisher_.Start();
+    stopping_criteria_.Start(current_best_solution_.second, cycle_, elapsed_time_.count());
+
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed_before_start = elapsed_time_;
+    auto last_checkpoint = start;
 
-    for (int i = 0; i < maximum_cycle_number_; i++) {
+    while ( !stopping_criteria_.ShouldStop(cycle_, current_best_solution_.second) ) {
 
-        std::cout << "\r" << static_cast<double>(i)/maximum_cycle_number_*100 << "% completed.     Current best score: "
-                  << current_best_solution_.second << std::flush;
+        progress_.Update( progressCounters(cycle_) );
 
-        sendEmploedBees();
-        sendOnlookerBees();
-        sendScoutBees();
+        measurePhase( stats_.employed_time, [this] () { sendEmploedBees(); } );
+        measurePhase( stats_.onlooker_time, [this] () { sendOnlookerBees(); } );
+        measurePhase( stats_.scout_time, [this] () { sendScoutBees(); } );
 
-        memorizeBestSolution();
+        measurePhase( stats_.memorize_time, [this] () { memorizeBestSolution(cycle_); } );
+        cycle_++;
+
+        // Контрольная точка записывается только между циклами: продолжение с нее повторяет следующий цикл точно
+        auto now = std::chrono::steady_clock::now();
+        elapsed_time_ = elapsed_before_start + (now - start);
+        if ( !checkpoint_filename_.empty() && now - last_checkpoint >= checkpoint_interval_ ) {
+            if ( !SaveCheckpoint(checkpoint_filename_) )
+                WriteConsole("\nCannot write checkpoint " + checkpoint_filename_ + "\n");
+            last_checkpoint = now;
+        }
     }
+
+    if ( !checkpoint_filename_.empty() && !SaveCheckpoint(checkpoint_filename_) )
+        WriteConsole("\nCannot write checkpoint " + checkpoint_filename_ + "\n");
+
+    progress_.Finish( progressCounters(cycle_) );
 }
 
 auto CABCOptimizer::GetCurrentBestSolution() {
     return current_best_solution_;
+}
+
+CSolutionSnapshotPtr CABCOptimizer::GetBestSnapshot() const {
+    return best_publisher_.Get();
+}
+
+void CABCOptimizer::SetImprovementCallback(CSolutionPublisher::ImprovementCallback callback) {
+    best_publisher_.SetCallback(std::move(callback));
+}
+
+void CABCOptimizer::SetCheckpoint(const std::string& filename, double interval_seconds) {
+    checkpoint_filename_ = filename;
+    checkpoint_interval_ = std::chrono::duration<double>(interval_seconds);
+}
+
+// Формат: заголовок и версия, размер популяции, пройденные циклы и время, статистика, состояние генератора случайных
+// чисел ( текстом, как его записывает std::mt19937 ), лучшее решение с оценкой, затем решения популяции со счетчиками
+// неудачных попыток. Расписания -- см. CTimeTable::Save.
+bool CABCOptimizer::SaveCheckpoint(const std::string& filename) const {
+    TRACE_SCOPE("ABC checkpoint");
+    // Пишем во временный файл и переименовываем: прерывание во время записи не портит предыдущую точку
+    std::string temporary_filename = filename + ".tmp";
+    std::ofstream file(temporary_filename, std::ios::binary | std::ios::trunc);
+
+    file.write(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    WriteBinary<uint32_t>(file, CHECKPOINT_VERSION);
+    WriteBinary<uint64_t>(file, population_size_);
+    WriteBinary<uint64_t>(file, cycle_);
+    WriteBinary<double>(file, elapsed_time_.count());
+
+    for (const OperatorStats* operator_stats : {&stats_.swap, &stats_.move, &stats_.kempe_swap}) {
+        WriteBinary<uint64_t>(file, operator_stats->attempted);
+        WriteBinary<uint64_t>(file, operator_stats->feasible);
+        WriteBinary<uint64_t>(file, operator_stats->accepted);
+    }
+    WriteBinary<uint64_t>(file, stats_.evaluations);
+    WriteBinary<uint64_t>(file, stats_.copies);
+    WriteBinary<uint64_t>(file, stats_.generator.backtracks);
+    WriteBinary<uint64_t>(file, stats_.generator.restarts);
+    for (const auto& phase_time : {stats_.employed_time, stats_.onlooker_time, stats_.scout_time, stats_.memorize_time})
+        WriteBinary<double>(file, phase_time.count());
+
+    std::ostringstream generator_state;
+    generator_state << RandomGenerator();
+    WriteBinary<uint64_t>(file, generator_state.str().size());
+    file.write(generator_state.str().data(), generator_state.str().size());
+
+    WriteBinary<uint64_t>(file, current_best_solution_.second);
+    current_best_solution_.first.Save(file);
+    for (const auto& [solution, changes_counter] : solutions_) {
+        WriteBinary<uint64_t>(file, changes_counter);
+        solution.Save(file);
+    }
+
+    file.close();
+    if ( !file ) {
+        std::remove( temporary_filename.c_str() );
+        return false;
+    }
+    return std::rename( temporary_filename.c_str(), filename.c_str() ) == 0;
+}
+
+void CABCOptimizer::LoadCheckpoint(const std::string& filename) {
+    TRACE_SCOPE("ABC load checkpoint");
+    std::ifstream file(filename, std::ios::binary);
+    if ( !file.is_open() )
+        throw CBadCheckpoint("Cannot open checkpoint " + filename);
+
+    char magic[sizeof(CHECKPOINT_MAGIC)];
+    file.read(magic, sizeof(magic));
+    if ( !file || std::memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) != 0 )
+        throw CBadCheckpoint(filename + " is not a checkpoint");
+    if ( ReadBinary<uint32_t>(file) != CHECKPOINT_VERSION )
+        throw CBadCheckpoint(filename + " has unsupported checkpoint version");
+    if ( ReadBinary<uint64_t>(file) != population_size_ )
+        throw CBadCheckpoint(filename + " was written for another population size");
+
+    // Все читается во временные объекты и переносится в оптимизатор только после успешного чтения
+    size_t cycle = ReadBinary<uint64_t>(file);
+    std::chrono::duration<double> elapsed_time( ReadBinary<double>(file) );
+
+    ABCStats stats;
+    for (OperatorStats* operator_stats : {&stats.swap, &stats.move, &stats.kempe_swap}) {
+        operator_stats->attempted = ReadBinary<uint64_t>(file);
+        operator_stats->feasible = ReadBinary<uint64_t>(file);
+        operator_stats->accepted = ReadBinary<uint64_t>(file);
+    }
+    stats.evaluations = ReadBinary<uint64_t>(file);
+    stats.copies = ReadBinary<uint64_t>(file);
+    stats.generator.backtracks = ReadBinary<uint64_t>(file);
+    stats.generator.restarts = ReadBinary<uint64_t>(file);
+    for (auto* phase_time : {&stats.employed_time, &stats.onlooker_time, &stats.scout_time, &stats.memorize_time})
+        *phase_time = std::chrono::duration<double>( ReadBinary<double>(file) );
+
+    // Состояние генератора -- несколько килобайт текста; больший размер означает поврежденный файл
+    uint64_t generator_state_size = ReadBinary<uint64_t>(file);
+    if ( !file || generator_state_size > (1 << 16) )
+        throw CBadCheckpoint(filename + " is corrupted");
+    std::string generator_state(generator_state_size, '\0');
+    file.read(&generator_state[0], generator_state_size);
+    std::mt19937 generator;
+    std::istringstream generator_stream(generator_state);
+    generator_stream >> generator;
+    if ( !file || !generator_stream )
+        throw CBadCheckpoint(filename + " is corrupted");
+
+    std::pair<CTimeTable, size_t> best_solution(candidate_, ReadBinary<uint64_t>(file));
+    best_solution.first.Load(file);
+    std::vector< std::pair<CTimeTable, size_t> > solutions;
+    solutions.reserve(population_size_);
+    for (size_t i = 0; i < population_size_; i++) {
+        solutions.emplace_back(candidate_, ReadBinary<uint64_t>(file));
+        solutions.back().first.Load(file);
+    }
+
+    current_best_solution_ = std::move(best_solution);
+    solutions_ = std::move(solutions);
+    cycle_ = cycle;
+    elapsed_time_ = elapsed_time;
+    stats_ = stats;
+    RandomGenerator() = generator;
+
+    best_publisher_.Publish(current_best_solution_.first, current_best_solution_.second, cycle_);
+}
+
+const ABCStats& CABCOptimizer::GetStats() const {
+    return stats_;
+}
+
+void CABCOptimizer::SetProgressSink(std::shared_ptr<CProgressSink> sink, double interval_seconds) {
+    progress_.SetSink(std::move(sink), interval_seconds);
+}
+
+void CABCOptimizer::SetStoppingCriteria(const CStoppingCriteria& stopping_criteria) {
+    stopping_criteria_ = stopping_criteria;
+}
+
+StopReason CABCOptimizer::GetStopReason() const {
+    return stopping_criteria_.GetReason();
 }
\ No newline at end of file
@@ -0,0 +1,69 @@
+#include "CConflictGraph.h"
+
+//______________________________________________________________________________________________________________________
+//______________________________________________________________________________________________________________________
+//
+// CConflictGraph
+//
+//______________________________________________________________________________________________________________________
+//______________________________________________________________________________________________________________________
+
+CConflictGraph::CConflictGraph( size_t subjects_number )
+        : subjects_number_(subjects_number),
+          words_number_( (subjects_number + 63) / 64 ),
+          adjacency_( subjects_number, Row( (subjects_number + 63) / 64, 0 ) ),
+          degrees_( subjects_number, 0 ) {}
+
+//______________________________________________________________________________________________________________________
+// ГЕТТЕРЫ
+//______________________________________________________________________________________________________________________
+
+size_t CConflictGraph::GetSubjectsNumber() const {
+    return subjects_number_;
+}
+
+const CConflictGraph::Row& CConflictGraph::GetNeighbours( size_t subject_index ) const {
+    return adjacency_[subject_index];
+}
+
+size_t CConflictGraph::GetDegree( size_t subject_index ) const {
+    return degrees_[subject_index];
+}
+
+bool CConflictGraph::Conflicting( size_t first_index, size_t second_index ) const {
+    return (adjacency_[first_index][second_index / 64] >> (second_index % 64)) & 1;
+}
+
+bool CConflictGraph::ConflictsWithAny( size_t subject_index, const Row& subjects ) const {
+    const Row& neighbours = adjacency_[subject_index];
+    for (size_t word = 0; word < words_number_; word++)
+        if ( neighbours[word] & subjects[word] )
+            return true;
+    return false;
+}
+
+CConflictGraph::Row CConflictGraph::MakeRow() const {
+    return Row(words_number_, 0);
+}
+
+void CConflictGraph::SetBit( Row& row, size_t subject_index ) {
+    row[subject_index / 64] |= static_cast<uint64_t>(1) << (subject_index % 64);
+}
+
+void CConflictGraph::ResetBit( Row& row, size_t subject_index ) {
+    row[subject_index / 64] &= ~(static_cast<uint64_t>(1) << (subject_index % 64));
+}
+
+//______________________________________________________________________________________________________________________
+// ПОСТРОЕНИЕ
+//______________________________________________________________________________________________________________________
+
+void CConflictGraph::AddConflict( size_t first_index, size_t second_index ) {
+    if ( first_index == second_index || Conflicting(first_index, second_index) )
+        return;
+
+    SetBit(adjacency_[first_index], second_index);
+    SetBit(adjacency_[second_index], first_index);
+    degrees_[first_index]++;
+    degrees_[second_index]++;
+}
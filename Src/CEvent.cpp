@@ -37,7 +37,7 @@ size_t CEvent::GetId() const {
     return subject_->GetId();
 }
 
-CSubject* CEvent::GetSubject() const {
+const CSubject* CEvent::GetSubject() const {
     return subject_;
 }
 
@@ -45,11 +45,11 @@ size_t CEvent::GetStartTime() const {
     return start_time_;
 }
 
-const std::set<CTeacher *const, Comparator<CTeacher>>& CEvent::GetTeachers() const {
+const std::set<const CTeacher *const, Comparator<CTeacher>>& CEvent::GetTeachers() const {
     return subject_->GetTeachers();
 }
 
-const std::set<CCabinet *const, Comparator<CCabinet>>& CEvent::GetCabinets() const {
+const CCabinetSet& CEvent::GetCabinets() const {
     return cabinets_;
 }
 
@@ -62,10 +62,10 @@ bool CEvent::IsActive() const {
 //______________________________________________________________________________________________________________________
 
 void CEvent::SetSubject(const CSubject* subject) {
-    subject_ = const_cast<CSubject*>(subject);
+    subject_ = subject;
 }
 
-void CEvent::SetCabinets(std::set<CCabinet *const, Comparator<CCabinet>> cabinet) {
+void CEvent::SetCabinets(CCabinetSet cabinet) {
     cabinets_ = std::move(cabinet);
 }
 
@@ -83,6 +83,10 @@ void CEvent::FreeEvent() {
     start_time_ = 0;
 }
 
+bool EventComporator::operator() (const CEvent* a, const CEvent* b) const {
+    return a->GetStartTime() < b->GetStartTime();
+}
+
 //______________________________________________________________________________________________________________________
 //______________________________________________________________________________________________________________________
 //
@@ -92,13 +96,13 @@ void CEvent::FreeEvent() {
 //______________________________________________________________________________________________________________________
 
 CEventLinker::CEventLinker( const std::map<std::string, CSubject> &subjects_,
-                            const std::map<std::string, CGroup> &groups_ ) {
+                            const std::map<std::string, CGroup> &groups_ )
+        : linked_events_( groups_.size() ) {
     for ( const auto& [group_name, group] : groups_) {
-        if ( linked_events_.find(group_name) == linked_events_.end() )
-            linked_events_.insert( std::make_pair(group_name, std::map<size_t, std::set<CEvent *, EventComporator> >{}) );
+        auto& group_lists = linked_events_[group.GetIndex()];
         for (const auto& [subject_name, subject] : subjects_)
-            if ( linked_events_.at(group_name).find(subject.GetId()) == linked_events_.at(group_name).end() )
-                linked_events_.at(group_name).insert(std::make_pair(subject.GetId(), std::set<CEvent *, EventComporator>{}));
+            if ( group_lists.find(subject.GetId()) == group_lists.end() )
+                group_lists.insert(std::make_pair(subject.GetId(), CLinkedEvents{}));
     }
 }
 
@@ -114,16 +118,16 @@ const auto& CEventLinker::GetLinkedEvents() const {
 // МОДИФИКАТОРЫ
 //______________________________________________________________________________________________________________________
 
-void CEventLinker::InsertEvent(std::string group_name, CEvent& event) {
-    event.myself_ = linked_events_.at( group_name ).at( event.GetId() ).insert(&event).first;
+void CEventLinker::InsertEvent(size_t group_index, CEvent& event) {
+    event.myself_ = linked_events_[group_index].at( event.GetId() ).insert(&event).first;
 }
 
-void CEventLinker::DeleteEvent(std::string group_name, CEvent& event) {
-    linked_events_.at( group_name ).at( event.GetId() ).erase( event.myself_ );
+void CEventLinker::DeleteEvent(size_t group_index, CEvent& event) {
+    linked_events_[group_index].at( event.GetId() ).erase( event.myself_ );
 }
 
 void CEventLinker::FreeEvents() {
-    for(auto& [group_name, lists] : linked_events_)
+    for(auto& lists : linked_events_)
         for(auto& [id, events] : lists)
             events.clear();
 }
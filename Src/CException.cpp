@@ -30,4 +30,25 @@ const CSubject* CBadSubjectPlacement::GetSubject() {
 
 const CSubject* CBadCabinetsFind::GetSubject() {
     return subject_;
-}
\ No newline at end of file
+}
+
+CParseError::CParseError( std::string filename, size_t line, size_t column, std::string msg )
+                          : CException( line == 0 ? filename + ": " + msg
+                                                  : filename + ":" + std::to_string(line) + ":" +
+                                                    std::to_string(column) + ": " + msg ),
+                          filename_(filename),
+                          line_(line),
+                          column_(column)
+                          {}
+
+const std::string& CParseError::GetFilename() const {
+    return filename_;
+}
+
+size_t CParseError::GetLine() const {
+    return line_;
+}
+
+size_t CParseError::GetColumn() const {
+    return column_;
+}
@@ -0,0 +1,152 @@
+#include "CInputTokenizer.h"
+
+// Размер буфера чтения
+const size_t TOKENIZER_BUFFER_SIZE = 1 << 16;
+
+//______________________________________________________________________________________________________________________
+// ПРИВАТНЫЕ  МЕТОДЫ
+//______________________________________________________________________________________________________________________
+
+int CInputTokenizer::peek() {
+    if (buffer_position_ == buffer_size_) {
+        file_.read(buffer_.data(), buffer_.size());
+        buffer_size_ = static_cast<size_t>(file_.gcount());
+        buffer_position_ = 0;
+        if (buffer_size_ == 0)
+            return -1;
+    }
+    return static_cast<unsigned char>(buffer_[buffer_position_]);
+}
+
+void CInputTokenizer::advance() {
+    char symbol = buffer_[buffer_position_++];
+    if (symbol == '\n') {
+        line_++;
+        column_ = 1;
+    } else if ( (static_cast<unsigned char>(symbol) & 0xC0) != 0x80 ) {
+        // Продолжения многобайтовых символов UTF-8 не сдвигают столбец
+        column_++;
+    }
+}
+
+void CInputTokenizer::skipSpaces() {
+    int symbol;
+    while ( (symbol = peek()) == ' ' || symbol == '\t' || symbol == '\r' )
+        advance();
+}
+
+const std::string& CInputTokenizer::nextToken(const char* expected) {
+    if ( AtEndOfLine() ) {
+        token_line_ = line_;
+        token_column_ = column_;
+        throw Error(std::string("expected ") + expected);
+    }
+
+    token_.clear();
+    token_line_ = line_;
+    token_column_ = column_;
+    int symbol;
+    while ( (symbol = peek()) != -1 && symbol != ' ' && symbol != '\t' && symbol != '\r' && symbol != '\n' ) {
+        token_.push_back(static_cast<char>(symbol));
+        advance();
+    }
+    return token_;
+}
+
+//______________________________________________________________________________________________________________________
+// КОНСТРУКТОРЫ
+//______________________________________________________________________________________________________________________
+
+CInputTokenizer::CInputTokenizer(const std::string& filename)
+        : filename_(filename),
+          file_(filename, std::ios::binary),
+          buffer_(TOKENIZER_BUFFER_SIZE),
+          buffer_position_(0),
+          buffer_size_(0),
+          line_(1),
+          column_(1),
+          token_line_(0),
+          token_column_(0),
+          record_line_(0),
+          record_column_(0) {
+    if ( !file_.is_open() )
+        throw CParseError(filename_, 0, 0, "cannot open file");
+}
+
+//______________________________________________________________________________________________________________________
+// ЧТЕНИЕ
+//______________________________________________________________________________________________________________________
+
+bool CInputTokenizer::NextRecord() {
+    int symbol;
+    while ( (symbol = peek()) == ' ' || symbol == '\t' || symbol == '\r' || symbol == '\n' )
+        advance();
+
+    record_line_ = line_;
+    record_column_ = column_;
+    return symbol != -1;
+}
+
+bool CInputTokenizer::AtEndOfLine() {
+    skipSpaces();
+    int symbol = peek();
+    return symbol == '\n' || symbol == -1;
+}
+
+void CInputTokenizer::ExpectEndOfLine() {
+    if ( !AtEndOfLine() ) {
+        nextToken("");
+        throw Error("unexpected '" + token_ + "'");
+    }
+}
+
+const std::string& CInputTokenizer::ReadName(const char* expected) {
+    return nextToken(expected);
+}
+
+size_t CInputTokenizer::ReadNumber(const char* expected) {
+    nextToken(expected);
+
+    size_t value(0);
+    for (char digit : token_) {
+        if ( digit < '0' || digit > '9' )
+            throw Error(std::string("expected ") + expected + ", got '" + token_ + "'");
+        if ( value > (SIZE_MAX - (digit - '0')) / 10 )
+            throw Error(std::string(expected) + " '" + token_ + "' is too large");
+        value = value * 10 + (digit - '0');
+    }
+    return value;
+}
+
+bool CInputTokenizer::TryReadNumber(const char* expected, size_t& value) {
+    if ( AtEndOfLine() )
+        return false;
+    value = ReadNumber(expected);
+    return true;
+}
+
+int64_t CInputTokenizer::ReadMask(const char* expected, size_t* length) {
+    nextToken(expected);
+
+    if ( token_.size() > sizeof(int64_t) * 8 )
+        throw Error(std::string(expected) + " is longer than 64 time slots");
+
+    int64_t mask(0);
+    for (char bit : token_) {
+        if ( bit != '0' && bit != '1' )
+            throw Error(std::string("expected ") + expected + " of 0 and 1, got '" + token_ + "'");
+        mask = (mask << 1) | (bit - '0');
+    }
+
+    if (length)
+        *length = token_.size();
+    return mask;
+}
+
+CParseError CInputTokenizer::Error(const std::string& message) const {
+    return CParseError(filename_, token_line_, token_column_, message);
+}
+
+CParseError CInputTokenizer::RecordError(const std::string& message) const {
+    return CParseError(filename_, record_line_, record_column_, message);
+}
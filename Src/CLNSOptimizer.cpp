@@ -0,0 +1,75 @@
+#include "CLNSOptimizer.h"
+
+CLNSOptimizer::CLNSOptimizer( CTimeTable& timetable, size_t maximum_iteration_number, double time_budget_seconds )
+        : current_best_solution_( std::make_pair(timetable, 0) ),
+          candidate_(timetable),
+          iteration_(0),
+          evaluations_number_(0),
+          accepted_number_(0),
+          progress_("LNS") {
+
+    stopping_criteria_.SetIterationLimit(maximum_iteration_number).SetTimeBudget(time_budget_seconds);
+
+    current_best_solution_.first.GenerateTimeTable();
+    current_best_solution_.second = cost_function_.Value(current_best_solution_.first);
+}
+
+void CLNSOptimizer::makeStep() {
+    TRACE_SCOPE("LNS step");
+    const RuinType ruin_types[] = { RuinType::Day, RuinType::Teacher, RuinType::Group };
+
+    iteration_++;
+    candidate_ = current_best_solution_.first;
+    if ( !candidate_.RuinAndRecreate( ruin_types[RandomIndex(3)] ) )
+        return;
+
+    // Равные по стоимости решения тоже принимаем, чтобы перемещаться по плато
+    int new_cost = cost_function_.Value(candidate_);
+    evaluations_number_++;
+    if ( new_cost <= static_cast<int>(current_best_solution_.second) ) {
+        accepted_number_++;
+        current_best_solution_.first = candidate_;
+        current_best_solution_.second = new_cost;
+    }
+}
+
+ProgressCounters CLNSOptimizer::progressCounters() const {
+    ProgressCounters counters;
+    counters.iteration = iteration_;
+    counters.maximum_iteration_number = stopping_criteria_.GetIterationLimit();
+    counters.best_cost = current_best_solution_.second;
+    counters.evaluations = evaluations_number_;
+    counters.attempted = iteration_;
+    counters.accepted = accepted_number_;
+    return counters;
+}
+
+void CLNSOptimizer::FindOptimal() {
+    progress_.Start();
+    stopping_criteria_.Start(current_best_solution_.second);
+
+    for (size_t i = 0; !stopping_criteria_.ShouldStop(i, current_best_solution_.second); i++) {
+
+        progress_.Update( progressCounters() );
+
+        makeStep();
+    }
+
+    progress_.Finish( progressCounters() );
+}
+
+auto CLNSOptimizer::GetCurrentBestSolution() {
+    return current_best_solution_;
+}
+
+void CLNSOptimizer::SetProgressSink(std::shared_ptr<CProgressSink> sink, double interval_seconds) {
+    progress_.SetSink(std::move(sink), interval_seconds);
+}
+
+void CLNSOptimizer::SetStoppingCriteria(const CStoppingCriteria& stopping_criteria) {
+    stopping_criteria_ = stopping_criteria;
+}
+
+StopReason CLNSOptimizer::GetStopReason() const {
+    return stopping_criteria_.GetReason();
+}
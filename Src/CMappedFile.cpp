@@ -0,0 +1,98 @@
+#include "CMappedFile.h"
+#include "CException.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//______________________________________________________________________________________________________________________
+//______________________________________________________________________________________________________________________
+//
+// CMappedFile
+//
+//______________________________________________________________________________________________________________________
+//______________________________________________________________________________________________________________________
+
+CMappedFile::CMappedFile(const std::string& filename)
+        : data_(nullptr),
+          size_(0) {
+    int descriptor = open(filename.c_str(), O_RDONLY);
+    if (descriptor < 0)
+        throw CException("Cannot open " + filename);
+
+    struct stat file_stat {};
+    if ( fstat(descriptor, &file_stat) != 0 ) {
+        close(descriptor);
+        throw CException("Cannot read " + filename);
+    }
+
+    // Пустой файл отобразить нельзя; он читается как пустой буфер
+    size_ = static_cast<size_t>(file_stat.st_size);
+    if (size_ > 0) {
+        void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (data == MAP_FAILED) {
+            close(descriptor);
+            throw CException("Cannot map " + filename);
+        }
+        data_ = static_cast<const char*>(data);
+    }
+
+    // Отображение остается действительным и после закрытия дескриптора
+    close(descriptor);
+}
+
+CMappedFile::~CMappedFile() {
+    if (data_)
+        munmap(const_cast<char*>(data_), size_);
+}
+
+const char* CMappedFile::GetData() const {
+    return data_;
+}
+
+size_t CMappedFile::GetSize() const {
+    return size_;
+}
+
+//______________________________________________________________________________________________________________________
+//______________________________________________________________________________________________________________________
+//
+// CMemoryReader
+//
+//______________________________________________________________________________________________________________________
+//______________________________________________________________________________________________________________________
+
+CMemoryReader::CMemoryReader(const char* data, size_t size)
+        : position_(data),
+          end_(data + size),
+          valid_(true) {}
+
+bool CMemoryReader::take(size_t size) {
+    if ( !valid_ || static_cast<size_t>(end_ - position_) < size ) {
+        valid_ = false;
+        return false;
+    }
+    position_ += size;
+    return true;
+}
+
+std::string CMemoryReader::ReadString() {
+    uint32_t length = Read<uint32_t>();
+    const char* position = position_;
+    if ( !take(length) )
+        return std::string();
+    return std::string(position, length);
+}
+
+bool CMemoryReader::Expect(const char* bytes, size_t size) {
+    const char* position = position_;
+    return take(size) && std::memcmp(position, bytes, size) == 0;
+}
+
+bool CMemoryReader::IsValid() const {
+    return valid_;
+}
+
+bool CMemoryReader::IsAtEnd() const {
+    return position_ == end_;
+}
@@ -8,15 +8,23 @@ const int WINDOW_PENALTY = 100;
 const int SAME_DAY_PENALTY = 100;
 
 int CObjectiveFunction::Value(const CTimeTable &timetable) {
+    return DispatchWeekGeometry( timetable.days_in_week_, timetable.lessons_in_day_,
+                                 [&timetable] (const auto& geometry) { return value(timetable, geometry); } );
+}
+
+template <class Geometry>
+int CObjectiveFunction::value(const CTimeTable &timetable, const Geometry& geometry) {
+    const size_t days_in_week = geometry.DaysInWeek();
+    const size_t lessons_in_day = geometry.LessonsInDay();
 
     int value(0);
 
-    for (int day = 0; day < timetable.days_in_week_; day++) {
-        for (const auto& [name, group] : timetable.time_table_) {
+    for (size_t day = 0; day < days_in_week; day++) {
+        for (const auto& group : timetable.time_table_) {
             bool window_flag (false);
-            for (int lesson = static_cast<int>(timetable.lessons_in_day_)-1; lesson > -1; lesson--) {
+            for (int lesson = static_cast<int>(lessons_in_day)-1; lesson > -1; lesson--) {
 
-                if ( group[day * timetable.lessons_in_day_ + lesson].IsActive() ) {
+                if ( group[day * lessons_in_day + lesson].IsActive() ) {
                     if (!window_flag) {
                         window_flag = true;
                     }
@@ -30,11 +38,11 @@ int CObjectiveFunction::Value(const CTimeTable &timetable) {
         }
     }
 
-    for (const auto& [group_name, group] : timetable.event_linker_.GetLinkedEvents())
+    for (const auto& group : timetable.event_linker_.GetLinkedEvents())
         for (const auto& [id, events_list] : group) {
             if (!events_list.size())
                 break;
-            int etalon_interval (timetable.days_in_week_ * timetable.lessons_in_day_ / events_list.size());
+            int etalon_interval (geometry.TimeSlotsNumber() / events_list.size());
             int current_interval(0);
             auto prev_event (*events_list.begin());
 
@@ -44,8 +52,8 @@ int CObjectiveFunction::Value(const CTimeTable &timetable) {
 
                 value += 7 * abs(current_interval-etalon_interval);
 
-                if ( event->GetStartTime() / timetable.lessons_in_day_ ==
-                     prev_event->GetStartTime() / timetable.lessons_in_day_ )
+                if ( event->GetStartTime() / lessons_in_day ==
+                     prev_event->GetStartTime() / lessons_in_day )
                     value += SAME_DAY_PENALTY;
 
                 prev_event = event;
@@ -0,0 +1,114 @@
+#include "COccupancy.h"
+#include "CWeekGeometry.h"
+
+//______________________________________________________________________________________________________________________
+//______________________________________________________________________________________________________________________
+//
+// COccupancy
+//
+//______________________________________________________________________________________________________________________
+//______________________________________________________________________________________________________________________
+
+COccupancy::COccupancy( const std::map< std::string, CTeacher >& teachers,
+                        const std::map< std::string, CGroup >& groups,
+                        const std::map< std::string, CCabinet >& cabinets )
+        : teachers_time_(teachers.size()),
+          groups_time_(groups.size()),
+          cabinets_time_(cabinets.size()) {
+    for (const auto& [name, teacher] : teachers)
+        teachers_time_[teacher.GetIndex()] = teacher.GetAvailableTime();
+    for (const auto& [name, group] : groups)
+        groups_time_[group.GetIndex()] = group.GetAvailableTime();
+    for (const auto& [name, cabinet] : cabinets)
+        cabinets_time_[cabinet.GetIndex()] = cabinet.GetAvailableTime();
+}
+
+//______________________________________________________________________________________________________________________
+// ГЕТТЕРЫ
+//______________________________________________________________________________________________________________________
+
+int64_t COccupancy::GetTeacherTime(const CTeacher* teacher) const {
+    return teachers_time_[teacher->GetIndex()];
+}
+
+int64_t COccupancy::GetGroupTime(const CGroup* group) const {
+    return groups_time_[group->GetIndex()];
+}
+
+int64_t COccupancy::GetCabinetTime(const CCabinet* cabinet) const {
+    return cabinets_time_[cabinet->GetIndex()];
+}
+
+bool COccupancy::IsCabinetFeasible(const CCabinet* cabinet, size_t start_time, size_t duration) const {
+    // Маска времени: duration единиц, начиная с бита start_time, считая началом младшие биты. Например, для
+    // start_time = 5 и duration 2 получим:
+    // 0000000000000000000000000000000000000000000000000000000001100000.
+    // Если кабинет действительно доступен на duration со start_time, то под маской в его свободном времени стоят
+    // единицы, и логическое И превратит свободное время в саму маску.
+    int64_t time_mask = TimeMask(start_time, duration);
+    return (time_mask & cabinets_time_[cabinet->GetIndex()]) == time_mask;
+}
+
+int64_t COccupancy::GetSubjectAvailableTime(const CSubject* subject) const {
+    int64_t resulting_available_time( LLONG_MAX & subject->GetFeasibleTime() );
+
+    for (const auto& teacher : subject->GetTeachers())
+        resulting_available_time &= teachers_time_[teacher->GetIndex()];
+    for (const auto& group : subject->GetGroups())
+        resulting_available_time &= groups_time_[group->GetIndex()];
+
+    return resulting_available_time;
+}
+
+int64_t COccupancy::GetSubjectAvailableStartTime( const CSubject* subject,
+                                                  size_t days_in_week, size_t lessons_in_day ) const {
+    return subject->GetAvailableStartTime( GetSubjectAvailableTime(subject), days_in_week, lessons_in_day );
+}
+
+size_t COccupancy::GetSubjectAvailableTimeSize(const CSubject* subject) const {
+    return BitsNumber( GetSubjectAvailableTime(subject) );
+}
+
+//______________________________________________________________________________________________________________________
+// МЕТОДЫ  ДЛЯ  РАБОТЫ  С  ЗАНИМАЕМЫМ  И  ОСВОБОЖДАЕМЫМ  ВРЕМЕНЕМ
+//______________________________________________________________________________________________________________________
+
+// Занимаемое время обнуляется логическим И с инвертированной маской, освобождаемое -- выставляется в единицы
+// логическим ИЛИ с маской
+void COccupancy::ReserveTeacher(const CTeacher* teacher, size_t start_time, size_t duration) {
+    teachers_time_[teacher->GetIndex()] &= ~TimeMask(start_time, duration);
+}
+
+void COccupancy::ReleaseTeacher(const CTeacher* teacher, size_t start_time, size_t duration) {
+    teachers_time_[teacher->GetIndex()] |= TimeMask(start_time, duration);
+}
+
+void COccupancy::ReserveGroup(const CGroup* group, size_t start_time, size_t duration) {
+    groups_time_[group->GetIndex()] &= ~TimeMask(start_time, duration);
+}
+
+void COccupancy::ReleaseGroup(const CGroup* group, size_t start_time, size_t duration) {
+    groups_time_[group->GetIndex()] |= TimeMask(start_time, duration);
+}
+
+void COccupancy::ReserveCabinet(const CCabinet* cabinet, size_t start_time, size_t duration) {
+    cabinets_time_[cabinet->GetIndex()] &= ~TimeMask(start_time, duration);
+}
+
+void COccupancy::ReleaseCabinet(const CCabinet* cabinet, size_t start_time, size_t duration) {
+    cabinets_time_[cabinet->GetIndex()] |= TimeMask(start_time, duration);
+}
+
+void COccupancy::ReserveSubject(const CSubject* subject, size_t start_time) {
+    for (const auto& teacher : subject->GetTeachers())
+        ReserveTeacher(teacher, start_time, subject->GetDuration());
+    for (const auto& group : subject->GetGroups())
+        ReserveGroup(group, start_time, subject->GetDuration());
+}
+
+void COccupancy::ReleaseSubject(const CSubject* subject, size_t start_time) {
+    for (const auto& teacher : subject->GetTeachers())
+        ReleaseTeacher(teacher, start_time, subject->GetDuration());
+    for (const auto& group : subject->GetGroups())
+        ReleaseGroup(group, start_time, subject->GetDuration());
+}
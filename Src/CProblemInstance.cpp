@@ -0,0 +1,116 @@
+#include "CProblemInstance.h"
+
+//______________________________________________________________________________________________________________________
+//______________________________________________________________________________________________________________________
+//
+// CProblemInstance
+//
+//______________________________________________________________________________________________________________________
+//______________________________________________________________________________________________________________________
+
+CProblemInstance::CProblemInstance( const std::map< std::string, CTeacher >& teachers,
+                                    const std::map< std::string, CCabinet >& cabinets,
+                                    const std::map< std::string, CGroup >& groups,
+                                    const std::map< std::string, CSubject >& subjects,
+                                    std::shared_ptr<const CConflictGraph> conflict_graph,
+                                    size_t days_in_week, size_t lessons_in_day )
+        : teachers_(teachers),
+          cabinets_(cabinets),
+          groups_(groups),
+          days_in_week_(days_in_week),
+          lessons_in_day_(lessons_in_day),
+          conflict_graph_(std::move(conflict_graph)),
+          fingerprint_(FNV_OFFSET_BASIS) {
+
+    // Для копирования в teachers_, cabinets_ и groups_ можно воспользоваться конструктором по умолчанию, так как
+    // достаточно поверхностного копирования. Для копирования в subjects_ нужно "переподвязать"
+    // соответсвующие указатели.
+    IndexByName(teachers_);
+    IndexByName(cabinets_);
+    IndexByName(groups_);
+
+    for (auto& pair : subjects) {
+        const CSubject& subject = pair.second;
+        CSubjectBuilder subject_builder;
+
+        subject_builder.SetFromSubject(subject);
+        subject_builder.SetSubjectName(subject.GetName());
+        // Предметы нумеруются подряд в порядке имен
+        subject_builder.SetSubjectIndex(subjects_.size());
+
+        std::set< const CGroup *const, Comparator<CGroup> > subject_groups;
+        for (auto& subject_group : subject.GetGroups())
+            subject_groups.insert( &groups_.at(subject_group->GetName()) );
+
+        CCabinetSet subject_cabinets;
+        for (auto& subject_cabinet : subject.GetCabinets())
+            subject_cabinets.insert( &cabinets_.at(subject_cabinet->GetName()) );
+
+        std::set< const CTeacher *const, Comparator<CTeacher> > subject_teachers;
+        for (auto& subject_teacher : subject.GetTeachers())
+            subject_teachers.insert( &teachers_.at(subject_teacher->GetName()) );
+
+        subject_builder.SetSubjectGroups(subject_groups);
+        subject_builder.SetSubjectTeachers(subject_teachers);
+        subject_builder.SetSubjectCabinets(subject_cabinets);
+
+        subjects_.insert( std::make_pair(pair.first, subject_builder.Build()) );
+    }
+
+    HashValue<uint64_t>(fingerprint_, days_in_week_);
+    HashValue<uint64_t>(fingerprint_, lessons_in_day_);
+    for (const auto& [name, teacher] : teachers_)
+        HashString(fingerprint_, name);
+    for (const auto& [name, cabinet] : cabinets_)
+        HashString(fingerprint_, name);
+    for (const auto& [name, group] : groups_)
+        HashString(fingerprint_, name);
+    // Связи хешируются номерами, которые однозначно задаются именами выше
+    for (const auto& [name, subject] : subjects_) {
+        HashString(fingerprint_, name);
+        HashValue<uint64_t>(fingerprint_, subject.GetDuration());
+        HashValue<uint64_t>(fingerprint_, subject.GetRequiredCabinetsNumber());
+        for (const auto& teacher : subject.GetTeachers())
+            HashValue<uint64_t>(fingerprint_, teacher->GetIndex());
+        for (const auto& group : subject.GetGroups())
+            HashValue<uint64_t>(fingerprint_, group->GetIndex());
+        for (const auto& cabinet : subject.GetCabinets())
+            HashValue<uint64_t>(fingerprint_, cabinet->GetIndex());
+    }
+}
+
+//______________________________________________________________________________________________________________________
+// ГЕТТЕРЫ
+//______________________________________________________________________________________________________________________
+
+const std::map< std::string, CTeacher >& CProblemInstance::GetTeachers() const {
+    return teachers_;
+}
+
+const std::map< std::string, CCabinet >& CProblemInstance::GetCabinets() const {
+    return cabinets_;
+}
+
+const std::map< std::string, CGroup >& CProblemInstance::GetGroups() const {
+    return groups_;
+}
+
+const std::map< std::string, CSubject >& CProblemInstance::GetSubjects() const {
+    return subjects_;
+}
+
+size_t CProblemInstance::GetDaysInWeek() const {
+    return days_in_week_;
+}
+
+size_t CProblemInstance::GetLessonsInDay() const {
+    return lessons_in_day_;
+}
+
+const CConflictGraph& CProblemInstance::GetConflictGraph() const {
+    return *conflict_graph_;
+}
+
+uint64_t CProblemInstance::GetFingerprint() const {
+    return fingerprint_;
+}
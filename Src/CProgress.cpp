@@ -0,0 +1,227 @@
+#include "CProgress.h"
+
+#include <iostream>
+#include <sstream>
+
+// Общий для WriteConsole и CConsoleProgressSink
+static std::mutex& ConsoleMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+void WriteConsole(const std::string& text) {
+    std::lock_guard<std::mutex> lock( ConsoleMutex() );
+    std::cout << text << std::flush;
+}
+
+// Строка JSON в кавычках. Имя задачи -- имя папки, в нем могут быть кавычки и обратные косые черты; управляющие
+// символы заменяются пробелами.
+static std::string JsonString(const std::string& text) {
+    std::string result("\"");
+    for (char c : text) {
+        if (c == '"' || c == '\\')
+            result += '\\';
+        if ( static_cast<unsigned char>(c) < 0x20 )
+            result += ' ';
+        else
+            result += c;
+    }
+    return result + '"';
+}
+
+//______________________________________________________________________________________________________________________
+//______________________________________________________________________________________________________________________
+//
+// CConsoleProgressSink
+//
+//______________________________________________________________________________________________________________________
+//______________________________________________________________________________________________________________________
+
+void CConsoleProgressSink::Report(const ProgressReport& report) {
+    // Строка собирается заранее, чтобы под мьютексом только вывести ее
+    std::ostringstream line;
+    line << "\r" << report.optimizer << ": ";
+    // Без предела итераций доля выполненной работы неизвестна
+    if (report.maximum_iteration_number)
+        line << static_cast<double>(report.iteration) / report.maximum_iteration_number * 100 << "% completed.";
+    else
+        line << report.iteration << " iterations.";
+    line << "     Current best score: " << report.best_cost
+         << "     Evaluations/s: " << static_cast<size_t>(report.evaluations_per_second)
+         << "     Accepted: " << report.acceptance_rate * 100 << "%";
+
+    if (report.final)
+        line << "\n";
+    WriteConsole( line.str() );
+}
+
+//______________________________________________________________________________________________________________________
+//______________________________________________________________________________________________________________________
+//
+// CJsonLinesProgressSink
+//
+//______________________________________________________________________________________________________________________
+//______________________________________________________________________________________________________________________
+
+CJsonLinesProgressSink::CJsonLinesProgressSink(const std::string& filename)
+        : file_(filename),
+          stopping_(false),
+          writer_( [this] () { write(); } ) {}
+
+CJsonLinesProgressSink::~CJsonLinesProgressSink() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    queue_changed_.notify_one();
+    writer_.join();
+}
+
+void CJsonLinesProgressSink::Report(const ProgressReport& report) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(report);
+    }
+    queue_changed_.notify_one();
+}
+
+void CJsonLinesProgressSink::write() {
+    std::vector<ProgressReport> reports;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            queue_changed_.wait( lock, [this] () { return stopping_ || !queue_.empty(); } );
+            if ( stopping_ && queue_.empty() )
+                return;
+            reports.swap(queue_);
+        }
+
+        for (const auto& report : reports)
+            file_ << "{\"optimizer\":\"" << report.optimizer << "\""
+                  << ",\"job\":" << JsonString(report.job)
+                  << ",\"component\":" << report.component
+                  << ",\"iteration\":" << report.iteration
+                  << ",\"maximum_iteration_number\":" << report.maximum_iteration_number
+                  << ",\"elapsed_seconds\":" << report.elapsed_seconds
+                  << ",\"best_cost\":" << report.best_cost
+                  << ",\"evaluations_per_second\":" << report.evaluations_per_second
+                  << ",\"acceptance_rate\":" << report.acceptance_rate
+                  << ",\"final\":" << (report.final ? "true" : "false") << "}\n";
+        reports.clear();
+
+        // Строки должны быть видны читателю файла сразу, а отчеты редкие
+        file_.flush();
+    }
+}
+
+//______________________________________________________________________________________________________________________
+//______________________________________________________________________________________________________________________
+//
+// CLabelledProgressSink
+//
+//______________________________________________________________________________________________________________________
+//______________________________________________________________________________________________________________________
+
+CLabelledProgressSink::CLabelledProgressSink(std::shared_ptr<CProgressSink> sink, std::string job, size_t component)
+        : sink_(std::move(sink)),
+          job_(std::move(job)),
+          component_(component) {}
+
+void CLabelledProgressSink::Report(const ProgressReport& report) {
+    ProgressReport labelled(report);
+    labelled.job = job_;
+    labelled.component = component_;
+    sink_->Report(labelled);
+}
+
+//______________________________________________________________________________________________________________________
+//______________________________________________________________________________________________________________________
+//
+// CLatestProgressSink
+//
+//______________________________________________________________________________________________________________________
+//______________________________________________________________________________________________________________________
+
+CLatestProgressSink::CLatestProgressSink()
+        : report_(),
+          reported_(false) {}
+
+void CLatestProgressSink::Report(const ProgressReport& report) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    report_ = report;
+    reported_ = true;
+}
+
+bool CLatestProgressSink::Get(ProgressReport& report) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (reported_)
+        report = report_;
+    return reported_;
+}
+
+//______________________________________________________________________________________________________________________
+//______________________________________________________________________________________________________________________
+//
+// CProgressReporter
+//
+//______________________________________________________________________________________________________________________
+//______________________________________________________________________________________________________________________
+
+CProgressReporter::CProgressReporter( const char* optimizer, std::shared_ptr<CProgressSink> sink,
+                                      double interval_seconds )
+        : optimizer_(optimizer),
+          sink_(std::move(sink)),
+          interval_(interval_seconds),
+          start_(std::chrono::steady_clock::now()),
+          last_report_(start_) {}
+
+void CProgressReporter::SetSink(std::shared_ptr<CProgressSink> sink, double interval_seconds) {
+    sink_ = std::move(sink);
+    interval_ = std::chrono::duration<double>(interval_seconds);
+}
+
+void CProgressReporter::Start() {
+    start_ = last_report_ = std::chrono::steady_clock::now();
+    last_counters_ = ProgressCounters();
+}
+
+void CProgressReporter::Update(const ProgressCounters& counters) {
+    if (!sink_)
+        return;
+
+    auto now = std::chrono::steady_clock::now();
+    if (now - last_report_ < interval_)
+        return;
+
+    report(counters, now, false);
+}
+
+void CProgressReporter::Finish(const ProgressCounters& counters) {
+    if (!sink_)
+        return;
+
+    report(counters, std::chrono::steady_clock::now(), true);
+}
+
+void CProgressReporter::report( const ProgressCounters& counters, std::chrono::steady_clock::time_point now,
+                                bool final ) {
+    double window = std::chrono::duration<double>(now - last_report_).count();
+    size_t evaluations = counters.evaluations - last_counters_.evaluations;
+    size_t attempted = counters.attempted - last_counters_.attempted;
+    size_t accepted = counters.accepted - last_counters_.accepted;
+
+    ProgressReport progress_report {
+        optimizer_,
+        counters.iteration,
+        counters.maximum_iteration_number,
+        std::chrono::duration<double>(now - start_).count(),
+        counters.best_cost,
+        window > 0 ? evaluations / window : 0,
+        attempted > 0 ? static_cast<double>(accepted) / attempted : 0,
+        final
+    };
+    sink_->Report(progress_report);
+
+    last_report_ = now;
+    last_counters_ = counters;
+}
@@ -0,0 +1,139 @@
+#include "CSAOptimizer.h"
+
+#include <cmath>
+
+CSAOptimizer::CSAOptimizer( CTimeTable& timetable, double initial_temperature, double final_temperature,
+                            double cooling_rate, CoolingSchedule cooling_schedule, size_t maximum_iteration_number,
+                            size_t reheat_limit, double reheat_ratio, double time_budget_seconds )
+        : current_solution_( std::make_pair(timetable, 0) ),
+          current_best_solution_( std::make_pair(timetable, 0) ),
+          candidate_(timetable),
+          initial_temperature_(initial_temperature),
+          final_temperature_(final_temperature),
+          cooling_rate_(cooling_rate),
+          cooling_schedule_(cooling_schedule),
+          maximum_iteration_number_(maximum_iteration_number),
+          reheat_limit_(reheat_limit),
+          reheat_ratio_(reheat_ratio),
+          temperature_(initial_temperature),
+          reheat_temperature_(initial_temperature),
+          schedule_step_(0),
+          iterations_without_improvement_(0),
+          steps_number_(0),
+          accepted_number_(0),
+          random_generator_( std::random_device()() ),
+          progress_("SA") {
+
+    stopping_criteria_.SetIterationLimit(maximum_iteration_number).SetTimeBudget(time_budget_seconds);
+
+    current_solution_.first.GenerateTimeTable();
+    current_solution_.second = cost_function_.Value(current_solution_.first);
+    current_best_solution_ = current_solution_;
+}
+
+void CSAOptimizer::coolDown() {
+    schedule_step_++;
+
+    switch (cooling_schedule_) {
+        case CoolingSchedule::Geometric:
+            temperature_ *= cooling_rate_;
+            break;
+        case CoolingSchedule::Linear:
+            temperature_ = reheat_temperature_ - (reheat_temperature_ - final_temperature_) *
+                           static_cast<double>(schedule_step_) / maximum_iteration_number_;
+            break;
+        case CoolingSchedule::Logarithmic:
+            temperature_ = reheat_temperature_ / (1 + cooling_rate_ * std::log(1 + schedule_step_));
+            break;
+    }
+
+    // Остывшая система больше не принимает ухудшений, поэтому нагреваем ее, даже если лимит не исчерпан
+    if ( temperature_ < final_temperature_ || iterations_without_improvement_ > reheat_limit_ )
+        reheat();
+}
+
+void CSAOptimizer::reheat() {
+    // Законы охлаждения отсчитываются от температуры нагрева, иначе первый же шаг вернул бы начальную температуру
+    reheat_temperature_ = std::max(reheat_ratio_ * initial_temperature_, final_temperature_);
+    temperature_ = reheat_temperature_;
+    schedule_step_ = 0;
+    iterations_without_improvement_ = 0;
+}
+
+bool CSAOptimizer::accept(int delta) {
+    if (delta < 0)
+        return true;
+
+    std::uniform_real_distribution<double> distribution(0, 1);
+    return distribution(random_generator_) < std::exp( -delta / temperature_ );
+}
+
+void CSAOptimizer::makeStep() {
+    TRACE_SCOPE("SA step");
+    candidate_ = current_solution_.first;
+
+    std::uniform_int_distribution<int> distribution(0, 999);
+    if (distribution(random_generator_) < 600) {
+        candidate_.RandomSwap();
+    } else {
+        candidate_.RandomMove();
+    }
+
+    int new_cost = cost_function_.Value(candidate_);
+    iterations_without_improvement_++;
+    steps_number_++;
+
+    if ( !accept(new_cost - static_cast<int>(current_solution_.second)) )
+        return;
+
+    accepted_number_++;
+    current_solution_.first = candidate_;
+    current_solution_.second = new_cost;
+
+    if ( new_cost < static_cast<int>(current_best_solution_.second) ) {
+        current_best_solution_ = current_solution_;
+        iterations_without_improvement_ = 0;
+    }
+}
+
+ProgressCounters CSAOptimizer::progressCounters() const {
+    ProgressCounters counters;
+    counters.iteration = steps_number_;
+    counters.maximum_iteration_number = stopping_criteria_.GetIterationLimit();
+    counters.best_cost = current_best_solution_.second;
+    counters.evaluations = steps_number_;
+    counters.attempted = steps_number_;
+    counters.accepted = accepted_number_;
+    return counters;
+}
+
+void CSAOptimizer::FindOptimal() {
+    progress_.Start();
+    stopping_criteria_.Start(current_best_solution_.second);
+
+    for (size_t i = 0; !stopping_criteria_.ShouldStop(i, current_best_solution_.second); i++) {
+
+        progress_.Update( progressCounters() );
+
+        makeStep();
+        coolDown();
+    }
+
+    progress_.Finish( progressCounters() );
+}
+
+auto CSAOptimizer::GetCurrentBestSolution() {
+    return current_best_solution_;
+}
+
+void CSAOptimizer::SetProgressSink(std::shared_ptr<CProgressSink> sink, double interval_seconds) {
+    progress_.SetSink(std::move(sink), interval_seconds);
+}
+
+void CSAOptimizer::SetStoppingCriteria(const CStoppingCriteria& stopping_criteria) {
+    stopping_criteria_ = stopping_criteria;
+}
+
+StopReason CSAOptimizer::GetStopReason() const {
+    return stopping_criteria_.GetReason();
+}
@@ -0,0 +1,372 @@
+#include "CSchedulingServer.h"
+#include "CException.h"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Флаг остановки проверяется не реже раза в POLL_INTERVAL_MILLISECONDS
+const int POLL_INTERVAL_MILLISECONDS = 200;
+// Соединения обслуживаются по очереди, поэтому на весь запрос вместе с ответом дается не больше
+// REQUEST_TIMEOUT_SECONDS: медленный клиент, присылающий по байту, не задержит остальных дольше
+const double REQUEST_TIMEOUT_SECONDS = 10;
+const size_t MAX_LINE_SIZE = 4096;
+const size_t MAX_FILE_SIZE = 64 * 1024 * 1024;
+
+// Запись в закрытое клиентом соединение не должна завершать процесс сигналом SIGPIPE
+#ifdef MSG_NOSIGNAL
+const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+const int SEND_FLAGS = 0;
+#endif
+
+//______________________________________________________________________________________________________________________
+//______________________________________________________________________________________________________________________
+//
+// CSocketConnection
+//
+//______________________________________________________________________________________________________________________
+//______________________________________________________________________________________________________________________
+
+CSocketConnection::CSocketConnection(int descriptor, double timeout_seconds)
+        : descriptor_(descriptor),
+          deadline_( std::chrono::steady_clock::now() +
+                     std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                             std::chrono::duration<double>(timeout_seconds) ) ),
+          position_(0),
+          valid_(true) {
+#ifdef SO_NOSIGPIPE
+    int on = 1;
+    setsockopt(descriptor_, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+}
+
+CSocketConnection::~CSocketConnection() {
+    close(descriptor_);
+}
+
+bool CSocketConnection::wait(short events) {
+    while (true) {
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline_ - std::chrono::steady_clock::now() ).count();
+        if (remaining <= 0)
+            return false;
+
+        pollfd connection { descriptor_, events, 0 };
+        int ready = poll( &connection, 1, static_cast<int>( std::min<long long>(remaining, INT_MAX) ) );
+        if (ready < 0 && errno == EINTR)
+            continue;
+        // Ошибку или закрытие соединения покажет следующий recv или send
+        return ready > 0;
+    }
+}
+
+bool CSocketConnection::fill() {
+    if (!valid_)
+        return false;
+
+    char chunk[64 * 1024];
+    ssize_t received;
+    do {
+        if ( !wait(POLLIN) ) {
+            valid_ = false;
+            return false;
+        }
+        received = recv(descriptor_, chunk, sizeof(chunk), MSG_DONTWAIT);
+    } while ( received < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) );
+
+    if (received <= 0) {
+        valid_ = false;
+        return false;
+    }
+    buffer_.erase(0, position_);
+    position_ = 0;
+    buffer_.append(chunk, static_cast<size_t>(received));
+    return true;
+}
+
+bool CSocketConnection::ReadLine(std::string& line, size_t max_size) {
+    while (true) {
+        size_t end = buffer_.find('\n', position_);
+        if (end != std::string::npos) {
+            line.assign(buffer_, position_, end - position_);
+            position_ = end + 1;
+            // Клиенты вроде telnet заканчивают строки "\r\n"
+            if ( !line.empty() && line.back() == '\r' )
+                line.pop_back();
+            return true;
+        }
+        if (buffer_.size() - position_ > max_size) {
+            valid_ = false;
+            return false;
+        }
+        if ( !fill() )
+            return false;
+    }
+}
+
+bool CSocketConnection::ReadBytes(std::string& bytes, size_t size) {
+    while (buffer_.size() - position_ < size)
+        if ( !fill() )
+            return false;
+
+    bytes.assign(buffer_, position_, size);
+    position_ += size;
+    return true;
+}
+
+bool CSocketConnection::Write(const std::string& data) {
+    size_t written = 0;
+    while (written < data.size()) {
+        if ( !wait(POLLOUT) )
+            return false;
+        ssize_t sent = send( descriptor_, data.data() + written, data.size() - written,
+                             SEND_FLAGS | MSG_DONTWAIT );
+        if ( sent < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) )
+            continue;
+        if (sent <= 0)
+            return false;
+        written += static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+//______________________________________________________________________________________________________________________
+//______________________________________________________________________________________________________________________
+//
+// CSchedulingServer
+//
+//______________________________________________________________________________________________________________________
+//______________________________________________________________________________________________________________________
+
+// Ответ занимает одну строку, поэтому переводы строк в сообщениях заменяются пробелами
+static std::string OneLine(std::string text) {
+    std::replace(text.begin(), text.end(), '\n', ' ');
+    std::replace(text.begin(), text.end(), '\r', ' ');
+    return text;
+}
+
+static std::string FormatStatus(const JobStatus& status) {
+    std::ostringstream stream;
+    stream << "id=" << status.id
+           << " state=" << JobStateName(status.state)
+           << " priority=" << status.priority
+           << " seconds=" << std::fixed << std::setprecision(1) << status.seconds;
+    if (status.has_progress)
+        stream << " optimizer=" << status.progress.optimizer
+               << " component=" << status.progress.component
+               << " iteration=" << status.progress.iteration
+               << " best_cost=" << status.progress.best_cost;
+    if (status.has_provisional)
+        stream << " provisional_cost=" << status.provisional_cost;
+    if (status.has_result)
+        stream << " cost=" << status.cost;
+    stream << " name=" << OneLine(status.name);
+    if ( !status.message.empty() )
+        stream << " message=" << OneLine(status.message);
+    return stream.str();
+}
+
+static size_t ReadJobId(std::istringstream& request) {
+    size_t id;
+    if ( !(request >> id) )
+        throw CException("expected job id");
+    return id;
+}
+
+static int ReadPriority(std::istringstream& request) {
+    int priority;
+    if ( !(request >> priority) )
+        throw CException("expected priority");
+    return priority;
+}
+
+//______________________________________________________________________________________________________________________
+// КОНСТРУКТОРЫ
+//______________________________________________________________________________________________________________________
+
+CSchedulingServer::CSchedulingServer(CSchedulingService& service, std::string socket_path)
+        : service_(service),
+          socket_path_(std::move(socket_path)),
+          listener_(-1),
+          shutdown_requested_(false) {
+    sockaddr_un address {};
+    address.sun_family = AF_UNIX;
+    if ( socket_path_.size() >= sizeof(address.sun_path) )
+        throw CException("Socket path is too long: " + socket_path_);
+    std::memcpy(address.sun_path, socket_path_.c_str(), socket_path_.size() + 1);
+
+    struct stat file_stat {};
+    if ( lstat(socket_path_.c_str(), &file_stat) == 0 ) {
+        // Чужой файл по этому пути не удаляется
+        if ( !S_ISSOCK(file_stat.st_mode) )
+            throw CException(socket_path_ + " exists and is not a socket");
+
+        // Сокет, который кто-то слушает, занят; иначе это файл, оставшийся от упавшего процесса
+        int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+        bool busy = probe >= 0 && connect(probe, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+        if (probe >= 0)
+            close(probe);
+        if (busy)
+            throw CException("Socket " + socket_path_ + " is already in use");
+        unlink( socket_path_.c_str() );
+    }
+
+    listener_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener_ < 0)
+        throw CException("Cannot create socket " + socket_path_);
+
+    if ( bind(listener_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ) {
+        close(listener_);
+        throw CException("Cannot bind socket " + socket_path_);
+    }
+    // Служба доступна только владельцу и его группе ( например, администраторам расписания )
+    if ( chmod(socket_path_.c_str(), 0660) != 0 || listen(listener_, 16) != 0 ) {
+        close(listener_);
+        unlink( socket_path_.c_str() );
+        throw CException("Cannot listen on socket " + socket_path_);
+    }
+}
+
+CSchedulingServer::~CSchedulingServer() {
+    close(listener_);
+    unlink( socket_path_.c_str() );
+}
+
+//______________________________________________________________________________________________________________________
+// ЗАПРОСЫ
+//______________________________________________________________________________________________________________________
+
+void CSchedulingServer::Run(const std::atomic<bool>* stop_flag) {
+    while ( !shutdown_requested_ && !(stop_flag && *stop_flag) ) {
+        pollfd listener { listener_, POLLIN, 0 };
+        // 0 -- истекло время ожидания, -1 -- в том числе прерывание сигналом; в обоих случаях проверяется флаг
+        if ( poll(&listener, 1, POLL_INTERVAL_MILLISECONDS) <= 0 )
+            continue;
+
+        int descriptor = accept(listener_, nullptr, nullptr);
+        if (descriptor < 0)
+            continue;
+
+        // Запросы короткие ( решение идет на пуле службы ), поэтому соединения обслуживаются по очереди
+        CSocketConnection connection(descriptor, REQUEST_TIMEOUT_SECONDS);
+        handle(connection);
+    }
+}
+
+void CSchedulingServer::handle(CSocketConnection& connection) {
+    std::string line;
+    if ( !connection.ReadLine(line, MAX_LINE_SIZE) ) {
+        connection.Write("ERR expected a request line\n");
+        return;
+    }
+
+    std::istringstream request(line);
+    std::string command;
+    request >> command;
+
+    std::string response;
+    try {
+        if (command == "SUBMIT") {
+            int priority = ReadPriority(request);
+            std::string path;
+            std::getline(request >> std::ws, path);
+            if ( path.empty() )
+                throw CException("expected instance path");
+            response = "OK " + std::to_string( service_.Submit(path, priority) ) + "\n";
+        } else if (command == "SUBMIT_DATA") {
+            int priority = ReadPriority(request);
+            std::string name;
+            if ( !(request >> name) )
+                throw CException("expected instance name");
+            response = submitData(connection, priority, name);
+        } else if (command == "STATUS") {
+            size_t id = ReadJobId(request);
+            auto status = service_.GetStatus(id);
+            if (!status)
+                throw CException("unknown job " + std::to_string(id));
+            response = "OK " + FormatStatus(*status) + "\n";
+        } else if (command == "LIST") {
+            auto statuses = service_.GetStatuses();
+            response = "OK " + std::to_string( statuses.size() ) + "\n";
+            for (const auto& status : statuses)
+                response += FormatStatus(status) + "\n";
+        } else if (command == "RESULT") {
+            size_t id = ReadJobId(request);
+            std::string kind;
+            request >> kind;
+            response = result(id, kind);
+        } else if (command == "CANCEL") {
+            size_t id = ReadJobId(request);
+            if ( !service_.Cancel(id) )
+                throw CException("job " + std::to_string(id) + " is not queued or running");
+            response = "OK\n";
+        } else if (command == "FORGET") {
+            size_t id = ReadJobId(request);
+            if ( !service_.Forget(id) )
+                throw CException("job " + std::to_string(id) + " is unknown or not finished");
+            response = "OK\n";
+        } else if (command == "SHUTDOWN") {
+            shutdown_requested_ = true;
+            response = "OK\n";
+        } else {
+            throw CException("unknown command '" + command + "'");
+        }
+    } catch (CException &ex) {
+        response = "ERR " + OneLine( ex.GetMessage() ) + "\n";
+    }
+
+    connection.Write(response);
+}
+
+std::string CSchedulingServer::submitData(CSocketConnection& connection, int priority, const std::string& name) {
+    std::map<std::string, std::string> files;
+    for (size_t i = 0; i < CSchedulingService::INPUT_FILES.size(); i++) {
+        std::string header;
+        if ( !connection.ReadLine(header, MAX_LINE_SIZE) )
+            throw CException("expected '<filename> <size>'");
+
+        std::istringstream stream(header);
+        std::string filename;
+        size_t size;
+        if ( !(stream >> filename >> size) )
+            throw CException("expected '<filename> <size>', got '" + header + "'");
+        if (size > MAX_FILE_SIZE)
+            throw CException(filename + " is larger than " + std::to_string(MAX_FILE_SIZE) + " bytes");
+        if ( files.count(filename) )
+            throw CException("repeated file " + filename);
+        if ( !connection.ReadBytes(files[filename], size) )
+            throw CException("unexpected end of " + filename);
+    }
+
+    return "OK " + std::to_string( service_.SubmitData(name, files, priority) ) + "\n";
+}
+
+std::string CSchedulingServer::result(size_t id, const std::string& kind) const {
+    if (kind != "GROUPS" && kind != "TEACHERS")
+        throw CException("expected GROUPS or TEACHERS");
+
+    // Пока задача решается, отдается ее промежуточное расписание
+    std::string filename = service_.GetResultFile(id, kind == "TEACHERS");
+    if ( filename.empty() )
+        filename = service_.WriteProvisionalResult(id, kind == "TEACHERS");
+    if ( filename.empty() )
+        throw CException("job " + std::to_string(id) + " has no timetable");
+
+    std::ifstream file(filename, std::ios::binary);
+    std::ostringstream content;
+    content << file.rdbuf();
+    if (!file)
+        throw CException("Cannot read " + filename);
+
+    std::string data = content.str();
+    return "OK " + std::to_string( data.size() ) + "\n" + data;
+}
@@ -0,0 +1,333 @@
+#include "CSchedulingService.h"
+#include "CException.h"
+#include "CObjectiveFunction.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const char* JobStateName(JobState state) {
+    switch (state) {
+        case JobState::Queued:
+            return "queued";
+        case JobState::Running:
+            return "running";
+        case JobState::Done:
+            return "done";
+        case JobState::Failed:
+            return "failed";
+        case JobState::Cancelled:
+            return "cancelled";
+    }
+    return "";
+}
+
+const std::vector<std::string> CSchedulingService::INPUT_FILES {
+    "teachers.txt", "groups.txt", "cabinets.txt", "subjects.txt"
+};
+
+//______________________________________________________________________________________________________________________
+// КОНСТРУКТОРЫ
+//______________________________________________________________________________________________________________________
+
+CSchedulingService::CSchedulingService( std::string work_folder, size_t threads_number, Solver solver,
+                                        size_t max_finished_jobs )
+        : work_folder_(std::move(work_folder)),
+          solver_(std::move(solver)),
+          max_finished_jobs_(max_finished_jobs),
+          next_id_(1),
+          next_provisional_file_(0),
+          pool_(threads_number) {
+    if ( !work_folder_.empty() && work_folder_.back() != '/' )
+        work_folder_ += '/';
+    if ( mkdir(work_folder_.c_str(), 0755) != 0 && errno != EEXIST )
+        throw CException("Cannot create " + work_folder_);
+}
+
+CSchedulingService::~CSchedulingService() {
+    CancelAll();
+}
+
+//______________________________________________________________________________________________________________________
+// МОДИФИКАТОРЫ
+//______________________________________________________________________________________________________________________
+
+size_t CSchedulingService::Submit(const std::string& input, int priority) {
+    size_t id;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        id = next_id_++;
+    }
+    // Имя задачи -- последний элемент пути
+    std::string name = input;
+    while ( name.size() > 1 && name.back() == '/' )
+        name.pop_back();
+    name = name.substr( name.find_last_of('/') + 1 );
+
+    return enqueue(id, name, priority, input);
+}
+
+size_t CSchedulingService::SubmitData( const std::string& name, const std::map<std::string, std::string>& files,
+                                       int priority ) {
+    for (const auto& file : files)
+        if ( std::find(INPUT_FILES.begin(), INPUT_FILES.end(), file.first) == INPUT_FILES.end() )
+            throw CException("Unexpected input file " + file.first);
+    for (const auto& filename : INPUT_FILES)
+        if ( files.find(filename) == files.end() )
+            throw CException("Missing input file " + filename);
+
+    size_t id;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        id = next_id_++;
+    }
+    // Входные файлы лежат в папке задачи рядом с ее расписаниями
+    std::string folder = createJobFolder(id);
+    for (const auto& file : files) {
+        std::ofstream stream(folder + file.first, std::ios::binary);
+        stream << file.second;
+        if (!stream)
+            throw CException("Cannot write " + folder + file.first);
+    }
+
+    return enqueue(id, name, priority, folder);
+}
+
+bool CSchedulingService::Cancel(size_t id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto job = jobs_.find(id);
+    if ( job == jobs_.end() )
+        return false;
+
+    switch (job->second->state) {
+        case JobState::Queued:
+            // Пул все равно запустит задачу, но она сразу завершится
+            job->second->cancel_requested = true;
+            job->second->state = JobState::Cancelled;
+            return true;
+        case JobState::Running:
+            // Оптимизатор остановится на ближайшей итерации, и задача запишет лучшее найденное расписание
+            job->second->cancel_requested = true;
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool CSchedulingService::Forget(size_t id) {
+    std::string folder;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto job = jobs_.find(id);
+        if ( job == jobs_.end() || !isFinished(*job->second) )
+            return false;
+        folder = job->second->folder;
+        jobs_.erase(job);
+    }
+    removeJobFolder(folder);
+    return true;
+}
+
+void CSchedulingService::CancelAll() {
+    std::vector<size_t> ids;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& job : jobs_)
+            ids.push_back(job.first);
+    }
+    for (size_t id : ids)
+        Cancel(id);
+}
+
+//______________________________________________________________________________________________________________________
+// ГЕТТЕРЫ
+//______________________________________________________________________________________________________________________
+
+std::optional<JobStatus> CSchedulingService::GetStatus(size_t id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto job = jobs_.find(id);
+    if ( job == jobs_.end() )
+        return std::nullopt;
+    return status(*job->second);
+}
+
+std::vector<JobStatus> CSchedulingService::GetStatuses() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<JobStatus> statuses;
+    statuses.reserve( jobs_.size() );
+    for (const auto& job : jobs_)
+        statuses.push_back( status(*job.second) );
+    return statuses;
+}
+
+std::string CSchedulingService::GetResultFile(size_t id, bool teachers) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto job = jobs_.find(id);
+    if ( job == jobs_.end() || !job->second->has_result )
+        return "";
+    return job->second->folder + (teachers ? "TOutput.tex" : "GOutput.tex");
+}
+
+std::string CSchedulingService::WriteProvisionalResult(size_t id, bool teachers) {
+    CSolutionSnapshotPtr snapshot;
+    std::string folder;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto job = jobs_.find(id);
+        if ( job == jobs_.end() || job->second->state != JobState::Running || !job->second->provisional )
+            return "";
+        snapshot = job->second->provisional;
+        folder = job->second->folder;
+    }
+
+    // Снимок неизменяем, поэтому записывается без блокировки
+    std::string filename = folder + (teachers ? "provisional-TOutput.tex" : "provisional-GOutput.tex");
+    std::string temporary = filename + "." + std::to_string( next_provisional_file_++ );
+    if (teachers)
+        snapshot->timetable.TeachersScheduleTex(temporary);
+    else
+        snapshot->timetable.GroupsScheduleTex(temporary);
+    if ( rename(temporary.c_str(), filename.c_str()) != 0 ) {
+        unlink( temporary.c_str() );
+        throw CException("Cannot write " + filename);
+    }
+    return filename;
+}
+
+//______________________________________________________________________________________________________________________
+// ЗАДАЧИ
+//______________________________________________________________________________________________________________________
+
+std::string CSchedulingService::createJobFolder(size_t id) const {
+    std::string folder = work_folder_ + "job-" + std::to_string(id) + "/";
+    if ( mkdir(folder.c_str(), 0755) != 0 && errno != EEXIST )
+        throw CException("Cannot create " + folder);
+    return folder;
+}
+
+void CSchedulingService::removeJobFolder(const std::string& folder) {
+    for (const auto& filename : INPUT_FILES)
+        unlink( (folder + filename).c_str() );
+    unlink( (folder + "GOutput.tex").c_str() );
+    unlink( (folder + "TOutput.tex").c_str() );
+    unlink( (folder + "provisional-GOutput.tex").c_str() );
+    unlink( (folder + "provisional-TOutput.tex").c_str() );
+    rmdir( folder.c_str() );
+}
+
+bool CSchedulingService::isFinished(const Job& job) {
+    // Задача, отмененная в очереди, еще будет запущена пулом, но сразу завершится, ничего не записав
+    return job.state != JobState::Queued && job.state != JobState::Running;
+}
+
+std::vector<std::string> CSchedulingService::evictFinished() {
+    std::vector<size_t> finished;
+    for (const auto& [id, job] : jobs_)
+        if ( isFinished(*job) )
+            finished.push_back(id);
+
+    // Номера растут, поэтому в начале -- самые старые
+    std::vector<std::string> folders;
+    for (size_t i = 0; i + max_finished_jobs_ < finished.size(); i++) {
+        folders.push_back( jobs_.at(finished[i])->folder );
+        jobs_.erase(finished[i]);
+    }
+    return folders;
+}
+
+size_t CSchedulingService::enqueue(size_t id, std::string name, int priority, std::string input) {
+    auto job = std::make_shared<Job>();
+    job->id = id;
+    job->name = std::move(name);
+    job->priority = priority;
+    job->input = std::move(input);
+    job->folder = createJobFolder(id);
+    job->cancel_requested = false;
+    job->progress = std::make_shared<CLatestProgressSink>();
+    job->state = JobState::Queued;
+    job->seconds = 0;
+    job->has_result = false;
+    job->cost = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        jobs_.emplace(id, job);
+    }
+    pool_.Submit( [this, job] () { run(job); }, priority );
+    return id;
+}
+
+void CSchedulingService::run(const std::shared_ptr<Job>& job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (job->cancel_requested) {
+            job->state = JobState::Cancelled;
+            return;
+        }
+        job->state = JobState::Running;
+        job->start = std::chrono::steady_clock::now();
+    }
+
+    JobState state = JobState::Failed;
+    bool has_result = false;
+    size_t cost = 0;
+    std::string message;
+    try {
+        // Предыдущий снимок освобождается вне блокировки, чтобы запросы состояния не ждали освобождения расписания
+        auto on_improvement = [this, job] (const CSolutionSnapshotPtr& snapshot) {
+            CSolutionSnapshotPtr previous = snapshot;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                job->provisional.swap(previous);
+            }
+        };
+        CTimeTable table = solver_(job->input, &job->cancel_requested, job->progress, on_improvement);
+        table.GroupsScheduleTex(job->folder + "GOutput.tex");
+        table.TeachersScheduleTex(job->folder + "TOutput.tex");
+        cost = CObjectiveFunction().Value(table);
+        has_result = true;
+        state = job->cancel_requested ? JobState::Cancelled : JobState::Done;
+    } catch (CException &ex) {
+        message = ex.GetMessage();
+    } catch (std::exception &ex) {
+        message = ex.what();
+    }
+
+    std::vector<std::string> evicted;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job->state = state;
+        job->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - job->start).count();
+        job->has_result = has_result;
+        job->cost = cost;
+        job->message = message;
+        job->provisional = nullptr;
+        evicted = evictFinished();
+    }
+    // Промежуточное расписание больше не нужно: его заменяет итоговое
+    unlink( (job->folder + "provisional-GOutput.tex").c_str() );
+    unlink( (job->folder + "provisional-TOutput.tex").c_str() );
+    for (const auto& folder : evicted)
+        removeJobFolder(folder);
+}
+
+JobStatus CSchedulingService::status(const Job& job) const {
+    JobStatus status {};
+    status.id = job.id;
+    status.name = job.name;
+    status.priority = job.priority;
+    status.state = job.state;
+    status.has_progress = job.progress->Get(status.progress);
+    status.has_result = job.has_result;
+    status.cost = job.cost;
+    status.has_provisional = job.provisional != nullptr;
+    status.provisional_cost = job.provisional ? job.provisional->cost : 0;
+    status.message = job.message;
+    if (job.state == JobState::Running)
+        status.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - job.start).count();
+    else
+        status.seconds = job.seconds;
+    return status;
+}
@@ -0,0 +1,36 @@
+#include "CSolutionPublisher.h"
+
+CSolutionPublisher::CSolutionPublisher()
+        : start_(std::chrono::steady_clock::now()) {}
+
+void CSolutionPublisher::SetCallback(ImprovementCallback callback) {
+    callback_ = std::move(callback);
+}
+
+void CSolutionPublisher::Start() {
+    start_ = std::chrono::steady_clock::now();
+}
+
+void CSolutionPublisher::Publish(const CTimeTable& timetable, size_t cost, size_t iteration) {
+    TRACE_SCOPE("Publish solution");
+    double elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+
+    // Снимок полностью строится до публикации, после нее не меняется. Агрегат создается на месте: расписание
+    // копируется один раз.
+    CSolutionSnapshotPtr snapshot( new SolutionSnapshot {timetable, cost, iteration, elapsed_seconds} );
+    CSolutionSnapshotPtr previous = snapshot;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        snapshot_.swap(previous);
+    }
+    // Если читателей у предыдущего снимка нет, он освобождается здесь, вне блокировки
+    previous.reset();
+
+    if (callback_)
+        callback_(snapshot);
+}
+
+CSolutionSnapshotPtr CSolutionPublisher::Get() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return snapshot_;
+}
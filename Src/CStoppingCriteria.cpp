@@ -0,0 +1,119 @@
+#include "CStoppingCriteria.h"
+
+const char* StopReasonName(StopReason reason) {
+    switch (reason) {
+        case StopReason::None:
+            return "none";
+        case StopReason::IterationLimit:
+            return "iteration limit";
+        case StopReason::TimeBudget:
+            return "time budget";
+        case StopReason::TargetCost:
+            return "target cost";
+        case StopReason::NoImprovement:
+            return "no improvement";
+        case StopReason::Cancelled:
+            return "cancelled";
+    }
+    return "";
+}
+
+//______________________________________________________________________________________________________________________
+// КОНСТРУКТОРЫ
+//______________________________________________________________________________________________________________________
+
+CStoppingCriteria::CStoppingCriteria()
+        : cancel_flag_(nullptr),
+          start_(std::chrono::steady_clock::now()),
+          last_improvement_time_(start_),
+          last_improvement_iteration_(0),
+          best_cost_(0),
+          reason_(StopReason::None) {}
+
+//______________________________________________________________________________________________________________________
+// СЕТТЕРЫ
+//______________________________________________________________________________________________________________________
+
+CStoppingCriteria& CStoppingCriteria::SetIterationLimit(size_t iteration_limit) {
+    iteration_limit_ = iteration_limit;
+    return *this;
+}
+
+CStoppingCriteria& CStoppingCriteria::SetTimeBudget(double seconds) {
+    time_budget_ = std::chrono::duration<double>(seconds);
+    return *this;
+}
+
+CStoppingCriteria& CStoppingCriteria::SetTargetCost(size_t target_cost) {
+    target_cost_ = target_cost;
+    return *this;
+}
+
+CStoppingCriteria& CStoppingCriteria::SetNoImprovementIterations(size_t iterations) {
+    no_improvement_iterations_ = iterations;
+    return *this;
+}
+
+CStoppingCriteria& CStoppingCriteria::SetNoImprovementTime(double seconds) {
+    no_improvement_time_ = std::chrono::duration<double>(seconds);
+    return *this;
+}
+
+CStoppingCriteria& CStoppingCriteria::SetCancelFlag(const std::atomic<bool>* cancel_flag) {
+    cancel_flag_ = cancel_flag;
+    return *this;
+}
+
+//______________________________________________________________________________________________________________________
+// ГЕТТЕРЫ
+//______________________________________________________________________________________________________________________
+
+size_t CStoppingCriteria::GetIterationLimit() const {
+    return iteration_limit_.value_or(0);
+}
+
+StopReason CStoppingCriteria::GetReason() const {
+    return reason_;
+}
+
+//______________________________________________________________________________________________________________________
+// МОДИФИКАТОРЫ
+//______________________________________________________________________________________________________________________
+
+void CStoppingCriteria::Start(size_t best_cost, size_t iteration, double elapsed_seconds) {
+    last_improvement_time_ = std::chrono::steady_clock::now();
+    start_ = last_improvement_time_ - std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(elapsed_seconds) );
+    last_improvement_iteration_ = iteration;
+    best_cost_ = best_cost;
+    reason_ = StopReason::None;
+}
+
+bool CStoppingCriteria::ShouldStop(size_t iteration, size_t best_cost) {
+    // Самые дешевые проверки -- первыми; время запрашивается один раз
+    if ( cancel_flag_ && cancel_flag_->load(std::memory_order_relaxed) )
+        reason_ = StopReason::Cancelled;
+    else if ( iteration_limit_ && iteration >= *iteration_limit_ )
+        reason_ = StopReason::IterationLimit;
+    else if ( target_cost_ && best_cost <= *target_cost_ )
+        reason_ = StopReason::TargetCost;
+
+    if (reason_ != StopReason::None)
+        return true;
+
+    auto now = std::chrono::steady_clock::now();
+    if (best_cost < best_cost_) {
+        best_cost_ = best_cost;
+        last_improvement_iteration_ = iteration;
+        last_improvement_time_ = now;
+    }
+
+    if ( time_budget_ && now - start_ >= *time_budget_ )
+        reason_ = StopReason::TimeBudget;
+    else if ( no_improvement_iterations_ && iteration - last_improvement_iteration_ >= *no_improvement_iterations_ )
+        reason_ = StopReason::NoImprovement;
+    else if ( no_improvement_time_ && now - last_improvement_time_ >= *no_improvement_time_ )
+        reason_ = StopReason::NoImprovement;
+
+    return reason_ != StopReason::None;
+}
@@ -6,6 +6,7 @@
 #include "CGroup.h"
 #include "ServiceFunctions.h"
 #include "CException.h"
+#include "CWeekGeometry.h"
 
 //______________________________________________________________________________________________________________________
 //______________________________________________________________________________________________________________________
@@ -17,21 +18,29 @@
 
 CSubject::CSubject( std::string name,
                     size_t id,
+                    size_t index,
+                    size_t lesson,
+                    size_t copy_index,
                     size_t difficulty_rating,
                     size_t duration,
                     size_t required_cabinets_number,
                     int64_t feasible_time,
-                    const std::set<CTeacher *const, Comparator<CTeacher>> &teachers,
-                    const std::set<CGroup *const, Comparator<CGroup>> &groups,
-                    const std::set<CCabinet *const, Comparator<CCabinet>> &cabinets,
+                    int64_t start_domain,
+                    const std::set<const CTeacher *const, Comparator<CTeacher>> &teachers,
+                    const std::set<const CGroup *const, Comparator<CGroup>> &groups,
+                    const CCabinetSet &cabinets,
                     size_t total_participants)
 
                     : name_(name),
                     id_(id),
+                    index_(index),
+                    lesson_(lesson),
+                    copy_index_(copy_index),
                     difficulty_rating_(difficulty_rating),
                     duration_(duration),
                     required_cabinets_number_(required_cabinets_number),
                     feasible_time_(feasible_time),
+                    start_domain_(start_domain),
                     teachers_(teachers),
                     groups_(groups),
                     cabinets_(cabinets),
@@ -42,7 +51,7 @@ CSubject::CSubject( std::string name,
 // ГЕТТЕРЫ
 //______________________________________________________________________________________________________________________
 
-std::string CSubject::GetName() const {
+const std::string& CSubject::GetName() const {
     return name_;
 }
 
@@ -50,6 +59,26 @@ size_t CSubject::GetId() const {
     return id_;
 }
 
+size_t CSubject::GetIndex() const {
+    return index_;
+}
+
+size_t CSubject::GetLesson() const {
+    return lesson_;
+}
+
+size_t CSubject::GetCopyIndex() const {
+    return copy_index_;
+}
+
+bool CSubject::IsCopyOf(const CSubject& other) const {
+    return lesson_ == other.lesson_;
+}
+
+size_t CSubject::GetDifficultyRating() const {
+    return difficulty_rating_;
+}
+
 size_t CSubject::GetDuration() const {
     return duration_;
 }
@@ -89,30 +118,26 @@ int64_t CSubject::GetFeasibleTime() const {
     return feasible_time_;
 }
 
+int64_t CSubject::GetStartDomain() const {
+    return start_domain_;
+}
+
 int64_t CSubject::GetAvailableStartTime( size_t days_in_week,
                                          size_t lessons_in_day ) const {
+    return GetAvailableStartTime( GetAvailableTime(), days_in_week, lessons_in_day );
+}
+
+int64_t CSubject::GetAvailableStartTime( int64_t available_time,
+                                         size_t days_in_week,
+                                         size_t lessons_in_day ) const {
 
-    int64_t resulting_available_start_time( GetAvailableTime() );
-
-    // Маска предмета -- duration_ подряд идущих единиц
-    int64_t duration_mask(0);
-    for (int i = 0; i < duration_; i++)
-        duration_mask |= static_cast<int64_t>(1) << i;
-
-    // Сдвигая duration_mask на day * lessons_in_day + lesson, проверяем, доступен ли предмет на всех местах единиц
-    // в duration_mask. Если нет, меняем бит day * lessons_in_day + lesson в resulting_available_start_time на 0, так
-    // как с этого времени начать предмет нельзя. Дополнительно зануляем времяв конце дня, куда не уместится предмет.
-    for ( int day = 0; day < days_in_week; day++ ) {
-        for ( int lesson = 0; lesson < int(lessons_in_day) - int(duration_) + 1; lesson++ ) {
-            if ( (resulting_available_start_time & (duration_mask << (day * lessons_in_day + lesson))) !=
-                 duration_mask << (day * lessons_in_day + lesson) )
-                resulting_available_start_time &= ~(static_cast<int64_t>(1) << (day * lessons_in_day + lesson) );
-        }
-        for ( int lesson = int(lessons_in_day) - int(duration_) + 1; lesson < lessons_in_day; lesson++)
-            resulting_available_start_time &= ~(static_cast<int64_t>(1) << (day * lessons_in_day + lesson) );
-    }
+    // Время начала допустимо, если предмет свободен на всех duration_ уроках от него и не выходит за конец дня
+    int64_t resulting_available_start_time = DispatchWeekGeometry( days_in_week, lessons_in_day,
+        [available_time, this] (const auto& geometry) {
+            return AvailableStartTime(geometry, available_time, duration_);
+        } );
 
-    return resulting_available_start_time;
+    return resulting_available_start_time & start_domain_;
 }
 
 int64_t CSubject::GetGroupAvailableTime() const {
@@ -133,35 +158,6 @@ int64_t CSubject::GetTeachersAvailableTime() const {
     return resulting_available_time;
 }
 
-size_t CSubject::GetTeachersAvailableTimeSize() const {
-    int64_t resulting_available_time = GetTeachersAvailableTime() & GetGroupAvailableTime() & feasible_time_;
-
-    size_t counter(0);
-    for (int i = 0; i < INT64_SIZE; i++)
-        if ( (resulting_available_time >> i) & 1 )
-            counter++;
-
-    return counter;
-}
-
-//______________________________________________________________________________________________________________________
-// МЕТОДЫ  ДЛЯ  РАБОТЫ  С  ЗАНИМАЕМЫМ  И  ОСВОБОЖДАЕМЫМ  ВРЕМЕНЕМ
-//______________________________________________________________________________________________________________________
-
-void CSubject::ReserveTime(size_t start_time) {
-    for (const auto& teacher : teachers_)
-        teacher->ReserveTime(start_time, duration_);
-    for (const auto& group : groups_)
-        group->ReserveTime(start_time, duration_);
-}
-
-void CSubject::ReleaseTime(size_t start_time) {
-    for (const auto& teacher : teachers_)
-        teacher->ReleaseTime(start_time, duration_);
-    for (const auto& group : groups_)
-        group->ReleaseTime(start_time, duration_);
-}
-
 //______________________________________________________________________________________________________________________
 //______________________________________________________________________________________________________________________
 //
@@ -182,6 +178,29 @@ void CSubjectBuilder::SetSubjectId(size_t id) {
     id_ = id;
 }
 
+void CSubjectBuilder::SetSubjectIndex(size_t index) {
+    index_ = index;
+}
+
+void CSubjectBuilder::SetSubjectLesson(size_t lesson, size_t copy_index) {
+    lesson_ = lesson;
+    copy_index_ = copy_index;
+}
+
+void CSubjectBuilder::SetFromSubject(const CSubject& subject) {
+    id_ = subject.GetId();
+    lesson_ = subject.GetLesson();
+    copy_index_ = subject.GetCopyIndex();
+    difficulty_rating_ = subject.GetDifficultyRating();
+    duration_ = subject.GetDuration();
+    required_cabinets_number_ = subject.GetRequiredCabinetsNumber();
+    feasible_time_ = subject.GetFeasibleTime();
+    start_domain_ = subject.GetStartDomain();
+    SetSubjectTeachers(subject.GetTeachers());
+    SetSubjectCabinets(subject.GetCabinets());
+    SetSubjectGroups(subject.GetGroups());
+}
+
 void CSubjectBuilder::SetSubjectDifficultyRating(size_t difficulty_rating) {
     difficulty_rating_ = difficulty_rating;
 }
@@ -198,11 +217,15 @@ void CSubjectBuilder::SetFeasibleTime(int64_t feasible_time) {
     feasible_time_ = feasible_time;
 }
 
-void CSubjectBuilder::SetSubjectTeachers(std::set<CTeacher *const, Comparator<CTeacher>> teachers) {
+void CSubjectBuilder::SetStartDomain(int64_t start_domain) {
+    start_domain_ = start_domain;
+}
+
+void CSubjectBuilder::SetSubjectTeachers(std::set<const CTeacher *const, Comparator<CTeacher>> teachers) {
     teachers_ = std::move(teachers);
 }
 
-void CSubjectBuilder::SetSubjectGroups(std::set<CGroup *const, Comparator<CGroup>> groups) {
+void CSubjectBuilder::SetSubjectGroups(std::set<const CGroup *const, Comparator<CGroup>> groups) {
     groups_ = std::move(groups);
 
     total_participants_ = 0;
@@ -210,7 +233,7 @@ void CSubjectBuilder::SetSubjectGroups(std::set<CGroup *const, Comparator<CGroup
         total_participants_ += group->GetStudentsNumber();
 }
 
-void CSubjectBuilder::SetSubjectCabinets(std::set<CCabinet *const, Comparator<CCabinet>> cabinets) {
+void CSubjectBuilder::SetSubjectCabinets(CCabinetSet cabinets) {
     cabinets_ = std::move(cabinets);
 }
 
@@ -221,10 +244,14 @@ void CSubjectBuilder::SetSubjectCabinets(std::set<CCabinet *const, Comparator<CC
 CSubject CSubjectBuilder::Build() const {
     return { name_,
              id_,
+             index_,
+             lesson_,
+             copy_index_,
              difficulty_rating_,
              duration_,
              required_cabinets_number_,
              feasible_time_,
+             start_domain_,
              teachers_,
              groups_,
              cabinets_,
@@ -249,14 +276,18 @@ void CTimeTableGeneratorSupporter::moveTopToQueue() {
 }
 
 void CTimeTableGeneratorSupporter::moveMinToStack() {
-    CSubject *const current_subject = *priority_queue_.begin();
+    const CSubject *const current_subject = *priority_queue_.begin();
     stack_.push_back(current_subject);
     priority_queue_.erase(priority_queue_.begin());
 
     // Для переносимого предмета получаем возможные времена старта и запоминаем в стек времени случайную перестановку
     // этих времен.
-    int64_t current_subject_availabel_time = current_subject->GetAvailableStartTime(days_in_week_, lessons_in_day_);
+    int64_t current_subject_availabel_time = occupancy_->GetSubjectAvailableStartTime(current_subject,
+                                                                                     days_in_week_, lessons_in_day_) &
+                                             allowed_start_time_ &
+                                             copiesSymmetryMask(current_subject);
     times_stack_.push_back( RandomPermutation( current_subject_availabel_time ) );
+    tried_times_stack_.push_back(0);
 
     if ( current_subject_availabel_time == 0 ) {
         throw CBadSubjectPlacement("No available time for", current_subject);
@@ -264,7 +295,27 @@ void CTimeTableGeneratorSupporter::moveMinToStack() {
 
 }
 
-void CTimeTableGeneratorSupporter::backTrack( std::vector< std::pair<CSubject *, size_t> >& subjects_to_delete ) {
+void CTimeTableGeneratorSupporter::popTime() {
+    tried_times_stack_.back() |= static_cast<int64_t>(1) << times_stack_.back().back();
+    times_stack_.back().pop_back();
+}
+
+int64_t CTimeTableGeneratorSupporter::copiesSymmetryMask(const CSubject* subject) const {
+    // Копии урока взаимозаменяемы. Если копия ниже в стеке уже перебрала время t, и все продолжения оказались
+    // неудачными ( или на t не нашлось кабинета ), то поставить на t subject -- то же самое с точностью до
+    // перестановки копий, и это заведомо неудачно. Поэтому из каждого набора времен копий рассматривается только
+    // один порядок, при этом сами времена по-прежнему перебираются в случайном порядке.
+    int64_t mask(~static_cast<int64_t>(0));
+
+    // Вершина стека -- сам subject, его время еще не выбрано
+    for (size_t i = 0; i + 1 < stack_.size(); i++)
+        if ( stack_[i]->IsCopyOf(*subject) )
+            mask &= ~tried_times_stack_[i];
+
+    return mask;
+}
+
+void CTimeTableGeneratorSupporter::backTrack( std::vector< std::pair<const CSubject *, size_t> >& subjects_to_delete ) {
     // Главная функция backTrack -- откатиться к предыдущим предметам и поменять их время начала, чтобы попробовать
     // разместить те, которые не удалось разместить. После выхода из функции, на вершине стека предметов должен лежать
     // предмет, кторому нужно найти кабинет, а в стеке времени -- время его начала.
@@ -273,7 +324,7 @@ void CTimeTableGeneratorSupporter::backTrack( std::vector< std::pair<CSubject *,
     do {
         // Если не пуст, выкидываем предыдущий вариант
         if ( !times_stack_.back().empty() )
-            times_stack_.back().pop_back();
+            popTime();
 
         // Если пуст, значит мы просмотрели все возможные времена для данного предмета и нам нужно перейти на
         // предыдущий, в порядке добавления в стек, предмет. Для этого перемещаем его в очередь и удаляем уже пустой
@@ -288,7 +339,7 @@ void CTimeTableGeneratorSupporter::backTrack( std::vector< std::pair<CSubject *,
                 throw CBadTimeTable("Can't create timetable");
 
             subjects_to_delete.emplace_back( std::make_pair(GetCurrentSubject(), GetCurrentSubjectStartTime()) );
-            times_stack_.back().pop_back();
+            popTime();
         }
     } while ( times_stack_.back().empty() );
     is_last_successful_ = true;
@@ -299,21 +350,41 @@ void CTimeTableGeneratorSupporter::backTrack( std::vector< std::pair<CSubject *,
 //______________________________________________________________________________________________________________________
 
 
-CTimeTableGeneratorSupporter::CTimeTableGeneratorSupporter( std::map< std::string,CSubject > &subjects,
-                                                            size_t days_in_week, size_t lessons_in_day )
-        : days_in_week_(days_in_week),
+CTimeTableGeneratorSupporter::CTimeTableGeneratorSupporter( const std::map< std::string,CSubject > &subjects,
+                                                            const COccupancy& occupancy,
+                                                            size_t days_in_week, size_t lessons_in_day,
+                                                            const CConflictGraph* conflict_graph )
+        : priority_queue_( SubjectComporator{&occupancy, conflict_graph} ),
+          occupancy_(&occupancy),
+          days_in_week_(days_in_week),
           lessons_in_day_(lessons_in_day),
-          is_last_successful_(true) {
+          is_last_successful_(true),
+          allowed_start_time_(~static_cast<int64_t>(0)) {
     for (auto subject = subjects.begin(); subject != subjects.end(); subject++)
         priority_queue_.insert(&(*subject).second);
 }
 
+CTimeTableGeneratorSupporter::CTimeTableGeneratorSupporter( const std::vector<const CSubject*>& subjects,
+                                                            int64_t allowed_start_time,
+                                                            const COccupancy& occupancy,
+                                                            size_t days_in_week, size_t lessons_in_day,
+                                                            const CConflictGraph* conflict_graph )
+        : priority_queue_( SubjectComporator{&occupancy, conflict_graph} ),
+          occupancy_(&occupancy),
+          days_in_week_(days_in_week),
+          lessons_in_day_(lessons_in_day),
+          is_last_successful_(true),
+          allowed_start_time_(allowed_start_time) {
+    for (const auto& subject : subjects)
+        priority_queue_.insert(subject);
+}
+
 //______________________________________________________________________________________________________________________
 // ФУНКЦИОНАЛ  ДЛЯ  ГЕНЕРАЦИИ
 //______________________________________________________________________________________________________________________
 
 
-void CTimeTableGeneratorSupporter::MakeIteration( std::vector< std::pair<CSubject *, size_t> >& subjects_to_delete ) {
+void CTimeTableGeneratorSupporter::MakeIteration( std::vector< std::pair<const CSubject *, size_t> >& subjects_to_delete ) {
     // Итерация генерации:
     // Если предыдущая итерация успешна и очередь предметов для заполнения не пуста, то мы готовы разместить в
     // расписании очередной предмет из очереди. Для этого переносим его в стек размещенных. Нас не интересует его
@@ -343,10 +414,11 @@ bool CTimeTableGeneratorSupporter::IsLastSuccessful() const {
 void CTimeTableGeneratorSupporter::CleanStackTop() {
     moveTopToQueue();
     times_stack_.pop_back();
+    tried_times_stack_.pop_back();
 }
 
 void CTimeTableGeneratorSupporter::TimesStackPop() {
-    times_stack_.back().pop_back();
+    popTime();
 }
 
 bool CTimeTableGeneratorSupporter::QueueEmpty() const {
@@ -365,7 +437,7 @@ bool CTimeTableGeneratorSupporter::CurrentSubjectTimesStackEmpty() const {
 // ГЕТТЕРЫ
 //______________________________________________________________________________________________________________________
 
-CSubject *const CTimeTableGeneratorSupporter::GetCurrentSubject() const {
+const CSubject *const CTimeTableGeneratorSupporter::GetCurrentSubject() const {
     return stack_.back();
 }
 
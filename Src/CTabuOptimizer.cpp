@@ -0,0 +1,132 @@
+#include "CTabuOptimizer.h"
+
+#include <climits>
+
+CTabuOptimizer::CTabuOptimizer( CTimeTable& timetable, size_t candidates_number, size_t tabu_tenure,
+                                size_t maximum_iteration_number, double time_budget_seconds )
+        : current_solution_( std::make_pair(timetable, 0) ),
+          current_best_solution_( std::make_pair(timetable, 0) ),
+          candidate_(timetable),
+          best_candidate_( std::make_pair(timetable, 0) ),
+          candidates_number_(candidates_number),
+          tabu_tenure_(tabu_tenure),
+          time_slots_number_(timetable.GetTimeSlotsNumber()),
+          iteration_(0),
+          evaluations_number_(0),
+          moves_number_(0),
+          random_generator_( std::random_device()() ),
+          progress_("Tabu") {
+
+    stopping_criteria_.SetIterationLimit(maximum_iteration_number).SetTimeBudget(time_budget_seconds);
+
+    current_solution_.first.GenerateTimeTable();
+    current_solution_.second = cost_function_.Value(current_solution_.first);
+    current_best_solution_ = current_solution_;
+}
+
+size_t CTabuOptimizer::attributeKey(size_t subject_index, size_t start_time) const {
+    return subject_index * time_slots_number_ + start_time;
+}
+
+bool CTabuOptimizer::isTabu(const std::vector<MoveAttribute>& attributes) const {
+    for (const auto& attribute : attributes) {
+        auto tabu = tabu_list_.find( attributeKey(attribute.subject_index, attribute.to_time) );
+        if ( tabu != tabu_list_.end() && tabu->second > iteration_ )
+            return true;
+    }
+    return false;
+}
+
+void CTabuOptimizer::makeTabu(const std::vector<MoveAttribute>& attributes) {
+    // Запрещаем возвращать предмет туда, откуда он ушел. Истекшие запреты не удаляются, а перезаписываются:
+    // ключей не больше, чем предметов x времен.
+    for (const auto& attribute : attributes)
+        tabu_list_[ attributeKey(attribute.subject_index, attribute.from_time) ] = iteration_ + tabu_tenure_;
+}
+
+void CTabuOptimizer::makeStep() {
+    TRACE_SCOPE("Tabu step");
+    std::uniform_int_distribution<int> distribution(0, 999);
+
+    best_candidate_.second = INT_MAX;
+    best_candidate_attributes_.clear();
+    bool found(false);
+
+    for (size_t i = 0; i < candidates_number_; i++) {
+        candidate_ = current_solution_.first;
+        candidate_attributes_.clear();
+
+        bool moved = distribution(random_generator_) < 600 ? candidate_.RandomSwap(&candidate_attributes_)
+                                                           : candidate_.RandomMove(&candidate_attributes_);
+        if (!moved)
+            continue;
+
+        int cost = cost_function_.Value(candidate_);
+        evaluations_number_++;
+        if ( cost >= static_cast<int>(best_candidate_.second) )
+            continue;
+
+        // Критерий стремления: запрещенный сосед допускается, если он лучше лучшего найденного решения
+        if ( isTabu(candidate_attributes_) && cost >= static_cast<int>(current_best_solution_.second) )
+            continue;
+
+        best_candidate_.first = candidate_;
+        best_candidate_.second = cost;
+        best_candidate_attributes_.swap(candidate_attributes_);
+        found = true;
+    }
+
+    iteration_++;
+
+    if (!found)
+        return;
+
+    moves_number_++;
+    // В отличие от локального спуска, переходим к лучшему соседу, даже если он хуже текущего решения
+    current_solution_ = best_candidate_;
+    makeTabu(best_candidate_attributes_);
+
+    if ( current_best_solution_.second > current_solution_.second )
+        current_best_solution_ = current_solution_;
+}
+
+ProgressCounters CTabuOptimizer::progressCounters() const {
+    ProgressCounters counters;
+    counters.iteration = iteration_;
+    counters.maximum_iteration_number = stopping_criteria_.GetIterationLimit();
+    counters.best_cost = current_best_solution_.second;
+    counters.evaluations = evaluations_number_;
+    counters.attempted = iteration_;
+    counters.accepted = moves_number_;
+    return counters;
+}
+
+void CTabuOptimizer::FindOptimal() {
+    progress_.Start();
+    stopping_criteria_.Start(current_best_solution_.second);
+
+    for (size_t i = 0; !stopping_criteria_.ShouldStop(i, current_best_solution_.second); i++) {
+
+        progress_.Update( progressCounters() );
+
+        makeStep();
+    }
+
+    progress_.Finish( progressCounters() );
+}
+
+auto CTabuOptimizer::GetCurrentBestSolution() {
+    return current_best_solution_;
+}
+
+void CTabuOptimizer::SetProgressSink(std::shared_ptr<CProgressSink> sink, double interval_seconds) {
+    progress_.SetSink(std::move(sink), interval_seconds);
+}
+
+void CTabuOptimizer::SetStoppingCriteria(const CStoppingCriteria& stopping_criteria) {
+    stopping_criteria_ = stopping_criteria;
+}
+
+StopReason CTabuOptimizer::GetStopReason() const {
+    return stopping_criteria_.GetReason();
+}
@@ -0,0 +1,73 @@
+#include "CThreadPool.h"
+
+#include <algorithm>
+
+CThreadPool::CThreadPool(size_t threads_number)
+        : submitted_(0),
+          active_tasks_(0),
+          stopping_(false) {
+    // hardware_concurrency может вернуть 0, если число ядер неизвестно
+    threads_number = std::max<size_t>(threads_number, 1);
+    workers_.reserve(threads_number);
+    for (size_t i = 0; i < threads_number; i++)
+        workers_.emplace_back( [this] () { work(); } );
+}
+
+CThreadPool::~CThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    task_added_.notify_all();
+
+    for (auto& worker : workers_)
+        worker.join();
+}
+
+bool CThreadPool::TaskOrder::operator()( const TaskKey& first, const TaskKey& second ) const {
+    if (first.first != second.first)
+        return first.first > second.first;
+    return first.second < second.second;
+}
+
+void CThreadPool::work() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            task_added_.wait( lock, [this] () { return stopping_ || !tasks_.empty(); } );
+            // При остановке оставшиеся задачи все равно выполняются
+            if ( tasks_.empty() )
+                return;
+
+            task = std::move( tasks_.begin()->second );
+            tasks_.erase( tasks_.begin() );
+            active_tasks_++;
+        }
+
+        task();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            active_tasks_--;
+        }
+        task_finished_.notify_all();
+    }
+}
+
+void CThreadPool::Submit(std::function<void()> task, int priority) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.emplace( TaskKey(priority, submitted_++), std::move(task) );
+    }
+    task_added_.notify_one();
+}
+
+void CThreadPool::Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    task_finished_.wait( lock, [this] () { return tasks_.empty() && active_tasks_ == 0; } );
+}
+
+size_t CThreadPool::GetThreadsNumber() const {
+    return workers_.size();
+}
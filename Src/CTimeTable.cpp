@@ -4,10 +4,15 @@
 
 #include "CTimeTable.h"
 #include "CException.h"
+#include "CMappedFile.h"
+#include "CInputTokenizer.h"
+#include <algorithm>
 #include <exception>
 #include <fstream>
 #include <sstream>
 #include <cmath>
+#include <tuple>
+#include <functional>
 
 //______________________________________________________________________________________________________________________
 //______________________________________________________________________________________________________________________
@@ -23,109 +28,103 @@
 
 CTimeTable::CTimeTable(std::map<std::string, CTeacher>& teachers, std::map<std::string, CCabinet>& cabinets,
                        std::map<std::string, CGroup>& groups, std::map<std::string, CSubject>& subjects,
+                       std::shared_ptr<const CConflictGraph> conflict_graph,
                        size_t days_in_week, size_t lessons_in_day):
-                       teachers_(teachers),
-                       cabinets_(cabinets),
-                       groups_(groups),
-                       event_linker_(subjects, groups),
+                       // Данные задачи копируются один раз, все копии расписания ссылаются на них
+                       problem_(std::make_shared<const CProblemInstance>(teachers, cabinets, groups, subjects,
+                                                                         std::move(conflict_graph),
+                                                                         days_in_week, lessons_in_day)),
                        days_in_week_(days_in_week),
-                       lessons_in_day_(lessons_in_day) {
+                       lessons_in_day_(lessons_in_day),
+                       occupancy_(problem_->teachers_, problem_->groups_, problem_->cabinets_),
+                       event_linker_(problem_->subjects_, problem_->groups_),
+                       slot_subjects_( days_in_week * lessons_in_day, problem_->conflict_graph_->MakeRow() ),
+                       conflicts_row_( problem_->conflict_graph_->MakeRow() ) {
 
-    // Для копирования в teachers_, cabinets_ и groups_ можно воспользоваться конструктором по умолчанию, так как
-    // достаточно поверхностного копирования. Для копирования в subjects_ нужно "переподвязать"
-    // соответсвующие указатели.
-
-    for (auto& pair : subjects) {
-        CSubject subject = pair.second;
-        CSubjectBuilder subject_builder;
-
-        subject_builder.SetSubjectName(subject.GetName());
-        subject_builder.SetSubjectId(subject.GetId());
-        subject_builder.SetSubjectDuration(subject.GetDuration());
-        subject_builder.SetRequiredCabinetNumber(subject.GetRequiredCabinetsNumber());
-        subject_builder.SetFeasibleTime(subject.GetFeasibleTime());
-
-        std::set< CGroup *const, Comparator<CGroup> > subject_groups;
-        for (auto& subject_group : subject.GetGroups())
-            subject_groups.insert( &groups_.at(subject_group->GetName()) );
-
-        std::set< CCabinet *const, Comparator<CCabinet> > subject_cabinets;
-        for (auto& subject_cabinet : subject.GetCabinets())
-            subject_cabinets.insert( &cabinets_.at(subject_cabinet->GetName()) );
-
-        std::set< CTeacher *const, Comparator<CTeacher> > subject_teachers;
-        for (auto& subject_teacher : subject.GetTeachers())
-            subject_teachers.insert( &teachers_.at(subject_teacher->GetName()) );
-
-        subject_builder.SetSubjectGroups(subject_groups);
-        subject_builder.SetSubjectTeachers(subject_teachers);
-        subject_builder.SetSubjectCabinets(subject_cabinets);
+    time_table_.assign( problem_->groups_.size(), std::vector<CEvent>(days_in_week * lessons_in_day) );
+}
 
-        subjects_.insert( std::make_pair(pair.first, subject_builder.Build()) );
+void CTimeTable::linkEvents() {
+    for (size_t group_index = 0; group_index < time_table_.size(); group_index++) {
+        auto& events = time_table_[group_index];
+        for (size_t time = 0; time < events.size();) {
+            if ( !events[time].IsActive() ) {
+                time++;
+                continue;
+            }
+            event_linker_.InsertEvent(group_index, events[time]);
+            time += events[time].GetSubject()->GetDuration();
+        }
     }
-
-    for (const auto& i : groups_)
-        time_table_.insert( { i.first, std::vector<CEvent>(days_in_week * lessons_in_day) } );
 }
 
-void CTimeTable::insertEvent( CSubject *const subject,
-                              const std::set<CCabinet *const, Comparator<CCabinet>>& cabinets,
+void CTimeTable::insertEvent( const CSubject *const subject,
+                              const CCabinetSet& cabinets,
                               size_t start_time ) {
     assert(subject);
 
-    std::string current_group_name;
+    size_t current_group_index;
 
     for ( const auto& group : subject->GetGroups() ) {
-        current_group_name = group->GetName();
+        current_group_index = group->GetIndex();
 
         // Заносим событие во все группы на всю длину предмета
-        for ( int i = 0; i < subject->GetDuration(); i++ ) {
-            time_table_.at(current_group_name)[start_time + i].SetSubject(subject);
-            time_table_.at(current_group_name)[start_time + i].SetCabinets(cabinets);
-            time_table_.at(current_group_name)[start_time + i].SetStartTime(start_time);
+        for ( size_t i = 0; i < subject->GetDuration(); i++ ) {
+            time_table_[current_group_index][start_time + i].SetSubject(subject);
+            time_table_[current_group_index][start_time + i].SetCabinets(cabinets);
+            time_table_[current_group_index][start_time + i].SetStartTime(start_time);
         }
 
         // Важно, что в event_linker_ событие заносится только после добавления в само расписание, т.е. time_table_,
         // а удаляется в обратном порядке.
-        event_linker_.InsertEvent( current_group_name, time_table_.at(current_group_name)[start_time] );
+        event_linker_.InsertEvent( current_group_index, time_table_[current_group_index][start_time] );
     }
 
+    for ( size_t i = 0; i < subject->GetDuration(); i++ )
+        CConflictGraph::SetBit(slot_subjects_[start_time + i], subject->GetIndex());
+
     // Блокируем время у всех участников события
-    subject->ReserveTime(start_time);
+    occupancy_.ReserveSubject(subject, start_time);
     for (const auto& cabinet : cabinets)
-        cabinet->ReserveTime(start_time, subject->GetDuration());
+        occupancy_.ReserveCabinet(cabinet, start_time, subject->GetDuration());
 }
 
-void CTimeTable::deleteEvent( CSubject *const subject,
+void CTimeTable::deleteEvent( const CSubject *const subject,
                               size_t start_time ) {
     assert(subject);
 
-    subject->ReleaseTime(start_time);
+    // Событие без групп не заносится в расписание, а кабинеты события одни и те же в строках всех его групп
+    assert( !subject->GetGroups().empty() );
+    size_t first_group_index = (*subject->GetGroups().begin())->GetIndex();
+    const auto& cabinets = time_table_[first_group_index][start_time].GetCabinets();
+
+    occupancy_.ReleaseSubject(subject, start_time);
 
-    std::string current_group_name;
     for ( const auto& group : subject->GetGroups() ) {
-        current_group_name = group->GetName();
+        size_t current_group_index = group->GetIndex();
 
         // Важно, что в event_linker_ событие заносится только после добавления в само расписание, т.е. time_table_,
         // а удаляется в обратном порядке.
-        event_linker_.DeleteEvent( current_group_name, time_table_.at(current_group_name)[start_time] );
+        event_linker_.DeleteEvent( current_group_index, time_table_[current_group_index][start_time] );
 
-        for ( int i = 0; i < subject->GetDuration(); i++ )
-            time_table_.at(current_group_name)[start_time + i].SetSubject(nullptr);
+        for ( size_t i = 0; i < subject->GetDuration(); i++ )
+            time_table_[current_group_index][start_time + i].SetSubject(nullptr);
     }
 
+    for ( size_t i = 0; i < subject->GetDuration(); i++ )
+        CConflictGraph::ResetBit(slot_subjects_[start_time + i], subject->GetIndex());
+
     // Освобождаем врямя всех участников
-    const auto& cabinets = GetEvent( current_group_name, start_time ).GetCabinets();
     for (const auto& cabinet : cabinets)
-        cabinet->ReleaseTime(start_time, subject->GetDuration());
+        occupancy_.ReleaseCabinet(cabinet, start_time, subject->GetDuration());
 }
 
-auto CTimeTable::findFeasibleCabinet( CTimeTableGeneratorSupporter& supporter ) const {
-    CSubject *const subject = supporter.GetCurrentSubject();
+auto CTimeTable::findFeasibleCabinet( CTimeTableGeneratorSupporter& supporter, std::vector<CEvent>* moved_events ) {
+    const CSubject *const subject = supporter.GetCurrentSubject();
 
     // Ищем во всех доступных для данного события временах, т.е. стеке времен
     while ( !supporter.CurrentSubjectTimesStackEmpty() ) {
-        std::set<CCabinet *const, Comparator<CCabinet>> feasible_cabinets;
+        CCabinetSet feasible_cabinets;
         size_t start_time = supporter.GetCurrentSubjectStartTime();
 
         for ( const auto& cabinet : subject->GetCabinets() ) {
@@ -134,15 +133,19 @@ auto CTimeTable::findFeasibleCabinet( CTimeTableGeneratorSupporter& supporter )
             if (cabinet->GetCapacity() < subject->GetParticipantsNumber())
                 continue;
             // Проверка на незанятость кабинета на всю длину предмета от рассматриваемого начального времени
-            if (!cabinet->IsFeasible(start_time, subject->GetDuration()))
+            if (!occupancy_.IsCabinetFeasible(cabinet, start_time, subject->GetDuration()))
                 continue;
 
             // Как только нашли нужное для проведения предмета количество кобинетов, возвращаем
             feasible_cabinets.insert(cabinet);
             if ( feasible_cabinets.size() == subject->GetRequiredCabinetsNumber() )
-                return std::move(feasible_cabinets);
+                return feasible_cabinets;
         }
 
+        // Жадно не нашли, но кабинеты могут освободиться, если пересадить уже размещенные события
+        if ( reassignCabinets(subject, start_time, feasible_cabinets, moved_events) )
+            return feasible_cabinets;
+
         supporter.TimesStackPop();
     }
 
@@ -150,8 +153,8 @@ auto CTimeTable::findFeasibleCabinet( CTimeTableGeneratorSupporter& supporter )
     throw CBadCabinetsFind("Can't find cabinet for", subject);
 }
 
-auto CTimeTable::findFeasibleCabinet( CSubject *subject, size_t start_time ) const {
-    std::set<CCabinet *const, Comparator<CCabinet>> feasible_cabinets;
+auto CTimeTable::findFeasibleCabinet( const CSubject *subject, size_t start_time ) const {
+    CCabinetSet feasible_cabinets;
 
     for ( const auto& cabinet : subject->GetCabinets() ) {
 
@@ -160,26 +163,127 @@ auto CTimeTable::findFeasibleCabinet( CSubject *subject, size_t start_time ) con
             continue;
 
         // Проверка на незанятость кабинета на всю длину предмета от рассматриваемого начального времени
-        if (!cabinet->IsFeasible(start_time, subject->GetDuration()))
+        if (!occupancy_.IsCabinetFeasible(cabinet, start_time, subject->GetDuration()))
             continue;
 
         // Как только нашли нужное для проведения предмета количество кобинетов, возвращаем
         feasible_cabinets.insert(cabinet);
         if ( feasible_cabinets.size() == subject->GetRequiredCabinetsNumber() ) {
-            return std::move(feasible_cabinets);
+            return feasible_cabinets;
         }
     }
 
     // Не выкидываем исключение, так как при работе этой версии фукции предполагается проверка на вызывающей стороне
-    return std::set<CCabinet *const, Comparator<CCabinet>> {};
+    return CCabinetSet {};
+}
+
+bool CTimeTable::hasFeasibleCabinets( const CSubject *subject, size_t start_time ) const {
+    size_t feasible_number(0);
+
+    for ( const auto& cabinet : subject->GetCabinets() )
+        if ( cabinet->GetCapacity() >= subject->GetParticipantsNumber() &&
+             occupancy_.IsCabinetFeasible(cabinet, start_time, subject->GetDuration()) &&
+             ++feasible_number == subject->GetRequiredCabinetsNumber() )
+            return true;
+
+    return false;
+}
+
+bool CTimeTable::reassignCabinets( const CSubject* subject, size_t start_time,
+                                   CCabinetSet& cabinets, std::vector<CEvent>* moved_events ) {
+    auto capable = [] (const CSubject* current, const CCabinet* cabinet) {
+        return cabinet->GetCapacity() >= current->GetParticipantsNumber();
+    };
+
+    // Собираем события, занимающие подходящие кабинеты в то же время, затем события, занимающие подходящие
+    // кабинеты уже собранных событий, и т.д. Каждое событие -- одна копия на предмет.
+    std::vector<CEvent> events;
+    std::vector< std::pair<const CSubject*, size_t> > queue { {subject, start_time} };
+    std::set<const CSubject*> collected { subject };
+    for (size_t i = 0; i < queue.size(); i++) {
+        auto [current, current_start_time] = queue[i];
+
+        for (const auto& cabinet : current->GetCabinets()) {
+            if ( !capable(current, cabinet) || occupancy_.IsCabinetFeasible(cabinet, current_start_time, current->GetDuration()) )
+                continue;
+
+            for (const auto& lessons : time_table_)
+                for (size_t time = current_start_time; time < current_start_time + current->GetDuration(); time++) {
+                    const CEvent& event = lessons[time];
+                    if ( event.IsActive() && event.GetCabinets().count(cabinet) &&
+                         collected.insert(event.GetSubject()).second ) {
+                        events.push_back(event);
+                        queue.emplace_back(event.GetSubject(), event.GetStartTime());
+                    }
+                }
+        }
+    }
+    if ( events.empty() )
+        return false;
+
+    for (const auto& event : events)
+        deleteEvent(event.GetSubject(), event.GetStartTime());
+
+    // Левая доля -- требуемые кабинеты предметов ( queue[0] -- сам subject ), правая -- кабинеты.
+    // Кабинеты разных событий различны, даже если события не пересекаются, -- это лишь сужает поиск.
+    std::map<const CCabinet*, size_t, Comparator<CCabinet>> cabinet_indices;
+    std::vector<const CCabinet*> right_cabinets;
+    std::vector<size_t> left_owners;
+    std::vector< std::vector<size_t> > adjacency;
+    for (size_t owner = 0; owner < queue.size(); owner++) {
+        auto [current, current_start_time] = queue[owner];
+
+        std::vector<size_t> neighbours;
+        for (const auto& cabinet : current->GetCabinets()) {
+            if ( !capable(current, cabinet) || !occupancy_.IsCabinetFeasible(cabinet, current_start_time, current->GetDuration()) )
+                continue;
+            if ( !cabinet_indices.count(cabinet) ) {
+                cabinet_indices.insert( {cabinet, right_cabinets.size()} );
+                right_cabinets.push_back(cabinet);
+            }
+            neighbours.push_back(cabinet_indices.at(cabinet));
+        }
+
+        for (size_t k = 0; k < current->GetRequiredCabinetsNumber(); k++) {
+            left_owners.push_back(owner);
+            adjacency.push_back(neighbours);
+        }
+    }
+
+    std::vector<int> match(right_cabinets.size(), -1);
+    bool matched(true);
+    for (size_t left = 0; left < adjacency.size() && matched; left++) {
+        std::vector<bool> visited(right_cabinets.size(), false);
+        matched = FindAugmentingPath(left, adjacency, match, visited);
+    }
+
+    if ( !matched ) {
+        // Распределения нет -- возвращаем события в их кабинеты
+        for (const auto& event : events)
+            insertEvent(event.GetSubject(), event.GetCabinets(), event.GetStartTime());
+        return false;
+    }
+
+    std::vector< CCabinetSet > assigned(queue.size());
+    for (size_t right = 0; right < right_cabinets.size(); right++)
+        if ( match[right] != -1 )
+            assigned[ left_owners[match[right]] ].insert(right_cabinets[right]);
+
+    for (size_t owner = 1; owner < queue.size(); owner++)
+        insertEvent(queue[owner].first, assigned[owner], queue[owner].second);
+    cabinets = std::move(assigned[0]);
+    if (moved_events)
+        moved_events->insert(moved_events->end(), events.begin(), events.end());
+
+    return true;
 }
 
 bool CTimeTable::swappable(const CEvent &from, const CEvent &to) {
     if ( !from.IsActive() || !to.IsActive() )
         return false;
 
-    // один и то же предмет нет смылса менять местами с собой
-    if ( from.GetSubject() == to.GetSubject() )
+    // один и то же предмет нет смылса менять местами с собой, как и две копии одного урока
+    if ( from.GetSubject() == to.GetSubject() || from.GetSubject()->IsCopyOf(*to.GetSubject()) )
         return false;
 
     // Проверка на "перекрытие", т.е. что события достаточно отстают друг от друга, чтобы после
@@ -188,6 +292,11 @@ bool CTimeTable::swappable(const CEvent &from, const CEvent &to) {
          std::max(to.GetSubject()->GetDuration(), from.GetSubject()->GetDuration()) )
         return false;
 
+    // Общий учитель или группа с событиями на новом месте -- перестановка невозможна, и расписание можно не трогать
+    if ( conflictsAt(from.GetSubject(), to.GetStartTime(), to.GetSubject()) ||
+         conflictsAt(to.GetSubject(), from.GetStartTime(), from.GetSubject()) )
+        return false;
+
     // Создаем временные версии событий, чтобы восстановить удаленные для проверки оригиналы
     CEvent from_temp(from), to_temp(to);
 
@@ -221,176 +330,363 @@ bool CTimeTable::movable(const CEvent &from, size_t new_start_time) {
     if ( !from.IsActive() )
         return false;
 
+    if ( conflictsAt(from.GetSubject(), new_start_time, nullptr) )
+        return false;
+
     // Проверяем, входит ли new_start_time в множество возможных в данный момент времен начала для данного предмета
-    int64_t available_start_time = from.GetSubject()->GetAvailableStartTime(days_in_week_, lessons_in_day_);
+    int64_t available_start_time = occupancy_.GetSubjectAvailableStartTime(from.GetSubject(), days_in_week_, lessons_in_day_);
 
     if ( (available_start_time & (static_cast<int64_t>(1) << new_start_time)) !=
          (static_cast<int64_t>(1) << new_start_time) )
         return false;
 
     // Проверяем, найшелся ли кабинет для данного предмета на новое время
-    if ( findFeasibleCabinet(from.GetSubject(), new_start_time).size() < from.GetSubject()->GetRequiredCabinetsNumber() )
+    if ( !hasFeasibleCabinets(from.GetSubject(), new_start_time) )
         return false;
 
     return true;
 }
 
+bool CTimeTable::conflictsAt( const CSubject* subject, size_t start_time, const CSubject* ignored ) {
+    size_t end_time = std::min( start_time + subject->GetDuration(), slot_subjects_.size() );
+    std::fill(conflicts_row_.begin(), conflicts_row_.end(), 0);
+    for (size_t time = start_time; time < end_time; time++)
+        for (size_t word = 0; word < conflicts_row_.size(); word++)
+            conflicts_row_[word] |= slot_subjects_[time][word];
+    if (ignored)
+        CConflictGraph::ResetBit(conflicts_row_, ignored->GetIndex());
+    return problem_->conflict_graph_->ConflictsWithAny(subject->GetIndex(), conflicts_row_);
+}
+
 bool CTimeTable::move(const CEvent &from, size_t new_start_time) {
     insertEvent(from.GetSubject(), findFeasibleCabinet(from.GetSubject(), new_start_time), new_start_time);
     deleteEvent(from.GetSubject(), from.GetStartTime());
+    return true;
 }
 
-//______________________________________________________________________________________________________________________
-// КОНСТРУКТОРЫ
-//______________________________________________________________________________________________________________________
-
-// TODO
-// Очень неоптимально : скорее всего куча узких мест, которые тормозят программу
-CTimeTable::CTimeTable(const CTimeTable &timetable)
-        : teachers_(timetable.teachers_),
-          cabinets_(timetable.cabinets_),
-          groups_(timetable.groups_),
-          event_linker_(timetable.subjects_, timetable.groups_),
-          days_in_week_(timetable.days_in_week_),
-          lessons_in_day_(timetable.lessons_in_day_) {
+bool CTimeTable::placeSubjects( CTimeTableGeneratorSupporter& generator_supporter, int max_iteration_count,
+                                GeneratorStats* stats, std::vector<CEvent>* moved_events ) {
+    int iteration_counter(0);
+    std::vector< std::pair<const CSubject *, size_t> > subjects_to_delete;
 
-    for (auto& pair : timetable.subjects_) {
-        CSubject subject = pair.second;
-        CSubjectBuilder subject_builder;
+    // Пока очередь предметов для размещения в расписании не пуста.
+    // При этом, даже если очередь уже пуста, необходимо, чтобы последнее размещение
+    // прошло удачно, так как, в противном случае, расписание еще не корректно.
+    while (!generator_supporter.QueueEmpty() || !generator_supporter.IsLastSuccessful()) {
 
-        subject_builder.SetSubjectName(subject.GetName());
-        subject_builder.SetSubjectId(subject.GetId());
-        subject_builder.SetSubjectDuration(subject.GetDuration());
-        subject_builder.SetRequiredCabinetNumber(subject.GetRequiredCabinetsNumber());
-        subject_builder.SetFeasibleTime(subject.GetFeasibleTime());
+        if (iteration_counter++ > max_iteration_count)
+            return false;
 
-        std::set< CGroup *const, Comparator<CGroup> > subject_groups;
-        for (auto& subject_group : subject.GetGroups())
-            subject_groups.insert( &groups_.at(subject_group->GetName()) );
+        CCabinetSet feasible_cabinets;
 
-        std::set< CCabinet *const, Comparator<CCabinet> > subject_cabinets;
-        for (auto& subject_cabinet : subject.GetCabinets())
-            subject_cabinets.insert( &cabinets_.at(subject_cabinet->GetName()) );
+        try {
 
-        std::set< CTeacher *const, Comparator<CTeacher> > subject_teachers;
-        for (auto& subject_teacher : subject.GetTeachers())
-            subject_teachers.insert( &teachers_.at(subject_teacher->GetName()) );
+            // В subjects_to_delete после выполнения MakeIteration будут находиться
+            // пары -- предмет, который нужно удалить из расписания x время начала, события, представляющего
+            // этот предмет. Если ничего удалять не нужно, то и subjects_to_delete будет пуст.
+            subjects_to_delete.clear();
+            // MakeIteration оставит на вершине стека предметов вспомогательного класса generator_supporter
+            // предмет, который нужно разместить в расписании на время, находящееся на вершине стека времени, или
+            // выкидывает исключение, если стек времени оказался пуст. Если стек предметов оказался пуст, значит мы
+            // проверили все возможные варианты расписаний и ни одно не оказалось корректным.
+            generator_supporter.MakeIteration(subjects_to_delete);
+            // Удаление событий после бэктрэка
+            for (const auto &subject_to_delete : subjects_to_delete)
+                deleteEvent(subject_to_delete.first, subject_to_delete.second);
 
-        subject_builder.SetSubjectGroups(subject_groups);
-        subject_builder.SetSubjectTeachers(subject_teachers);
-        subject_builder.SetSubjectCabinets(subject_cabinets);
+            try {
+                // Если исключение на предыдущем шаге выброшено не было, значит на вершине стека предметов
+                // лежит предмет, ожидающий размещение в расписание.
+                feasible_cabinets = findFeasibleCabinet(generator_supporter, moved_events);
+            } catch (CBadCabinetsFind &exc) {
+                throw CBadSubjectPlacement("Can't place subject", exc.GetSubject());
+            }
 
+        } catch (CBadSubjectPlacement &exc) {
+            // Если на одном из этапов было выброшено исключение, значит размещение очередного предмета завершилось
+            // неудачей. Для того, чтобы сделать бэетрэк на следующей итерации, ставим флаг.
+            generator_supporter.SetFailureFlag();
+            if (stats)
+                stats->backtracks++;
+            continue;
+        }
 
-        subjects_.insert( std::make_pair(pair.first, subject_builder.Build()) );
+        // Если дошли до этого места, значит готовы к размещению в рассписание нового события
+        insertEvent(generator_supporter.GetCurrentSubject(),
+                    feasible_cabinets,
+                    generator_supporter.GetCurrentSubjectStartTime());
     }
 
-    for (const auto& i : groups_)
-        time_table_.insert( { i.first, std::vector<CEvent>(days_in_week_ * lessons_in_day_) } );
-
-    for (const auto& [group_name, events] : timetable.time_table_)
-        for (int time = 0; time < events.size(); time++) {
-            if ( !events[time].IsActive() ) {
-                continue;
-            }
-            time_table_.at(group_name)[time].SetSubject(&subjects_.at(events[time].GetSubject()->GetName()));
+    return true;
+}
 
-            std::set<CCabinet *const, Comparator<CCabinet>> cabinets {};
-            for (const auto& cabinet : events[time].GetCabinets()) {
-                cabinets.insert(&cabinets_.at(cabinet->GetName()));
-            }
-            time_table_.at(group_name)[time].SetCabinets(cabinets);
-            time_table_.at(group_name)[time].SetStartTime(events[time].GetStartTime());
+void CTimeTable::collectEvents( RuinType ruin_type, std::vector<CEvent>& events ) const {
+    const size_t time_slots_number = days_in_week_ * lessons_in_day_;
+
+    // Выбираем случайный день, учителя или группу и собираем все события, которые к ним относятся.
+    // Каждый предмет представлен в расписании ровно одним событием, поэтому повторы отсекаются по номеру предмета.
+    static thread_local std::vector<bool> collected;
+    collected.assign(problem_->subjects_.size(), false);
+    auto collect = [&events] (const CEvent& event) {
+        if ( event.IsActive() && !collected[event.GetSubject()->GetIndex()] ) {
+            collected[event.GetSubject()->GetIndex()] = true;
+            events.push_back(event);
         }
-
-    for (const auto& [group_name, events] : time_table_)
-        for (int time = 0; time < events.size();) {
-            if ( !events[time].IsActive() ) {
-                time++;
-                continue;
-            }
-            event_linker_.InsertEvent(group_name, time_table_.at(group_name)[time]);
-            time += time_table_.at(group_name)[time].GetSubject()->GetDuration();
+    };
+
+    switch (ruin_type) {
+        case RuinType::Day: {
+            size_t day = RandomIndex(days_in_week_);
+            for (const auto& lessons : time_table_)
+                for (size_t lesson = 0; lesson < lessons_in_day_; lesson++)
+                    if ( lessons[day * lessons_in_day_ + lesson].GetStartTime() / lessons_in_day_ == day )
+                        collect( lessons[day * lessons_in_day_ + lesson] );
+            break;
         }
+        case RuinType::Teacher: {
+            auto teacher = std::next( problem_->teachers_.begin(), RandomIndex(problem_->teachers_.size()) );
+            for (const auto& lessons : time_table_)
+                for (size_t time = 0; time < time_slots_number; time++)
+                    if ( lessons[time].IsActive() &&
+                         lessons[time].GetTeachers().count( &teacher->second ) )
+                        collect( lessons[time] );
+            break;
+        }
+        case RuinType::Group: {
+            const auto& group = time_table_[ RandomIndex(time_table_.size()) ];
+            for (const auto& event : group)
+                collect(event);
+            break;
+        }
+    }
 }
 
-// TODO
-// Очень неоптимально : скорее всего куча узких мест, которые тормозят программу
-CTimeTable& CTimeTable::operator=(const CTimeTable &timetable) {
+// Предельное количество итераций генератора на один удаленный предмет при повторном размещении
+const int RECREATE_ITERATION_COUNT_PER_SUBJECT (50);
 
-    teachers_.clear();
-    cabinets_.clear();
-    groups_.clear();
-    subjects_.clear();
-    time_table_.clear();
+bool CTimeTable::recreateEvents( const std::vector<CEvent>& ruined_events, int64_t allowed_start_time,
+                                 GeneratorStats* stats ) {
+    if ( ruined_events.empty() )
+        return false;
 
-    for (const auto& teacher : timetable.teachers_)
-        teachers_.insert( teacher );
-    for (const auto& cabinet : timetable.cabinets_)
-        cabinets_.insert( cabinet );
-    for (const auto& group : timetable.groups_)
-        groups_.insert( group );
+    // Буферы свои у каждого потока и переиспользуются между вызовами
+    static thread_local std::vector<const CSubject*> ruined_subjects;
+    ruined_subjects.clear();
+    for (const auto& event : ruined_events) {
+        ruined_subjects.push_back(event.GetSubject());
+        deleteEvent(event.GetSubject(), event.GetStartTime());
+    }
 
-    days_in_week_ = timetable.days_in_week_;
-    lessons_in_day_ = timetable.lessons_in_day_;
+    CTimeTableGeneratorSupporter generator_supporter(ruined_subjects, allowed_start_time, occupancy_,
+                                                     days_in_week_, lessons_in_day_,
+                                                     problem_->conflict_graph_.get());
+
+    // Размещая удаленные предметы, генератор может пересадить в другие кабинеты и оставшиеся события
+    // ( reassignCabinets ); их исходные кабинеты нужны для отката
+    static thread_local std::vector<CEvent> moved_events;
+    moved_events.clear();
+    bool recreated(false);
+    try {
+        recreated = placeSubjects(generator_supporter,
+                                  RECREATE_ITERATION_COUNT_PER_SUBJECT * static_cast<int>(ruined_subjects.size()),
+                                  stats, &moved_events);
+    } catch (CBadTimeTable& exc) {
+        recreated = false;
+    }
 
-    for (auto& pair : timetable.subjects_) {
-        CSubject subject = pair.second;
-        CSubjectBuilder subject_builder;
+    if (recreated)
+        return true;
+
+    // Не удалось: убираем то, что успели разместить, возвращаем пересаженные события в исходные кабинеты ( первая
+    // запись о событии -- исходная ), затем исходные события на место. Сначала удаляется все, чтобы при вставке
+    // ни один кабинет не оказался занят дважды.
+    std::set<const CSubject*> ruined(ruined_subjects.begin(), ruined_subjects.end());
+    removeSubjects(ruined);
+
+    std::set<const CSubject*> restored;
+    std::vector<CEvent> restored_events;
+    for (const auto& event : moved_events)
+        if ( !ruined.count(event.GetSubject()) && restored.insert(event.GetSubject()).second )
+            restored_events.push_back(event);
+
+    for (const auto& event : restored_events)
+        deleteEvent(event.GetSubject(), event.GetStartTime());
+    for (const auto& event : restored_events)
+        insertEvent(event.GetSubject(), event.GetCabinets(), event.GetStartTime());
+    for (const auto& event : ruined_events)
+        insertEvent(event.GetSubject(), event.GetCabinets(), event.GetStartTime());
+
+    return false;
+}
 
-        subject_builder.SetSubjectName(subject.GetName());
-        subject_builder.SetSubjectId(subject.GetId());
-        subject_builder.SetSubjectDuration(subject.GetDuration());
-        subject_builder.SetRequiredCabinetNumber(subject.GetRequiredCabinetsNumber());
-        subject_builder.SetFeasibleTime(subject.GetFeasibleTime());
+void CTimeTable::eventsStartingAt( size_t start_time, std::vector<CEvent>& events ) const {
+    // Событие нескольких групп стоит в строке каждой из них. Событий одного времени не больше, чем групп, поэтому
+    // повтор ищется перебором уже собранных.
+    for (const auto& lessons : time_table_) {
+        const CEvent& event = lessons[start_time];
+        if ( !event.IsActive() || event.GetStartTime() != start_time )
+            continue;
+        auto same_subject = [&event] (const CEvent& collected) { return collected.GetSubject() == event.GetSubject(); };
+        if ( std::none_of(events.begin(), events.end(), same_subject) )
+            events.push_back(event);
+    }
+}
 
-        std::set< CGroup *const, Comparator<CGroup> > subject_groups;
-        for (auto& subject_group : subject.GetGroups())
-            subject_groups.insert( &groups_.at(subject_group->GetName()) );
+bool CTimeTable::conflicting( const CEvent& first, const CEvent& second ) const {
+    return problem_->conflict_graph_->Conflicting(first.GetSubject()->GetIndex(), second.GetSubject()->GetIndex()) ||
+           Intersects(first.GetCabinets(), second.GetCabinets());
+}
 
-        std::set< CCabinet *const, Comparator<CCabinet> > subject_cabinets;
-        for (auto& subject_cabinet : subject.GetCabinets())
-            subject_cabinets.insert( &cabinets_.at(subject_cabinet->GetName()) );
+bool CTimeTable::kempeChain( const CEvent& event, size_t other_time, std::vector<CEvent>& chain ) const {
+    // Цепь Кемпе -- компонента связности графа конфликтов на событиях двух времен, содержащая event. Ребро есть
+    // между событиями разных времен с общим учителем, группой или кабинетом. Если перенести всю компоненту на
+    // противоположное время, новых конфликтов не появится.
+    // Буферы свои у каждого потока и переиспользуются между вызовами
+    static thread_local std::vector<CEvent> sides[2];
+    static thread_local std::vector<bool> in_chain[2];
+    // Очередь обхода: ( сторона, номер события на стороне )
+    static thread_local std::vector< std::pair<size_t, size_t> > queue;
+
+    sides[0].clear();
+    sides[1].clear();
+    queue.clear();
+    eventsStartingAt(event.GetStartTime(), sides[0]);
+    eventsStartingAt(other_time, sides[1]);
+    in_chain[0].assign(sides[0].size(), false);
+    in_chain[1].assign(sides[1].size(), false);
+
+    for (size_t i = 0; i < sides[0].size(); i++)
+        if ( sides[0][i].GetSubject() == event.GetSubject() ) {
+            in_chain[0][i] = true;
+            queue.emplace_back(0, i);
+        }
 
-        std::set< CTeacher *const, Comparator<CTeacher> > subject_teachers;
-        for (auto& subject_teacher : subject.GetTeachers())
-            subject_teachers.insert( &teachers_.at(subject_teacher->GetName()) );
+    for (size_t head = 0; head < queue.size(); head++) {
+        auto [side, index] = queue[head];
+        const CEvent& current = sides[side][index];
 
-        subject_builder.SetSubjectGroups(subject_groups);
-        subject_builder.SetSubjectTeachers(subject_teachers);
-        subject_builder.SetSubjectCabinets(subject_cabinets);
+        // Пока поддерживаются только события единичной длины: длинные события занимают несколько времен
+        if ( current.GetSubject()->GetDuration() != 1 )
+            return false;
 
-        subjects_.insert( std::make_pair(pair.first, subject_builder.Build()) );
+        size_t other_side = 1 - side;
+        for (size_t i = 0; i < sides[other_side].size(); i++)
+            if ( !in_chain[other_side][i] && conflicting(current, sides[other_side][i]) ) {
+                in_chain[other_side][i] = true;
+                queue.emplace_back(other_side, i);
+            }
     }
 
-    event_linker_ = CEventLinker(subjects_, groups_);
+    for (const auto& [side, index] : queue)
+        chain.push_back(sides[side][index]);
 
-    for (const auto& i : groups_)
-        time_table_.insert( { i.first, std::vector<CEvent>(days_in_week_ * lessons_in_day_) } );
+    return true;
+}
 
-    for (const auto& [group_name, events] : timetable.time_table_)
-        for (int time = 0; time < events.size(); time++) {
-            if ( !events[time].IsActive() ) {
-                continue;
-            }
-            time_table_.at(group_name)[time].SetSubject(&subjects_.at(events[time].GetSubject()->GetName()));
+bool CTimeTable::kempeSwap( const std::vector<CEvent>& chain, size_t first_time, size_t second_time ) {
+    for (const auto& event : chain)
+        deleteEvent(event.GetSubject(), event.GetStartTime());
 
-            std::set<CCabinet *const, Comparator<CCabinet>> cabinets {};
-            for (const auto& cabinet : events[time].GetCabinets()) {
-                cabinets.insert(&cabinets_.at(cabinet->GetName()));
-            }
-            time_table_.at(group_name)[time].SetCabinets(cabinets);
-            time_table_.at(group_name)[time].SetStartTime(events[time].GetStartTime());
+    // Конфликтов внутри расписания перенос цепи не создает, но время начала может запрещать маска доступности
+    // учителя, группы, кабинета или самого предмета. Кабинеты по возможности сохраняются.
+    size_t inserted(0);
+    for (; inserted < chain.size(); inserted++) {
+        const CEvent& event = chain[inserted];
+        const CSubject *const subject = event.GetSubject();
+        size_t new_time = event.GetStartTime() == first_time ? second_time : first_time;
+
+        if ( !(occupancy_.GetSubjectAvailableStartTime(subject, days_in_week_, lessons_in_day_) &
+              (static_cast<int64_t>(1) << new_time)) )
+            break;
+
+        bool cabinets_free(true);
+        for (const auto& cabinet : event.GetCabinets())
+            cabinets_free &= occupancy_.IsCabinetFeasible(cabinet, new_time, subject->GetDuration());
+
+        if (cabinets_free) {
+            insertEvent(subject, event.GetCabinets(), new_time);
+            continue;
         }
 
-    for (const auto& [group_name, events] : time_table_)
-        for (int time = 0; time < events.size();) {
-            if ( !events[time].IsActive() ) {
-                time++;
-                continue;
+        auto cabinets = findFeasibleCabinet(subject, new_time);
+        if ( cabinets.size() < subject->GetRequiredCabinetsNumber() )
+            break;
+        insertEvent(subject, cabinets, new_time);
+    }
+
+    if ( inserted == chain.size() )
+        return true;
+
+    // Откат: убираем перенесенное и возвращаем цепь на место
+    for (size_t i = 0; i < inserted; i++)
+        deleteEvent(chain[i].GetSubject(), chain[i].GetStartTime() == first_time ? second_time : first_time);
+    for (const auto& event : chain)
+        insertEvent(event.GetSubject(), event.GetCabinets(), event.GetStartTime());
+
+    return false;
+}
+
+void CTimeTable::removeSubjects( const std::set<const CSubject*>& subjects ) {
+    for (const auto& subject : subjects) {
+        const auto& lessons = time_table_[ (*subject->GetGroups().begin())->GetIndex() ];
+        for (size_t time = 0; time < lessons.size(); time++)
+            if ( lessons[time].GetSubject() == subject && lessons[time].GetStartTime() == time ) {
+                deleteEvent(subject, time);
+                break;
             }
-            event_linker_.InsertEvent(group_name, time_table_.at(group_name)[time]);
-            time += time_table_.at(group_name)[time].GetSubject()->GetDuration();
+    }
+}
+
+//______________________________________________________________________________________________________________________
+// КОНСТРУКТОРЫ
+//______________________________________________________________________________________________________________________
+
+// Данные задачи общие, поэтому указатели событий на предметы и кабинеты остаются верными и в копии. Заново
+// строится только связыватель событий, хранящий адреса событий этого объекта.
+CTimeTable::CTimeTable(const CTimeTable &timetable)
+        : problem_(timetable.problem_),
+          days_in_week_(timetable.days_in_week_),
+          lessons_in_day_(timetable.lessons_in_day_),
+          occupancy_(timetable.occupancy_),
+          time_table_(timetable.time_table_),
+          event_linker_(problem_->subjects_, problem_->groups_),
+          slot_subjects_(timetable.slot_subjects_),
+          conflicts_row_(timetable.conflicts_row_) {
+    TRACE_SCOPE("CTimeTable copy");
+    linkEvents();
+}
+
+CTimeTable& CTimeTable::operator=(const CTimeTable &timetable) {
+    TRACE_SCOPE("CTimeTable assign");
+    if (this == &timetable)
+        return *this;
+
+    // Память занятости, событий и связывателя переиспользуется: у копий одной задачи размеры совпадают,
+    // поэтому присваивание в готовое расписание ( как делают оптимизаторы ) не обращается к куче.
+    if (problem_ == timetable.problem_) {
+        event_linker_.FreeEvents();
+    } else {
+        problem_ = timetable.problem_;
+        event_linker_ = CEventLinker(problem_->subjects_, problem_->groups_);
+    }
+
+    days_in_week_ = timetable.days_in_week_;
+    lessons_in_day_ = timetable.lessons_in_day_;
+    occupancy_ = timetable.occupancy_;
+    slot_subjects_ = timetable.slot_subjects_;
+    conflicts_row_ = timetable.conflicts_row_;
+
+    time_table_.resize( timetable.time_table_.size() );
+    for (size_t group_index = 0; group_index < time_table_.size(); group_index++) {
+        const auto& events = timetable.time_table_[group_index];
+        time_table_[group_index].resize( events.size() );
+        for (size_t time = 0; time < events.size(); time++) {
+            time_table_[group_index][time].SetSubject( events[time].GetSubject() );
+            time_table_[group_index][time].SetCabinets( events[time].GetCabinets() );
+            time_table_[group_index][time].SetStartTime( events[time].GetStartTime() );
         }
+    }
+    linkEvents();
 
     return *this;
 }
@@ -403,11 +699,12 @@ const int MAX_ATTEMPTS_COUNT (10);
 const int MAX_ITERATION_COUNT (10000);
 
 // Точка входа в генерацию корректного случайного расписания
-void CTimeTable::GenerateTimeTable() {
+void CTimeTable::GenerateTimeTable( GeneratorStats* stats ) {
+    TRACE_SCOPE("GenerateTimeTable");
 
     // Возможно такое, что попытка создать расписание уйдет в экспоненциальную сложность, тогда следует прервать
-    // генерацию и начать сначала. Для этого служит счетчик iteration_counter. Его предельное значение должно зависеть
-    // от длины расписания => TODO
+    // генерацию и начать сначала. Для этого служит предельное количество итераций в placeSubjects. Его значение
+    // должно зависеть от длины расписания => TODO
     // Проверка невозможности создать расписание так же NPC, следовательно, если не получается создать расписание
     // некоторое количество раз подряд, выкидываем исключение. Предельное значение количества попыток
     // тоже должно зависеть от длины => TODO
@@ -415,140 +712,209 @@ void CTimeTable::GenerateTimeTable() {
     while (true) {
         if (attempts_counter++ > MAX_ATTEMPTS_COUNT)
             throw CBadTimeTable("Can't create timetable");
-        int iteration_counter(0);
-        // Флаг удачности попытки
-        bool bad_try(false);
 
         // Хранилище предметов -- очередь с приоритетом по занятости
         // преподавателей + стек добавлений в расписание. В каждый момент
         // времени их объединение дает множество всех предметов в учебном плане.
-        CTimeTableGeneratorSupporter generator_supporter(subjects_,
-                                                         days_in_week_, lessons_in_day_);
+        CTimeTableGeneratorSupporter generator_supporter(problem_->subjects_, occupancy_,
+                                                         days_in_week_, lessons_in_day_,
+                                                         problem_->conflict_graph_.get());
 
-        // Пока очередь предметов для размещения в расписании не пуста.
-        // При этом, даже если очередь уже пуста, необходимо, чтобы последнее размещение
-        // прошло удачно, так как, в противном случае, расписание еще не корректно.
-        while (!generator_supporter.QueueEmpty() || !generator_supporter.IsLastSuccessful()) {
+        // Если попытка не неудачная, выходим
+        if ( placeSubjects(generator_supporter, MAX_ITERATION_COUNT, stats) )
+            break;
 
-            if (iteration_counter++ > MAX_ITERATION_COUNT) {
-                RecoverTimeTable();
-                bad_try = true;
-                break;
-            }
+        if (stats)
+            stats->restarts++;
+        RecoverTimeTable();
+    }
+}
 
-            std::set<CCabinet *const, Comparator<CCabinet>> feasible_cabinets;
+void CTimeTable::RecoverTimeTable() {
+    occupancy_ = COccupancy(problem_->teachers_, problem_->groups_, problem_->cabinets_);
 
-            try {
+    for(auto& group_schedule : time_table_)
+        for (auto& event : group_schedule)
+            event.FreeEvent();
+    for (auto& subjects : slot_subjects_)
+        std::fill(subjects.begin(), subjects.end(), 0);
 
-                // В subjects_to_delete после выполнения MakeIteration будут находиться
-                // пары -- предмет, который нужно удалить из расписания x время начала, события, представляющего
-                // этот предмет. Если ничего удалять не нужно, то и subjects_to_delete будет пуст.
-                std::vector< std::pair<CSubject *, size_t> > subjects_to_delete;
-                // MakeIteration оставит на вершине стека предметов вспомогательного класса generator_supporter
-                // предмет, который нужно разместить в расписании на время, находящееся на вершине стека времени, или
-                // выкидывает исключение, если стек времени оказался пуст. Если стек предметов оказался пуст, значит мы
-                // проверили все возможные варианты расписаний и ни одно не оказалось корректным.
-                generator_supporter.MakeIteration(subjects_to_delete);
-                // Удаление событий после бэктрэка
-                for (const auto &subject_to_delete : subjects_to_delete)
-                    deleteEvent(subject_to_delete.first, subject_to_delete.second);
-
-                try {
-                    // Если исключение на предыдущем шаге выброшено не было, значит на вершине стека предметов
-                    // лежит предмет, ожидающий размещение в расписание.
-                    feasible_cabinets = findFeasibleCabinet(generator_supporter);
-                } catch (CBadCabinetsFind &exc) {
-                    throw CBadSubjectPlacement("Can't place subject", exc.GetSubject());
-                }
+    event_linker_.FreeEvents();
+}
 
-            } catch (CBadSubjectPlacement &exc) {
-                // Если на одном из этапов было выброшено исключение, значит размещение очередного предмета завершилось
-                // неудачей. Для того, чтобы сделать бэетрэк на следующей итерации, ставим флаг.
-                generator_supporter.SetFailureFlag();
-                continue;
-            }
+bool CTimeTable::RuinAndRecreate(RuinType ruin_type) {
+    TRACE_SCOPE("RuinAndRecreate");
+    static thread_local std::vector<CEvent> ruined_events;
+    ruined_events.clear();
+    collectEvents(ruin_type, ruined_events);
 
-            // Если дошли до этого места, значит готовы к размещению в рассписание нового события
-            insertEvent(generator_supporter.GetCurrentSubject(),
-                        feasible_cabinets,
-                        generator_supporter.GetCurrentSubjectStartTime());
-        }
+    // Повторное размещение разрешено только на освободившиеся времена начала
+    int64_t freed_start_time(0);
+    for (const auto& event : ruined_events)
+        freed_start_time |= static_cast<int64_t>(1) << event.GetStartTime();
 
-        // Если попытка не неудачная, выходим
-        if (!bad_try)
-            break;
-    }
+    return recreateEvents(ruined_events, freed_start_time);
 }
 
-void CTimeTable::RecoverTimeTable() {
-    for (auto& teacher : teachers_)
-        teacher.second.RecoverTeacher();
-
-    for(auto& group : groups_)
-        group.second.RecoverGroup();
+bool CTimeTable::Perturb( double fraction, GeneratorStats* stats ) {
+    TRACE_SCOPE("Perturb");
+    // Собираем по одному событию на предмет. Буферы свои у каждого потока и переиспользуются между вызовами.
+    static thread_local std::vector<CEvent> events;
+    static thread_local std::vector<bool> collected;
+    events.clear();
+    collected.assign(problem_->subjects_.size(), false);
+    for (const auto& lessons : time_table_)
+        for (const auto& event : lessons)
+            if ( event.IsActive() && !collected[event.GetSubject()->GetIndex()] ) {
+                collected[event.GetSubject()->GetIndex()] = true;
+                events.push_back(event);
+            }
 
-    for(auto& cabinet : cabinets_)
-        cabinet.second.RecoverCabinet();
+    if ( events.empty() )
+        return false;
 
-    for(auto& group_schedule : time_table_)
-        for (auto& event : group_schedule.second)
-            event.FreeEvent();
+    RandomPermutation(events);
+    size_t ruined_number = std::max( static_cast<size_t>(1), static_cast<size_t>(fraction * events.size()) );
+    events.resize( std::min(ruined_number, events.size()) );
 
-    event_linker_.FreeEvents();
+    return recreateEvents(events, ~static_cast<int64_t>(0), stats);
 }
 
-void CTimeTable::RandomSwap() {
-    // Создаем векторы времен, заполняем их случайной перестановкой [0..days_in_week_*lessons_in_day_-1]
-    // Создаем вектор случайных перестановок имен групп
-    std::vector<size_t> times_from(days_in_week_*lessons_in_day_), times_to(days_in_week_*lessons_in_day_);
-    std::vector<std::string> groups;
+// Случайный порядок перебора групп и времен для операторов окрестности. Векторы свои у каждого потока и
+// переиспользуются между вызовами, поэтому шаг оптимизации не выделяет под них память.
+struct CNeighbourhoodOrder {
+    std::vector<size_t> groups;
+    std::vector<size_t> times_from;
+    std::vector<size_t> times_to;
+};
 
-    std::iota(times_from.begin(), times_from.end(), 0);
-    std::iota(times_to.begin(), times_to.end(), 0);
-    RandomPermutation(times_from);
-    RandomPermutation(times_to);
+const CNeighbourhoodOrder& CTimeTable::randomNeighbourhoodOrder() const {
+    static thread_local CNeighbourhoodOrder order;
 
-    for (const auto& group : groups_)
-        groups.push_back(group.first);
-    RandomPermutation(groups);
+    RandomOrder(time_table_.size(), order.groups);
+    RandomOrder(days_in_week_ * lessons_in_day_, order.times_from);
+    RandomOrder(days_in_week_ * lessons_in_day_, order.times_to);
+
+    return order;
+}
+
+bool CTimeTable::RandomSwap( std::vector<MoveAttribute>* attributes, size_t* rejected ) {
+    // Случайные перестановки номеров групп и времен [0..days_in_week_*lessons_in_day_-1]
+    const auto& [groups, times_from, times_to] = randomNeighbourhoodOrder();
+    size_t rejected_number(0);
 
     // Проходим по всем вариантам пар событий, проверяем на "переставляемость".
     // Если находим -- меняем местами.
     for (auto& group : groups)
         for (auto time_from : times_from)
-            for (auto time_to : times_to)
-                if ( swappable( time_table_.at(group)[time_from],
-                                time_table_.at(group)[time_to] ) ) {
-                    swap( time_table_.at(group)[time_from],
-                          time_table_.at(group)[time_to] );
-                    return;
+            for (auto time_to : times_to) {
+                if ( !swappable( time_table_[group][time_from],
+                                 time_table_[group][time_to] ) ) {
+                    rejected_number++;
+                    continue;
                 }
-}
 
-void CTimeTable::RandomMove() {
-    // Создаем векторы времен, заполняем их случайной перестановкой [0..days_in_week_*lessons_in_day_-1]
-    // Создаем вектор случайных перестановок имен групп
-    std::vector<size_t> times_from(days_in_week_*lessons_in_day_), times_to(days_in_week_*lessons_in_day_);
-    std::vector<std::string> groups;
+                const CEvent& from = time_table_[group][time_from];
+                const CEvent& to = time_table_[group][time_to];
+                if (attributes) {
+                    attributes->push_back( { from.GetSubject()->GetIndex(), from.GetStartTime(), to.GetStartTime() } );
+                    attributes->push_back( { to.GetSubject()->GetIndex(), to.GetStartTime(), from.GetStartTime() } );
+                }
+                swap( time_table_[group][time_from],
+                      time_table_[group][time_to] );
+                if (rejected)
+                    *rejected += rejected_number;
+                return true;
+            }
 
-    std::iota(times_from.begin(), times_from.end(), 0);
-    std::iota(times_to.begin(), times_to.end(), 0);
-    RandomPermutation(times_from);
-    RandomPermutation(times_to);
+    if (rejected)
+        *rejected += rejected_number;
+    return false;
+}
 
-    for (const auto& group : groups_)
-        groups.push_back(group.first);
-    RandomPermutation(groups);
+bool CTimeTable::RandomMove( std::vector<MoveAttribute>* attributes, size_t* rejected ) {
+    // Случайные перестановки номеров групп и времен [0..days_in_week_*lessons_in_day_-1]
+    const auto& [groups, times_from, times_to] = randomNeighbourhoodOrder();
+    size_t rejected_number(0);
 
     // Проходим по всем вариантам пар (событие, время), проверяем на "переносимость".
     // Если находим -- переносим.
     for (auto& group : groups)
         for (auto time_from : times_from)
-            for (auto time_to : times_to)
-                if ( movable( time_table_.at(group)[time_from], time_to ) ) {
-                    move( time_table_.at(group)[time_from], time_to );
-                    return;
+            for (auto time_to : times_to) {
+                if ( !movable( time_table_[group][time_from], time_to ) ) {
+                    rejected_number++;
+                    continue;
+                }
+
+                const CEvent& from = time_table_[group][time_from];
+                if (attributes)
+                    attributes->push_back( { from.GetSubject()->GetIndex(), from.GetStartTime(), time_to } );
+                move( time_table_[group][time_from], time_to );
+                if (rejected)
+                    *rejected += rejected_number;
+                return true;
+            }
+
+    if (rejected)
+        *rejected += rejected_number;
+    return false;
+}
+
+bool CTimeTable::RandomKempeSwap( std::vector<MoveAttribute>* attributes, size_t* rejected ) {
+    // Перебираем случайные пары ( событие, другое время ), пока не найдется цепь, которую можно перенести
+    const auto& [groups, times_from, times_to] = randomNeighbourhoodOrder();
+    static thread_local std::vector<CEvent> chain;
+    size_t rejected_number(0);
+
+    for (auto& group : groups)
+        for (auto time_from : times_from) {
+            const CEvent& event = time_table_[group][time_from];
+            if ( !event.IsActive() || event.GetStartTime() != time_from )
+                continue;
+
+            for (auto time_to : times_to) {
+                if (time_to == time_from)
+                    continue;
+
+                chain.clear();
+                if ( !kempeChain(event, time_to, chain) || !kempeSwap(chain, time_from, time_to) ) {
+                    rejected_number++;
+                    continue;
                 }
+
+                if (attributes)
+                    for (const auto& chain_event : chain)
+                        attributes->push_back( { chain_event.GetSubject()->GetIndex(), chain_event.GetStartTime(),
+                                                 chain_event.GetStartTime() == time_from ? time_to : time_from } );
+                if (rejected)
+                    *rejected += rejected_number;
+                return true;
+            }
+        }
+
+    if (rejected)
+        *rejected += rejected_number;
+    return false;
+}
+
+void CTimeTable::ImportEvents(const CTimeTable& part) {
+    for (const auto& [group_name, group] : part.problem_->groups_) {
+        const auto& lessons = part.time_table_[group.GetIndex()];
+        for (size_t time = 0; time < lessons.size(); time++) {
+            const CEvent& event = lessons[time];
+            // Событие нескольких групп переносим один раз -- по первой группе
+            if ( !event.IsActive() || event.GetStartTime() != time ||
+                 *event.GetSubject()->GetGroups().begin() != &group )
+                continue;
+
+            CCabinetSet cabinets;
+            for (const auto& cabinet : event.GetCabinets())
+                cabinets.insert( &problem_->cabinets_.at(cabinet->GetName()) );
+
+            insertEvent( &problem_->subjects_.at(event.GetName()), cabinets, time );
+        }
+    }
 }
 
 //______________________________________________________________________________________________________________________
@@ -556,11 +922,54 @@ void CTimeTable::RandomMove() {
 //______________________________________________________________________________________________________________________
 
 const CSubject& CTimeTable::GetSubject(std::string subject_name) const {
-    return subjects_.at(subject_name);
+    return problem_->subjects_.at(subject_name);
+}
+
+size_t CTimeTable::CountConflicts() const {
+    const size_t time_slots_number = days_in_week_ * lessons_in_day_;
+    size_t conflicts(0);
+
+    for (size_t time = 0; time < time_slots_number; time++) {
+        std::vector<size_t> teachers_use( problem_->teachers_.size() );
+        std::vector<size_t> cabinets_use( problem_->cabinets_.size() );
+        std::set<const CSubject*> seen;
+
+        for (size_t group_index = 0; group_index < time_table_.size(); group_index++) {
+            const CEvent& event = time_table_[group_index][time];
+            if ( !event.IsActive() )
+                continue;
+
+            const CSubject* subject = event.GetSubject();
+            if ( !seen.insert(subject).second )
+                continue;
+
+            for (const auto& teacher : event.GetTeachers())
+                conflicts += teachers_use[teacher->GetIndex()]++ > 0;
+            for (const auto& cabinet : event.GetCabinets())
+                conflicts += cabinets_use[cabinet->GetIndex()]++ > 0;
+            // Событие стоит у всех своих групп; иначе его место у группы заняла другая запись
+            for (const auto& group : subject->GetGroups())
+                conflicts += time_table_[group->GetIndex()][time].GetSubject() != subject;
+        }
+    }
+
+    return conflicts;
+}
+
+const CConflictGraph& CTimeTable::GetConflictGraph() const {
+    return *problem_->conflict_graph_;
+}
+
+const COccupancy& CTimeTable::GetOccupancy() const {
+    return occupancy_;
+}
+
+size_t CTimeTable::GetTimeSlotsNumber() const {
+    return days_in_week_ * lessons_in_day_;
 }
 
 const CEvent& CTimeTable::GetEvent(std::string group_name, size_t start_time) const {
-    return time_table_.at(group_name)[start_time];
+    return time_table_[ problem_->groups_.at(group_name).GetIndex() ][start_time];
 }
 
 //______________________________________________________________________________________________________________________
@@ -568,6 +977,7 @@ const CEvent& CTimeTable::GetEvent(std::string group_name, size_t start_time) co
 //______________________________________________________________________________________________________________________
 
 void CTimeTable::GroupsScheduleTex(std::string filename) const {
+    TRACE_SCOPE("GroupsScheduleTex");
     std::ofstream file(filename);
 
     if ( !file.is_open() ) {
@@ -583,11 +993,11 @@ void CTimeTable::GroupsScheduleTex(std::string filename) const {
             "\\begin{center}\n"
             "\\tiny\n";
 
-    for (auto & group : time_table_) {
+    for (auto & [group_name, group] : problem_->groups_) {
         file << "\\begin{tabular}{ | c |  } \\hline \n";
-        file << group.first << " \\\\ \\hline \n";
+        file << group_name << " \\\\ \\hline \n";
 
-        auto& lessons = group.second;
+        auto& lessons = time_table_[group.GetIndex()];
         for (int lesson = 0; lesson < lessons_in_day_; lesson++) {
             file <<  "\\begin{tabular}{ *{" << days_in_week_<<"}{| p {90pt} |} } \n";
             for (int day = 0; day < days_in_week_; day++) {
@@ -625,6 +1035,7 @@ void CTimeTable::GroupsScheduleTex(std::string filename) const {
 }
 
 void CTimeTable::TeachersScheduleTex(std::string filename) const {
+    TRACE_SCOPE("TeachersScheduleTex");
     std::ofstream file(filename);
 
     if ( !file.is_open() ) {
@@ -640,7 +1051,7 @@ void CTimeTable::TeachersScheduleTex(std::string filename) const {
             "\\begin{center}\n"
             "\\tiny\n";
 
-    for (auto [teacher_name, teacher] : teachers_) {
+    for (const auto& [teacher_name, teacher] : problem_->teachers_) {
 
         file << "\\begin{tabular}{ | c |  } \\hline \n";
         file << teacher_name << " \\\\ \\hline \n";
@@ -649,7 +1060,7 @@ void CTimeTable::TeachersScheduleTex(std::string filename) const {
             file << "\\begin{tabular}{ *{" << days_in_week_ << "}{| p {90pt} |} } \n";
             for (int day = 0; day < days_in_week_; day++) {
                 file << "\\begin{tabular}{  c   } \n";
-                for (auto & [group_name, lessons] : time_table_) {
+                for (auto & lessons : time_table_) {
                     if (!lessons[day * lessons_in_day_ + lesson].IsActive()) {
                         file << "\\\\ \n";
                     } else if ( lessons[day * lessons_in_day_ + lesson].GetTeachers().end() !=
@@ -677,39 +1088,185 @@ void CTimeTable::TeachersScheduleTex(std::string filename) const {
 }
 
 //______________________________________________________________________________________________________________________
-// ЧТЕНИЕ  ИЗ  ФАЙЛОВ
+// КОНТРОЛЬНЫЕ  ТОЧКИ
 //______________________________________________________________________________________________________________________
 
-// Вспомогательная функция добавляющая универсальности при чтении различных типов данных из файла
-// На вход : имя файла для чтения, указатель на CTimeTableBuilder в который происходит запись,
-// указатель на функцию парсинга строки, принимающую на вход rvalue ссылку на std::stringstream
-// и тот же указатель на CTimeTableBuilder.
-// Указатель на CTimeTableBuilder нужен для того, чтобы связывать предметы с группами и преподавателями при
-// чтении файла предметов, так как предполагается, что в качестве указателя на функцию будет передаваться
-// лямбда-функция. Если не прокинуть в лямбда-функцию укзатель на CTimeTableBuilder, то в ней не будет доступа к
-// полям уже заполненным полям CTimeTableBuilder, т.е. teachers_ и тд. Но по действующим стандартам лямбда-функция,
-// в которую прокидываются значения не может выступать в роли указателя на функцию. Поэтому передаем this как обычный
-// параметр.
-template <typename T>
-std::map<std::string, T> ReadMapFromFile( const std::string& filename,
-                                          CTimeTableBuilder* ptr,
-                                          T (*parse_func) (std::stringstream&& , CTimeTableBuilder* ) ) {
-    std::ifstream file(filename);
-
-    if ( !file.is_open() )
-        throw std::exception();
+// Формат: отпечаток задачи ( CProblemInstance::GetFingerprint, для проверки, что задача та же ), количество событий,
+// затем для каждого события номер предмета, время начала, количество кабинетов и их номера. Событие нескольких групп
+// записывается один раз.
+void CTimeTable::Save(std::ostream& stream) const {
+    TRACE_SCOPE("Save timetable");
+    WriteBinary<uint64_t>(stream, problem_->GetFingerprint());
+
+    std::vector<const CEvent*> events;
+    for (const auto& [group_name, group] : problem_->groups_) {
+        const auto& lessons = time_table_[group.GetIndex()];
+        for (size_t time = 0; time < lessons.size(); time++) {
+            const CEvent& event = lessons[time];
+            if ( event.IsActive() && event.GetStartTime() == time &&
+                 *event.GetSubject()->GetGroups().begin() == &group )
+                events.push_back(&event);
+        }
+    }
+
+    WriteBinary<uint32_t>(stream, events.size());
+    for (const auto& event : events) {
+        WriteBinary<uint32_t>(stream, event->GetSubject()->GetIndex());
+        WriteBinary<uint32_t>(stream, event->GetStartTime());
+        WriteBinary<uint32_t>(stream, event->GetCabinets().size());
+        for (const auto& cabinet : event->GetCabinets())
+            WriteBinary<uint32_t>(stream, cabinet->GetIndex());
+    }
+}
 
-    std::string line;
+void CTimeTable::Load(std::istream& stream) {
+    TRACE_SCOPE("Load timetable");
+    uint64_t fingerprint = ReadBinary<uint64_t>(stream);
+    if ( !stream )
+        throw CBadCheckpoint("Checkpoint is truncated");
+    if ( fingerprint != problem_->GetFingerprint() )
+        throw CBadCheckpoint("Checkpoint was written for another problem");
+
+    // Номер -> объект; номера плотные ( см. IndexByName )
+    size_t subjects_number = problem_->subjects_.size();
+    size_t cabinets_number = problem_->cabinets_.size();
+    std::vector<const CSubject*> subjects(subjects_number);
+    for (const auto& [subject_name, subject] : problem_->subjects_)
+        subjects[subject.GetIndex()] = &subject;
+    std::vector<const CCabinet*> cabinets(cabinets_number);
+    for (const auto& [cabinet_name, cabinet] : problem_->cabinets_)
+        cabinets[cabinet.GetIndex()] = &cabinet;
+
+    RecoverTimeTable();
+
+    // При ошибке расписание остается пустым, а не частично прочитанным
+    auto fail = [this] (const std::string& msg) {
+        RecoverTimeTable();
+        throw CBadCheckpoint(msg);
+    };
+
+    std::vector<bool> loaded(subjects_number, false);
+    uint32_t events_number = ReadBinary<uint32_t>(stream);
+    for (uint32_t i = 0; i < events_number && stream; i++) {
+        uint32_t subject_index = ReadBinary<uint32_t>(stream);
+        uint32_t start_time = ReadBinary<uint32_t>(stream);
+        uint32_t event_cabinets_number = ReadBinary<uint32_t>(stream);
+        if ( !stream )
+            break;
+        if ( subject_index >= subjects_number || event_cabinets_number > cabinets_number )
+            fail("Checkpoint event is invalid");
+
+        const CSubject* subject = subjects[subject_index];
+        if ( loaded[subject_index] )
+            fail("Checkpoint has two events of " + subject->GetName());
+        loaded[subject_index] = true;
+
+        CCabinetSet event_cabinets;
+        for (uint32_t j = 0; j < event_cabinets_number; j++) {
+            uint32_t cabinet_index = ReadBinary<uint32_t>(stream);
+            if ( !stream || cabinet_index >= cabinets_number )
+                fail("Checkpoint event of " + subject->GetName() + " is invalid");
+            // Кабинет должен подходить предмету
+            if ( !subject->GetCabinets().count(cabinets[cabinet_index]) )
+                fail("Checkpoint event of " + subject->GetName() + " is invalid");
+            event_cabinets.insert(cabinets[cabinet_index]);
+        }
+        if ( event_cabinets.size() != subject->GetRequiredCabinetsNumber() )
+            fail("Checkpoint event of " + subject->GetName() + " is invalid");
+
+        // Событие должно помещаться в неделю и не накладываться на уже прочитанные: ни по группам, ни по учителям,
+        // ни по кабинетам. Иначе insertEvent займет уже занятое время, и его освобождение испортит занятость.
+        if ( start_time + subject->GetDuration() > GetTimeSlotsNumber() )
+            fail("Checkpoint event of " + subject->GetName() + " is invalid");
+        for (const auto& group : subject->GetGroups())
+            for (size_t time = start_time; time < start_time + subject->GetDuration(); time++)
+                if ( time_table_[group->GetIndex()][time].IsActive() )
+                    fail("Checkpoint event of " + subject->GetName() + " is invalid");
+        if ( !(occupancy_.GetSubjectAvailableStartTime(subject, days_in_week_, lessons_in_day_) &
+              (static_cast<int64_t>(1) << start_time)) )
+            fail("Checkpoint event of " + subject->GetName() + " overlaps a teacher's or a group's lesson");
+        for (const auto& cabinet : event_cabinets)
+            if ( !occupancy_.IsCabinetFeasible(cabinet, start_time, subject->GetDuration()) )
+                fail("Checkpoint event of " + subject->GetName() + " overlaps a lesson in " + cabinet->GetName());
+
+        insertEvent(subject, event_cabinets, start_time);
+    }
+
+    if ( !stream )
+        fail("Checkpoint is truncated");
+
+    // Расписание должно быть полным: каждый предмет ровно один раз
+    for (size_t index = 0; index < subjects_number; index++)
+        if ( !loaded[index] )
+            fail("Checkpoint has no event of " + subjects[index]->GetName());
+}
+
+//______________________________________________________________________________________________________________________
+// ЧТЕНИЕ  ИЗ  ФАЙЛОВ
+//______________________________________________________________________________________________________________________
+
+// Вспомогательная функция, читающая файл filename в map по имени. parse_func разбирает одну запись ( строку файла )
+// через CInputTokenizer и возвращает объект; после него в строке не должно остаться слов. Запись с уже встречавшимся
+// именем передается в merge_func( первая запись, повторная, tokenizer ) и в map не попадает.
+template <typename T, typename Parse, typename Merge>
+std::map<std::string, T> ReadMapFromFile( const std::string& filename, Parse parse_func, Merge merge_func ) {
+    CInputTokenizer tokenizer(filename);
     std::map<std::string, T> output;
 
-    while(std::getline(file, line)) {
-        T obj = parse_func( std::stringstream(line), ptr );
-        output.insert( { obj.GetName(), obj } );
+    while ( tokenizer.NextRecord() ) {
+        T obj = parse_func(tokenizer);
+        tokenizer.ExpectEndOfLine();
+
+        std::string name = obj.GetName();
+        auto first = output.find(name);
+        if ( first == output.end() )
+            output.emplace( name, std::move(obj) );
+        else
+            merge_func(first->second, obj, tokenizer);
     }
 
-    file.close();
+    return output;
+}
+
+// merge_func для ReadMapFromFile: повторная запись, как и раньше, пропускается, но с предупреждением в warnings
+// ( entity_name -- название сущности для него )
+auto SkipDuplicate(const char* entity_name, std::vector<std::string>& warnings) {
+    return [entity_name, &warnings] (const auto&, const auto& repeated, const CInputTokenizer& tokenizer) {
+        warnings.push_back( tokenizer.RecordError( std::string("duplicate ") + entity_name + " '" +
+                                                   repeated.GetName() + "' is ignored" ).GetMessage() );
+    };
+}
+
+// Предметы с одинаковым ключом -- копии одного урока ( см. CTimeTableBuilder::assignLessons )
+using LessonKey = std::tuple< size_t, size_t, size_t, size_t, int64_t,
+                              std::vector<std::string>, std::vector<std::string>, std::vector<std::string> >;
+
+LessonKey GetLessonKey(const CSubject& subject) {
+    LessonKey key { subject.GetId(), subject.GetDifficultyRating(), subject.GetDuration(),
+                    subject.GetRequiredCabinetsNumber(), subject.GetFeasibleTime(), {}, {}, {} };
+    for (const auto& teacher : subject.GetTeachers())
+        std::get<5>(key).push_back(teacher->GetName());
+    for (const auto& group : subject.GetGroups())
+        std::get<6>(key).push_back(group->GetName());
+    for (const auto& cabinet : subject.GetCabinets())
+        std::get<7>(key).push_back(cabinet->GetName());
+    return key;
+}
 
-    return std::move(output);
+// Прочитать количество и столько имен, найти каждое в entities. Неизвестное имя -- ошибка в его позиции.
+template <class Set, class T>
+Set ReadReferences( CInputTokenizer& tokenizer, std::map<std::string, T>& entities,
+                    const char* number_name, const char* entity_name ) {
+    Set result;
+    size_t number = tokenizer.ReadNumber(number_name);
+    for (size_t i = 0; i < number; i++) {
+        const std::string& name = tokenizer.ReadName(entity_name);
+        auto entity = entities.find(name);
+        if ( entity == entities.end() )
+            throw tokenizer.Error( std::string("unknown ") + entity_name + " '" + name + "'" );
+        result.insert( &entity->second );
+    }
+    return result;
 }
 
 //______________________________________________________________________________________________________________________
@@ -725,163 +1282,715 @@ std::map<std::string, T> ReadMapFromFile( const std::string& filename,
 //______________________________________________________________________________________________________________________
 
 void CTimeTableBuilder::SetTimeTableTeachers(std::string teachers_filename) {
+    analysed_ = false;
 
-    teachers_ = ReadMapFromFile<CTeacher>( teachers_filename, this,
-                                           [] (std::stringstream&& line, CTimeTableBuilder* ptr) {
-        std::string name;
-        int64_t avaliable_time;
-        std::vector<size_t> time_rating;
+    teachers_ = ReadMapFromFile<CTeacher>( teachers_filename, [] (CInputTokenizer& line) {
+        std::string name = line.ReadName("teacher name");
+        size_t time_slots_number;
+        int64_t available_time = line.ReadMask("available time", &time_slots_number);
 
-        // TEMPORARY TODO
-        std::string time;
+        // Оценка каждого времени, в том же порядке, что и маска
+        std::vector<size_t> time_rating(time_slots_number);
+        for (int i = time_rating.size()-1; i > -1; i--)
+            time_rating[i] = line.ReadNumber("time rating");
 
-        line >> name;
-        line >> time;
+        return CTeacher{ name, available_time, time_rating };
+    }, SkipDuplicate("teacher", warnings_) );
+    IndexByName(teachers_);
 
-        time_rating.resize(time.length());
-        for (int i = time_rating.size()-1; i > -1; i--) {
-            line >> time_rating[i];
-        }
+}
+
+void CTimeTableBuilder::SetTimeTableGroups(std::string groups_filename) {
+    analysed_ = false;
 
-        avaliable_time = Str2Int64(time);
+    groups_ = ReadMapFromFile<CGroup>( groups_filename, [] (CInputTokenizer& line) {
+        std::string name = line.ReadName("group name");
+        size_t students_number = line.ReadNumber("students number");
+        int64_t available_time = line.ReadMask("available time");
 
-        return CTeacher{ name, avaliable_time, time_rating };
-    } );
+        return CGroup{ name, students_number, available_time };
+    }, SkipDuplicate("group", warnings_) );
+    IndexByName(groups_);
 
 }
 
-void CTimeTableBuilder::SetTimeTableGroups(std::string groups_filename) {
+void CTimeTableBuilder::SetTimeTableCabinets(std::string cabinets_filename) {
+    analysed_ = false;
+
+    cabinets_ = ReadMapFromFile<CCabinet>( cabinets_filename, [] (CInputTokenizer& line) {
+        std::string name = line.ReadName("cabinet name");
+        size_t capacity = line.ReadNumber("capacity");
+        int64_t available_time = line.ReadMask("available time");
 
-    groups_ = ReadMapFromFile<CGroup>( groups_filename, this,
-                                       [] (std::stringstream&& line, CTimeTableBuilder* ptr) {
+        return CCabinet{ name, capacity, available_time };
+    }, SkipDuplicate("cabinet", warnings_) );
+    IndexByName(cabinets_);
 
-        std::string name;
-        size_t students_number;
-        int64_t avaliable_time;
+}
 
-        // TEMPORARY TODO
-        std::string time;
+void CTimeTableBuilder::SetTimeTableSubjects(std::string subjects_filename) {
+    analysed_ = false;
 
-        line >> name;
-        line >> students_number;
-        line >> time;
+    lessons_per_week_.clear();
+    subjects_ = ReadMapFromFile<CSubject>( subjects_filename, [this] (CInputTokenizer& line) {
+        CSubjectBuilder subject_builder;
 
-        avaliable_time = Str2Int64(time);
+        std::string name = line.ReadName("subject name");
+        subject_builder.SetSubjectName(name);
+        subject_builder.SetSubjectId( line.ReadNumber("subject id") );
+        subject_builder.SetSubjectDifficultyRating( line.ReadNumber("difficulty rating") );
+        subject_builder.SetSubjectDuration( line.ReadNumber("duration") );
+        subject_builder.SetRequiredCabinetNumber( line.ReadNumber("required cabinets number") );
+        subject_builder.SetFeasibleTime( line.ReadMask("feasible time") );
+
+        subject_builder.SetSubjectTeachers( ReadReferences< std::set<const CTeacher *const, Comparator<CTeacher>> >(
+                line, teachers_, "teachers number", "teacher" ) );
+        subject_builder.SetSubjectGroups( ReadReferences< std::set<const CGroup *const, Comparator<CGroup>> >(
+                line, groups_, "groups number", "group" ) );
+        subject_builder.SetSubjectCabinets( ReadReferences<CCabinetSet>(
+                line, cabinets_, "cabinets number", "cabinet" ) );
+
+        // Необязательное последнее поле -- количество таких уроков в неделю
+        size_t lessons_per_week;
+        if ( !line.TryReadNumber("lessons per week", lessons_per_week) || lessons_per_week == 0 )
+            lessons_per_week = 1;
+        // Одинаковые строки -- это тоже уроки в неделю ( см. повторную запись ниже )
+        lessons_per_week_[name] += lessons_per_week;
 
-        return CGroup{ name, students_number, avaliable_time };
+        return subject_builder.Build();
+    }, [] (const CSubject& first, const CSubject& repeated, const CInputTokenizer& line) {
+        // Повторная строка того же урока добавляет ему уроков в неделю; другой урок под тем же именем -- ошибка,
+        // иначе одна из строк молча потеряется
+        if ( GetLessonKey(first) != GetLessonKey(repeated) )
+            throw line.RecordError( "subject '" + repeated.GetName() + "' is repeated with different fields; " +
+                                    "give different lessons different names" );
     } );
 
+    expandLessons(subjects_filename);
+    assignLessons();
 }
 
-void CTimeTableBuilder::SetTimeTableCabinets(std::string cabinets_filename) {
-
-    cabinets_ = ReadMapFromFile<CCabinet>( cabinets_filename, this,
-                                           [] (std::stringstream&& line, CTimeTableBuilder* ptr) {
-        std::string name;
-        size_t capacity;
-        int64_t avaliable_time;
+void CTimeTableBuilder::expandLessons(const std::string& subjects_filename) {
+    // Урок, который проводится k > 1 раз в неделю, превращается в k копий с именами name-1, ..., name-k
+    std::map< std::string, CSubject > expanded_subjects;
 
-        // TEMPORARY TODO
-        std::string time;
+    for (const auto& [name, subject] : subjects_) {
+        size_t lessons_per_week = lessons_per_week_.at(name);
 
-        line >> name;
-        line >> capacity;
-        line >> time;
+        for (size_t copy = 0; copy < lessons_per_week; copy++) {
+            CSubjectBuilder subject_builder;
+            subject_builder.SetFromSubject(subject);
+            subject_builder.SetSubjectName( lessons_per_week == 1 ? name : name + "-" + std::to_string(copy + 1) );
 
-        avaliable_time = Str2Int64(time);
-
-        return CCabinet{ name, capacity, avaliable_time };
-    } );
+            CSubject copy_subject = subject_builder.Build();
+            // Имя копии может совпасть с именем другой строки файла ( Физика с 2 уроками и отдельная Физика-1 )
+            if ( !expanded_subjects.insert( { copy_subject.GetName(), copy_subject } ).second )
+                throw CParseError( subjects_filename, 0, 0, "lesson name '" + copy_subject.GetName() +
+                                   "' is used by two subjects" );
+        }
+    }
 
+    subjects_ = std::move(expanded_subjects);
+    lessons_per_week_.clear();
 }
 
-void CTimeTableBuilder::SetTimeTableSubjects(std::string subjects_filename) {
+void CTimeTableBuilder::assignLessons() {
+    // Одинаковые предметы ( в том числе записанные в файле отдельными строками, как Физика-11А-1, Физика-11А-2 )
+    // объединяются в один урок, копии нумеруются в порядке имен.
+    std::map< LessonKey, std::pair<size_t, size_t> > lessons;  // ключ -> ( номер урока, количество копий )
+    std::map< std::string, CSubject > assigned_subjects;
 
-    subjects_ = ReadMapFromFile<CSubject>( subjects_filename, this,
-                                           [] (std::stringstream&& line, CTimeTableBuilder* ptr) {
-
-        std::string name;
-        size_t id;
-        size_t difficulty_rating;
-        size_t duration;
-        size_t required_cabinets_number;
-        std::set<CTeacher *const, Comparator<CTeacher>> teachers;
-        std::set<CGroup *const, Comparator<CGroup>> groups;
-        std::set<CCabinet *const, Comparator<CCabinet>> cabinets;
-
-        // TEMPORARY TODO
-        std::string time;
-
-        line >> name;
-        line >> id;
-        line >> difficulty_rating;
-        line >> duration;
-        line >> required_cabinets_number;
-        line >> time;
-
-        int teachers_number;
-        line >> teachers_number;
-
-        std::string teacher_name;
-        for (int i = 0; i < teachers_number; i++) {
-            line >> teacher_name;
-            if (ptr->teachers_.find(teacher_name) == ptr->teachers_.end())
-                throw CException("Teacher is not found " + teacher_name + " in subject " + name);
-            teachers.insert(& (ptr->teachers_.at(teacher_name)) );
-        }
-
-        int groups_number;
-        line >> groups_number;
-        std::string group_name;
-        for (int i = 0; i < groups_number; i++) {
-            line >> group_name;
-            if (ptr->groups_.find(group_name) == ptr->groups_.end())
-                throw CException("Group is not found " + group_name + " in subject " + name);
-            groups.insert(& (ptr->groups_.at(group_name)) );
-        }
-
-        int cabinets_number;
-        line >> cabinets_number;
-        std::string cabinet_name;
-        for (int i = 0; i < cabinets_number; i++) {
-            line >> cabinet_name;
-            if (ptr->cabinets_.find(cabinet_name) == ptr->cabinets_.end())
-                throw CException("Cabinet is not found " + name);
-            cabinets.insert(& (ptr->cabinets_.at(cabinet_name)) );
-        }
+    for (const auto& [name, subject] : subjects_) {
+        LessonKey key = GetLessonKey(subject);
+        auto lesson = lessons.find(key);
+        if ( lesson == lessons.end() )
+            lesson = lessons.insert( { key, { lessons.size(), 0 } } ).first;
 
         CSubjectBuilder subject_builder;
-
+        subject_builder.SetFromSubject(subject);
         subject_builder.SetSubjectName(name);
-        subject_builder.SetSubjectId(id);
-        subject_builder.SetSubjectDifficultyRating(difficulty_rating);
-        subject_builder.SetSubjectDuration(duration);
-        subject_builder.SetRequiredCabinetNumber(required_cabinets_number);
-        subject_builder.SetFeasibleTime(Str2Int64(time));
-        subject_builder.SetSubjectTeachers(teachers);
-        subject_builder.SetSubjectGroups(groups);
-        subject_builder.SetSubjectCabinets(cabinets);
+        subject_builder.SetSubjectLesson(lesson->second.first, lesson->second.second++);
 
-        return subject_builder.Build();
-    } );
+        assigned_subjects.insert( { name, subject_builder.Build() } );
+    }
+
+    subjects_ = std::move(assigned_subjects);
+}
 
+const std::vector<std::string>& CTimeTableBuilder::GetWarnings() const {
+    return warnings_;
+}
+
+size_t CTimeTableBuilder::GetSubjectsNumber() const {
+    return subjects_.size();
 }
 
 void CTimeTableBuilder::SetTimeTableSize(size_t days_in_week, size_t lessons_in_day) {
+    analysed_ = false;
     days_in_week_ = days_in_week;
     lessons_in_day_ = lessons_in_day;
 }
 
+//______________________________________________________________________________________________________________________
+// ДВОИЧНЫЙ  ФАЙЛ  ЗАДАЧИ
+//______________________________________________________________________________________________________________________
+
+// Заголовок файла задачи и версия формата
+const char INSTANCE_MAGIC[8] = {'T', 'I', 'M', 'E', 'R', 'I', 'N', 'S'};
+const uint32_t INSTANCE_VERSION = 1;
+
+// Формат: заголовок и версия, размер недели, затем учителя, группы, кабинеты и предметы -- каждый список с
+// количеством и в порядке имен, так что позиция в списке и есть плотный номер ( см. IndexByName ). Строки --
+// длина и байты ( WriteBinaryString ). Предмет ссылается на учителей, группы и кабинеты их номерами.
+void CTimeTableBuilder::CompileInstance(const std::string& instance_filename) const {
+    std::ofstream file(instance_filename, std::ios::binary | std::ios::trunc);
+
+    file.write(INSTANCE_MAGIC, sizeof(INSTANCE_MAGIC));
+    WriteBinary<uint32_t>(file, INSTANCE_VERSION);
+    WriteBinary<uint32_t>(file, days_in_week_);
+    WriteBinary<uint32_t>(file, lessons_in_day_);
+
+    WriteBinary<uint32_t>(file, teachers_.size());
+    for (const auto& [name, teacher] : teachers_) {
+        WriteBinaryString(file, name);
+        WriteBinary<int64_t>(file, teacher.GetAvailableTime());
+        WriteBinary<uint32_t>(file, teacher.GetTimeRating().size());
+        for (size_t rating : teacher.GetTimeRating())
+            WriteBinary<uint64_t>(file, rating);
+    }
+
+    WriteBinary<uint32_t>(file, groups_.size());
+    for (const auto& [name, group] : groups_) {
+        WriteBinaryString(file, name);
+        WriteBinary<uint64_t>(file, group.GetStudentsNumber());
+        WriteBinary<int64_t>(file, group.GetAvailableTime());
+    }
+
+    WriteBinary<uint32_t>(file, cabinets_.size());
+    for (const auto& [name, cabinet] : cabinets_) {
+        WriteBinaryString(file, name);
+        WriteBinary<uint64_t>(file, cabinet.GetCapacity());
+        WriteBinary<int64_t>(file, cabinet.GetAvailableTime());
+    }
+
+    WriteBinary<uint32_t>(file, subjects_.size());
+    for (const auto& [name, subject] : subjects_) {
+        WriteBinaryString(file, name);
+        WriteBinary<uint64_t>(file, subject.GetId());
+        WriteBinary<uint64_t>(file, subject.GetLesson());
+        WriteBinary<uint64_t>(file, subject.GetCopyIndex());
+        WriteBinary<uint64_t>(file, subject.GetDifficultyRating());
+        WriteBinary<uint64_t>(file, subject.GetDuration());
+        WriteBinary<uint64_t>(file, subject.GetRequiredCabinetsNumber());
+        WriteBinary<int64_t>(file, subject.GetFeasibleTime());
+        WriteBinary<int64_t>(file, subject.GetStartDomain());
+
+        WriteBinary<uint32_t>(file, subject.GetTeachers().size());
+        for (const auto& teacher : subject.GetTeachers())
+            WriteBinary<uint32_t>(file, teacher->GetIndex());
+        WriteBinary<uint32_t>(file, subject.GetGroups().size());
+        for (const auto& group : subject.GetGroups())
+            WriteBinary<uint32_t>(file, group->GetIndex());
+        WriteBinary<uint32_t>(file, subject.GetCabinets().size());
+        for (const auto& cabinet : subject.GetCabinets())
+            WriteBinary<uint32_t>(file, cabinet->GetIndex());
+    }
+
+    file.close();
+    if ( !file )
+        throw CException("Cannot write " + instance_filename);
+}
+
+// Прочитать count сущностей функцией read_entity, которая возвращает пару ( имя, объект ), в map. Имена должны идти
+// строго по возрастанию -- тогда номер в файле совпадает с номером IndexByName. Возвращает указатели по номерам.
+// Сами номера, как и при чтении текста, присваивает IndexByName.
+template <class T, class ReadEntity>
+std::vector<const T*> ReadInstanceEntities( CMemoryReader& reader, std::map<std::string, T>& entities,
+                                            ReadEntity read_entity ) {
+    entities.clear();
+    uint32_t count = reader.Read<uint32_t>();
+    for (uint32_t i = 0; i < count && reader.IsValid(); i++) {
+        auto [name, entity] = read_entity();
+        if ( !reader.IsValid() )
+            break;
+        if ( !entities.empty() && !(entities.rbegin()->first < name) )
+            throw CBadInstance("Instance names are not sorted near " + name);
+        entities.emplace_hint( entities.end(), name, entity );
+    }
+    if ( !reader.IsValid() )
+        throw CBadInstance("Instance file is truncated");
+
+    std::vector<const T*> by_index;
+    by_index.reserve(entities.size());
+    for (const auto& [name, entity] : entities)
+        by_index.push_back(&entity);
+    return by_index;
+}
+
+// Прочитать список номеров и собрать множество указателей. Выкидывает CBadInstance при номере вне диапазона.
+template <class Set, class T>
+Set ReadInstanceReferences( CMemoryReader& reader, const std::vector<const T*>& by_index ) {
+    Set result;
+    uint32_t count = reader.Read<uint32_t>();
+    for (uint32_t i = 0; i < count && reader.IsValid(); i++) {
+        uint32_t index = reader.Read<uint32_t>();
+        if ( reader.IsValid() && index >= by_index.size() )
+            throw CBadInstance("Instance reference is out of range");
+        if ( reader.IsValid() )
+            result.insert(by_index[index]);
+    }
+    return result;
+}
+
+void CTimeTableBuilder::SetTimeTableInstance(const std::string& instance_filename) {
+    analysed_ = false;
+    CMappedFile file(instance_filename);
+    CMemoryReader reader(file.GetData(), file.GetSize());
+
+    if ( !reader.Expect(INSTANCE_MAGIC, sizeof(INSTANCE_MAGIC)) )
+        throw CBadInstance(instance_filename + " is not a compiled instance");
+    if ( reader.Read<uint32_t>() != INSTANCE_VERSION )
+        throw CBadInstance(instance_filename + " has unsupported instance version");
+    days_in_week_ = reader.Read<uint32_t>();
+    lessons_in_day_ = reader.Read<uint32_t>();
+    // Время недели хранится битами int64_t без знакового бита, так что уроков в неделе от 1 до 63
+    if ( !reader.IsValid() )
+        throw CBadInstance("Instance file is truncated");
+    if ( days_in_week_ * lessons_in_day_ == 0 || days_in_week_ * lessons_in_day_ >= INT64_SIZE )
+        throw CBadInstance( instance_filename + " has invalid week size " + std::to_string(days_in_week_) + "x" +
+                            std::to_string(lessons_in_day_) );
+
+    auto teachers = ReadInstanceEntities(reader, teachers_, [&reader] () {
+        std::string name = reader.ReadString();
+        int64_t available_time = reader.Read<int64_t>();
+        std::vector<size_t> time_rating;
+        uint32_t ratings_number = reader.Read<uint32_t>();
+        for (uint32_t i = 0; i < ratings_number && reader.IsValid(); i++)
+            time_rating.push_back( reader.Read<uint64_t>() );
+        return std::make_pair( name, CTeacher{ name, available_time, time_rating } );
+    } );
+    IndexByName(teachers_);
+
+    auto groups = ReadInstanceEntities(reader, groups_, [&reader] () {
+        std::string name = reader.ReadString();
+        size_t students_number = reader.Read<uint64_t>();
+        int64_t available_time = reader.Read<int64_t>();
+        return std::make_pair( name, CGroup{ name, students_number, available_time } );
+    } );
+    IndexByName(groups_);
+
+    auto cabinets = ReadInstanceEntities(reader, cabinets_, [&reader] () {
+        std::string name = reader.ReadString();
+        size_t capacity = reader.Read<uint64_t>();
+        int64_t available_time = reader.Read<int64_t>();
+        return std::make_pair( name, CCabinet{ name, capacity, available_time } );
+    } );
+    IndexByName(cabinets_);
+
+    ReadInstanceEntities(reader, subjects_, [&] () {
+        CSubjectBuilder subject_builder;
+        std::string name = reader.ReadString();
+        subject_builder.SetSubjectName(name);
+        subject_builder.SetSubjectId( reader.Read<uint64_t>() );
+        size_t lesson = reader.Read<uint64_t>();
+        subject_builder.SetSubjectLesson( lesson, reader.Read<uint64_t>() );
+        subject_builder.SetSubjectDifficultyRating( reader.Read<uint64_t>() );
+        subject_builder.SetSubjectDuration( reader.Read<uint64_t>() );
+        subject_builder.SetRequiredCabinetNumber( reader.Read<uint64_t>() );
+        subject_builder.SetFeasibleTime( reader.Read<int64_t>() );
+        subject_builder.SetStartDomain( reader.Read<int64_t>() );
+        subject_builder.SetSubjectTeachers(
+                ReadInstanceReferences< std::set<const CTeacher *const, Comparator<CTeacher>> >(reader, teachers) );
+        subject_builder.SetSubjectGroups(
+                ReadInstanceReferences< std::set<const CGroup *const, Comparator<CGroup>> >(reader, groups) );
+        subject_builder.SetSubjectCabinets( ReadInstanceReferences<CCabinetSet>(reader, cabinets) );
+        CSubject subject = subject_builder.Build();
+
+        // Генератор и операторы считают, что урок помещается в день, у него есть группы и хватает кабинетов
+        if ( reader.IsValid() ) {
+            if ( subject.GetDuration() == 0 || subject.GetDuration() > lessons_in_day_ )
+                throw CBadInstance("Subject " + name + " has invalid duration " +
+                                   std::to_string( subject.GetDuration() ));
+            if ( subject.GetGroups().empty() )
+                throw CBadInstance("Subject " + name + " has no groups");
+            if ( subject.GetRequiredCabinetsNumber() > subject.GetCabinets().size() )
+                throw CBadInstance("Subject " + name + " requires " +
+                                   std::to_string( subject.GetRequiredCabinetsNumber() ) + " cabinets but lists " +
+                                   std::to_string( subject.GetCabinets().size() ));
+        }
+        return std::make_pair( name, subject );
+    } );
+
+    if ( !reader.IsAtEnd() )
+        throw CBadInstance(instance_filename + " has trailing data");
+    lessons_per_week_.clear();
+}
+
+//______________________________________________________________________________________________________________________
+// ПРОВЕРКА  ВЫПОЛНИМОСТИ
+//______________________________________________________________________________________________________________________
+
+void CTimeTableBuilder::CheckFeasibility() const {
+    const size_t time_slots_number = days_in_week_ * lessons_in_day_;
+    const int64_t week_mask = time_slots_number >= INT64_SIZE ? ~static_cast<int64_t>(0)
+                                                              : (static_cast<int64_t>(1) << time_slots_number) - 1;
+    std::vector<std::string> violations;
+
+    // Часы учителей и групп не могут превышать их свободное время
+    std::map<std::string, size_t> teachers_hours, groups_hours;
+    for (const auto& [name, subject] : subjects_) {
+        for (const auto& teacher : subject.GetTeachers())
+            teachers_hours[teacher->GetName()] += subject.GetDuration();
+        for (const auto& group : subject.GetGroups())
+            groups_hours[group->GetName()] += subject.GetDuration();
+    }
+    for (const auto& [name, hours] : teachers_hours) {
+        size_t available = BitsNumber(teachers_.at(name).GetAvailableTime() & week_mask);
+        if (hours > available)
+            violations.push_back( "Teacher " + name + " has " + std::to_string(hours) + " lessons but only " +
+                                  std::to_string(available) + " available slots" );
+    }
+    for (const auto& [name, hours] : groups_hours) {
+        size_t available = BitsNumber(groups_.at(name).GetAvailableTime() & week_mask);
+        if (hours > available)
+            violations.push_back( "Group " + name + " has " + std::to_string(hours) + " lessons but only " +
+                                  std::to_string(available) + " available slots" );
+    }
+
+    // Каждому предмету нужно время начала и достаточно вместительных кабинетов.
+    // Заодно строим двудольный граф: слева -- часы кабинетов, нужные предметам, справа -- ( кабинет, время ).
+    std::map<std::string, size_t> cabinet_numbers;
+    for (const auto& [name, cabinet] : cabinets_)
+        cabinet_numbers.insert( { name, cabinet_numbers.size() } );
+
+    std::vector< std::vector<size_t> > adjacency;
+    std::vector<const CSubject*> left_subjects;
+
+    for (const auto& [name, subject] : subjects_) {
+        int64_t available_time = subject.GetAvailableTime() & week_mask;
+        if ( subject.GetAvailableStartTime(days_in_week_, lessons_in_day_) == 0 ) {
+            violations.push_back( "Subject " + name + " has no available start time: teachers, groups and "
+                                  "feasible time do not leave " + std::to_string(subject.GetDuration()) +
+                                  " consecutive free slots" );
+            continue;
+        }
+
+        std::vector<size_t> rights;
+        size_t capable_cabinets(0);
+        for (const auto& cabinet : subject.GetCabinets()) {
+            if ( cabinet->GetCapacity() < subject.GetParticipantsNumber() )
+                continue;
+            capable_cabinets++;
+            int64_t cabinet_time = cabinet->GetAvailableTime() & available_time;
+            for (size_t time = 0; time < time_slots_number; time++)
+                if ( (cabinet_time >> time) & 1 )
+                    rights.push_back(cabinet_numbers.at(cabinet->GetName()) * time_slots_number + time);
+        }
+
+        if ( capable_cabinets < subject.GetRequiredCabinetsNumber() ) {
+            violations.push_back( "Subject " + name + " needs " + std::to_string(subject.GetRequiredCabinetsNumber()) +
+                                  " cabinets for " + std::to_string(subject.GetParticipantsNumber()) +
+                                  " students but only " + std::to_string(capable_cabinets) + " are large enough" );
+            continue;
+        }
+
+        for (size_t unit = 0; unit < subject.GetRequiredCabinetsNumber() * subject.GetDuration(); unit++) {
+            adjacency.push_back(rights);
+            left_subjects.push_back(&subject);
+        }
+    }
+
+    // Кабинетов на всех может не хватить, даже если каждому предмету по отдельности хватает
+    std::vector<int> match(cabinets_.size() * time_slots_number, -1);
+    std::set<std::string> unmatched_subjects;
+    for (size_t left = 0; left < adjacency.size(); left++) {
+        std::vector<bool> visited(match.size());
+        if ( !FindAugmentingPath(left, adjacency, match, visited) )
+            unmatched_subjects.insert(left_subjects[left]->GetName());
+    }
+    if ( !unmatched_subjects.empty() ) {
+        std::string names;
+        for (const auto& name : unmatched_subjects)
+            names += " " + name;
+        violations.push_back( "Not enough cabinet time for all subjects, cabinets cannot be assigned to:" + names );
+    }
+
+    if ( violations.empty() )
+        return;
+
+    std::string message("Timetable is infeasible:");
+    for (const auto& violation : violations)
+        message += "\n    " + violation;
+    throw CInfeasibleTimeTable(message);
+}
+
+//______________________________________________________________________________________________________________________
+// РАСПРОСТРАНЕНИЕ  ОГРАНИЧЕНИЙ
+//______________________________________________________________________________________________________________________
+
+void CTimeTableBuilder::PropagateDomains() {
+    const size_t time_slots_number = days_in_week_ * lessons_in_day_;
+
+    std::vector<const CSubject*> subjects;
+    for (auto& [name, subject] : subjects_)
+        subjects.push_back(&subject);
+
+    // Маски кабинетов, занятых зафиксированными предметами
+    std::map<const CCabinet*, int64_t> forced_cabinets_time;
+    // Маски учителей и групп, занятых зафиксированными предметами, и сами зафиксированные предметы
+    std::map<const CTeacher*, int64_t> forced_teachers_time;
+    std::map<const CGroup*, int64_t> forced_groups_time;
+    std::vector<bool> forced(subjects.size(), false);
+
+    std::vector<int64_t> domains(subjects.size());
+    for (size_t i = 0; i < subjects.size(); i++)
+        domains[i] = subjects[i]->GetAvailableStartTime(days_in_week_, lessons_in_day_);
+
+    // Маска времен начала, при которых предмет длительности duration пересекается со временем time
+    auto overlapping_starts = [] (int64_t time, size_t duration) {
+        int64_t starts(0);
+        for (size_t k = 0; k < duration; k++)
+            starts |= static_cast<int64_t>( static_cast<uint64_t>(time) >> k );
+        return starts;
+    };
+
+    bool changed(true);
+    while (changed) {
+        changed = false;
+
+        for (size_t i = 0; i < subjects.size(); i++) {
+            const CSubject* subject = subjects[i];
+            int64_t domain = domains[i];
+
+            // Убираем времена, занятые зафиксированными предметами у учителей и групп ( кроме самого себя )
+            if ( !forced[i] ) {
+                for (const auto& teacher : subject->GetTeachers())
+                    if ( forced_teachers_time.count(teacher) )
+                        domain &= ~overlapping_starts(forced_teachers_time.at(teacher), subject->GetDuration());
+                for (const auto& group : subject->GetGroups())
+                    if ( forced_groups_time.count(group) )
+                        domain &= ~overlapping_starts(forced_groups_time.at(group), subject->GetDuration());
+            }
+
+            // Убираем времена, на которые не найдется нужного количества вместительных свободных кабинетов
+            int64_t duration_mask = (static_cast<int64_t>(1) << subject->GetDuration()) - 1;
+            for (size_t time = 0; time < time_slots_number; time++) {
+                if ( !((domain >> time) & 1) )
+                    continue;
+
+                size_t free_cabinets(0);
+                for (const auto& cabinet : subject->GetCabinets()) {
+                    if ( cabinet->GetCapacity() < subject->GetParticipantsNumber() )
+                        continue;
+                    int64_t cabinet_time = cabinet->GetAvailableTime();
+                    if ( !forced[i] && forced_cabinets_time.count(cabinet) )
+                        cabinet_time &= ~forced_cabinets_time.at(cabinet);
+                    if ( ((cabinet_time >> time) & duration_mask) == duration_mask )
+                        free_cabinets++;
+                }
+
+                if ( free_cabinets < subject->GetRequiredCabinetsNumber() )
+                    domain &= ~(static_cast<int64_t>(1) << time);
+            }
+
+            if ( domain == 0 )
+                throw CInfeasibleTimeTable( "Timetable is infeasible:\n    Subject " + subject->GetName() +
+                                            " has no start time left after fixing subjects with a single start time" );
+
+            if ( domain != domains[i] ) {
+                domains[i] = domain;
+                changed = true;
+            }
+
+            // Единственное время начала -- фиксируем предмет: время становится занятым у всех его участников
+            if ( forced[i] || BitsNumber(domain) != 1 )
+                continue;
+
+            forced[i] = true;
+            changed = true;
+
+            int64_t occupied_time = duration_mask << BitScan(domain);
+            for (const auto& teacher : subject->GetTeachers())
+                forced_teachers_time[teacher] |= occupied_time;
+            for (const auto& group : subject->GetGroups())
+                forced_groups_time[group] |= occupied_time;
+
+            // Кабинеты фиксируются, только если подходящих ровно столько, сколько нужно
+            std::vector<const CCabinet*> capable_cabinets;
+            for (const auto& cabinet : subject->GetCabinets())
+                if ( cabinet->GetCapacity() >= subject->GetParticipantsNumber() )
+                    capable_cabinets.push_back(cabinet);
+            if ( capable_cabinets.size() == subject->GetRequiredCabinetsNumber() )
+                for (const auto& cabinet : capable_cabinets)
+                    forced_cabinets_time[cabinet] |= occupied_time;
+        }
+    }
+
+    // Зафиксированные предметы конфликтуют между собой, если занимают одного участника в одно время
+    for (size_t i = 0; i < subjects.size(); i++)
+        for (size_t j = i + 1; j < subjects.size(); j++) {
+            if ( !forced[i] || !forced[j] )
+                continue;
+            int64_t first_time = ((static_cast<int64_t>(1) << subjects[i]->GetDuration()) - 1) << BitScan(domains[i]);
+            int64_t second_time = ((static_cast<int64_t>(1) << subjects[j]->GetDuration()) - 1) << BitScan(domains[j]);
+            if ( (first_time & second_time) &&
+                 ( Intersects(subjects[i]->GetTeachers(), subjects[j]->GetTeachers()) ||
+                   Intersects(subjects[i]->GetGroups(), subjects[j]->GetGroups()) ) )
+                throw CInfeasibleTimeTable( "Timetable is infeasible:\n    Subjects " + subjects[i]->GetName() +
+                                            " and " + subjects[j]->GetName() +
+                                            " can only start at the same time and share a teacher or a group" );
+        }
+
+    // Записываем суженные множества в предметы
+    std::map< std::string, CSubject > reduced_subjects;
+    for (size_t i = 0; i < subjects.size(); i++) {
+        CSubjectBuilder subject_builder;
+        subject_builder.SetFromSubject(*subjects[i]);
+        subject_builder.SetSubjectName(subjects[i]->GetName());
+        subject_builder.SetSubjectIndex(subjects[i]->GetIndex());
+        subject_builder.SetStartDomain(domains[i]);
+        reduced_subjects.insert( { subjects[i]->GetName(), subject_builder.Build() } );
+    }
+    subjects_ = std::move(reduced_subjects);
+}
+
+//______________________________________________________________________________________________________________________
+// ГРАФ  КОНФЛИКТОВ
+//______________________________________________________________________________________________________________________
+
+std::shared_ptr<const CConflictGraph>
+CTimeTableBuilder::buildConflictGraph( const std::map< std::string, CSubject >& subjects ) {
+    auto conflict_graph = std::make_shared<CConflictGraph>(subjects.size());
+
+    // Предметы одного учителя или одной группы попарно конфликтуют
+    std::map< std::string, std::vector<size_t> > teachers_subjects, groups_subjects;
+    size_t index(0);
+    for (const auto& [name, subject] : subjects) {
+        for (const auto& teacher : subject.GetTeachers())
+            teachers_subjects[teacher->GetName()].push_back(index);
+        for (const auto& group : subject.GetGroups())
+            groups_subjects[group->GetName()].push_back(index);
+        index++;
+    }
+
+    for (const auto* participants_subjects : { &teachers_subjects, &groups_subjects })
+        for (const auto& [name, indices] : *participants_subjects)
+            for (size_t i = 0; i < indices.size(); i++)
+                for (size_t j = i + 1; j < indices.size(); j++)
+                    conflict_graph->AddConflict(indices[i], indices[j]);
+
+    return conflict_graph;
+}
+
 //______________________________________________________________________________________________________________________
 // СОЗДАНИЕ  CTimeTable
 //______________________________________________________________________________________________________________________
 
+void CTimeTableBuilder::analyse() {
+    if (analysed_)
+        return;
+
+    CheckFeasibility();
+    PropagateDomains();
+    analysed_ = true;
+}
+
 CTimeTable CTimeTableBuilder::Build() {
+    TRACE_SCOPE("Build");
+
+    // Merge и пустой BuildComponents строят расписание повторно, но задача уже проверена
+    analyse();
 
     return { teachers_,
              cabinets_,
              groups_,
              subjects_,
+             buildConflictGraph(subjects_),
              days_in_week_, lessons_in_day_ };
 
-}
\ No newline at end of file
+}
+
+std::vector<CTimeTable> CTimeTableBuilder::BuildComponents() {
+    TRACE_SCOPE("BuildComponents");
+
+    analyse();
+
+    // Система непересекающихся множеств на предметах: предметы объединяются через общих участников
+    std::vector<std::string> subject_names;
+    std::map<std::string, size_t> subject_numbers;
+    for (const auto& [name, subject] : subjects_) {
+        subject_numbers.insert( { name, subject_names.size() } );
+        subject_names.push_back(name);
+    }
+
+    std::vector<size_t> parent(subject_names.size());
+    std::iota(parent.begin(), parent.end(), 0);
+    std::function<size_t(size_t)> find = [&parent, &find] (size_t x) {
+        return parent[x] == x ? x : parent[x] = find(parent[x]);
+    };
+
+    // Первый встреченный предмет каждого участника, с ним объединяются остальные
+    std::map<std::string, size_t> teacher_owner, group_owner, cabinet_owner;
+    auto unite = [&find, &parent] (std::map<std::string, size_t>& owner, const std::string& name, size_t subject) {
+        auto it = owner.find(name);
+        if ( it == owner.end() )
+            owner.insert( { name, subject } );
+        else
+            parent[find(subject)] = find(it->second);
+    };
+
+    for (const auto& [name, subject] : subjects_) {
+        size_t number = subject_numbers.at(name);
+        for (const auto& teacher : subject.GetTeachers())
+            unite(teacher_owner, teacher->GetName(), number);
+        for (const auto& group : subject.GetGroups())
+            unite(group_owner, group->GetName(), number);
+        for (const auto& cabinet : subject.GetCabinets())
+            unite(cabinet_owner, cabinet->GetName(), number);
+    }
+
+    // Раскладываем предметы и их участников по компонентам
+    std::map<size_t, size_t> component_numbers;
+    std::vector< std::map<std::string, CSubject> > component_subjects;
+    for (const auto& [name, subject] : subjects_) {
+        size_t root = find( subject_numbers.at(name) );
+        if ( component_numbers.find(root) == component_numbers.end() ) {
+            component_numbers.insert( { root, component_subjects.size() } );
+            component_subjects.emplace_back();
+        }
+        component_subjects[ component_numbers.at(root) ].insert( { name, subject } );
+    }
+
+    std::vector<CTimeTable> components;
+    for (auto& subjects : component_subjects) {
+        std::map<std::string, CTeacher> teachers;
+        std::map<std::string, CGroup> groups;
+        std::map<std::string, CCabinet> cabinets;
+
+        for (const auto& [name, subject] : subjects) {
+            for (const auto& teacher : subject.GetTeachers())
+                teachers.insert( { teacher->GetName(), *teacher } );
+            for (const auto& group : subject.GetGroups())
+                groups.insert( { group->GetName(), *group } );
+            for (const auto& cabinet : subject.GetCabinets())
+                cabinets.insert( { cabinet->GetName(), *cabinet } );
+        }
+
+        components.push_back( CTimeTable{ teachers, cabinets, groups, subjects, buildConflictGraph(subjects),
+                                          days_in_week_, lessons_in_day_ } );
+    }
+
+    if ( components.empty() )
+        components.push_back( Build() );
+
+    return components;
+}
+
+CTimeTable CTimeTableBuilder::Merge(const std::vector<CTimeTable>& components) {
+    CTimeTable timetable = Build();
+
+    for (const auto& component : components)
+        timetable.ImportEvents(component);
+
+    return timetable;
+}
@@ -0,0 +1,102 @@
+#include "CTrace.h"
+
+#ifdef TIMER_TRACE
+
+#include <fstream>
+
+//______________________________________________________________________________________________________________________
+//______________________________________________________________________________________________________________________
+//
+// TraceBuffer
+//
+//______________________________________________________________________________________________________________________
+//______________________________________________________________________________________________________________________
+
+// Трассировщик создается раньше буфера потока, поэтому уничтожается позже, и буфер главного потока успевает слиться
+TraceBuffer::TraceBuffer() {
+    CTracer& tracer = CTracer::Instance();
+
+    std::lock_guard<std::mutex> lock(tracer.mutex_);
+    lane = tracer.lanes_number_++;
+}
+
+TraceBuffer::~TraceBuffer() {
+    CTracer::Instance().merge(*this);
+}
+
+//______________________________________________________________________________________________________________________
+//______________________________________________________________________________________________________________________
+//
+// CTracer
+//
+//______________________________________________________________________________________________________________________
+//______________________________________________________________________________________________________________________
+
+CTracer::CTracer()
+        : lanes_number_(0),
+          origin_(std::chrono::steady_clock::now()) {}
+
+CTracer& CTracer::Instance() {
+    static CTracer tracer;
+    return tracer;
+}
+
+TraceBuffer& CTracer::ThreadBuffer() {
+    static thread_local TraceBuffer buffer;
+    return buffer;
+}
+
+int64_t CTracer::Now() const {
+    return std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - origin_ ).count();
+}
+
+void CTracer::merge(TraceBuffer& buffer) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& event : buffer.events)
+        events_.emplace_back(buffer.lane, event);
+    buffer.events.clear();
+}
+
+void CTracer::Write(const std::string& filename) {
+    merge( ThreadBuffer() );
+
+    std::ofstream file(filename);
+    if ( !file.is_open() )
+        return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Сначала имена дорожек, затем интервалы; запятая ставится перед каждой записью, кроме первой
+    const char* separator = "";
+    file << "{\"traceEvents\":[";
+    for (size_t lane = 0; lane < lanes_number_; lane++) {
+        file << separator << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << lane
+             << ",\"args\":{\"name\":\"thread " << lane << "\"}}";
+        separator = ",";
+    }
+    for (const auto& [lane, event] : events_) {
+        file << separator << "\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << lane
+             << ",\"ts\":" << event.start << ",\"dur\":" << event.duration << "}";
+        separator = ",";
+    }
+    file << "\n]}\n";
+}
+
+//______________________________________________________________________________________________________________________
+//______________________________________________________________________________________________________________________
+//
+// CTraceScope
+//
+//______________________________________________________________________________________________________________________
+//______________________________________________________________________________________________________________________
+
+CTraceScope::CTraceScope(const char* name)
+        : name_(name),
+          start_(CTracer::Instance().Now()) {}
+
+CTraceScope::~CTraceScope() {
+    int64_t end = CTracer::Instance().Now();
+    CTracer::ThreadBuffer().events.push_back( {name_, start_, end - start_} );
+}
+
+#endif //TIMER_TRACE
@@ -1,4 +1,9 @@
 #include <iostream>
+#include <csignal>
+#include <iomanip>
+#include <optional>
+#include "CTrace.h"
+#include "CTrace.cpp"
 #include "CTeacher.h"
 #include "CTeacher.cpp"
 #include "CCabinet.h"
@@ -7,16 +12,45 @@
 #include "CGroup.cpp"
 #include "CSubject.h"
 #include "CSubject.cpp"
+#include "CConflictGraph.h"
+#include "CConflictGraph.cpp"
+#include "CMappedFile.h"
+#include "CMappedFile.cpp"
+#include "COccupancy.h"
+#include "COccupancy.cpp"
+#include "CProblemInstance.h"
+#include "CProblemInstance.cpp"
 #include "CTimeTable.h"
 #include "CTimeTable.cpp"
 #include "CEvent.h"
 #include "CEvent.cpp"
 #include "CException.h"
 #include "CException.cpp"
+#include "CInputTokenizer.h"
+#include "CInputTokenizer.cpp"
 #include "CObjectiveFunction.cpp"
+#include "CProgress.h"
+#include "CProgress.cpp"
+#include "CStoppingCriteria.h"
+#include "CStoppingCriteria.cpp"
+#include "CSolutionPublisher.h"
+#include "CSolutionPublisher.cpp"
 #include "CObjectiveFunction.h"
 #include "CABCOptimizer.h"
 #include "CABCOptimizer.cpp"
+#include "CSAOptimizer.h"
+#include "CSAOptimizer.cpp"
+#include "CTabuOptimizer.h"
+#include "CTabuOptimizer.cpp"
+#include "CLNSOptimizer.h"
+#include "CLNSOptimizer.cpp"
+#include "CComponentsSolver.h"
+#include "CThreadPool.h"
+#include "CThreadPool.cpp"
+#include "CSchedulingService.h"
+#include "CSchedulingService.cpp"
+#include "CSchedulingServer.h"
+#include "CSchedulingServer.cpp"
 #include "Tests.h"
 #include <unordered_set>
 
@@ -28,32 +62,396 @@ const int LESSONS_IN_DAY (7);
 const int POPULATION_SIZE (50);
 const int CYCLES_NUMBER (4000);
 const int IMPROVEMENT_LIMIT (750);
+const ScoutMode SCOUT_MODE (ScoutMode::Perturb);
+const double SCOUT_PERTURBATION_FRACTION (0.2);
+// Выводить статистику ABC ( ABCStats ) в консоль после решения каждой компоненты
+const bool PRINT_ABC_STATS (true);
+
+// Параметры алгоритма имитации отжига
+const double INITIAL_TEMPERATURE (300);
+const double FINAL_TEMPERATURE (1);
+const double COOLING_RATE (0.999);
+const CoolingSchedule COOLING_SCHEDULE (CoolingSchedule::Geometric);
+const int ITERATIONS_NUMBER (200000);
+const int REHEAT_LIMIT (5000);
+const double REHEAT_RATIO (0.5);
+
+// Параметры поиска с запретами
+const int CANDIDATES_NUMBER (30);
+const int TABU_TENURE (15);
+const int TABU_ITERATIONS_NUMBER (20000);
+
+// Параметры поиска в большой окрестности
+const int LNS_ITERATIONS_NUMBER (20000);
+
+// Отчеты о ходе работы: не чаще раза в PROGRESS_INTERVAL_SECONDS, в консоль или, если PROGRESS_JSON_PATH не пуст,
+// в файл в формате JSON Lines
+const double PROGRESS_INTERVAL_SECONDS (1);
+const std::string PROGRESS_JSON_PATH ("");
+
+// Условия остановки, общие для всех оптимизаторов, в дополнение к их числу итераций; 0 -- условие не задано.
+// Целевая оценка может быть нулевой ( расписание без штрафов ), поэтому не заданная -- std::nullopt.
+// Оптимизатор останавливается по первому выполненному условию.
+const double TIME_BUDGET_SECONDS (600);
+const std::optional<size_t> STOP_TARGET_COST (std::nullopt);
+const size_t STOP_NO_IMPROVEMENT_ITERATIONS (0);
+const double STOP_NO_IMPROVEMENT_SECONDS (0);
+
+// Контрольные точки ABC: раз в CHECKPOINT_INTERVAL_SECONDS и при остановке ( в том числе по SIGTERM и SIGINT )
+// состояние оптимизатора компоненты i записывается в CHECKPOINT_PATH.i; если такой файл уже есть, работа
+// продолжается с него. Пустой путь отключает контрольные точки.
+const std::string CHECKPOINT_PATH ("");
+const double CHECKPOINT_INTERVAL_SECONDS (300);
+
+// Используемый оптимизатор
+enum class Optimizer { ABC, SA, Tabu, LNS };
+const Optimizer OPTIMIZER (Optimizer::ABC);
 
 const std::string input_folder_path ("../8-11/");
+// Скомпилированная задача ( CTimeTableBuilder::CompileInstance ). Если файл есть, задача читается из него без разбора
+// текстовых файлов; иначе текстовые файлы читаются и компилируются в него. После правки входных файлов его нужно
+// удалить. Пустой путь -- всегда читать текстовые файлы.
+const std::string instance_path ("");
 const std::string output_folder_path ("/Users/greg/Desktop/Outputs/");
 
-int main() {
+// Пакетный режим ( папки задач в аргументах командной строки ): задачи решаются одновременно не больше чем в
+// BATCH_THREADS_NUMBER потоках ( 0 -- по числу ядер ), каждая не дольше BATCH_JOB_TIME_BUDGET_SECONDS
+const size_t BATCH_THREADS_NUMBER (0);
+const double BATCH_JOB_TIME_BUDGET_SECONDS (600);
+
+// Режим службы ( --serve <socket> ): задачи, присланные через сокет, решаются не больше чем в SERVICE_THREADS_NUMBER
+// потоках ( 0 -- по числу ядер ), каждая не дольше SERVICE_JOB_TIME_BUDGET_SECONDS. Входные данные и расписания
+// задач хранятся в SERVICE_WORK_FOLDER. Из завершенных задач хранятся SERVICE_MAX_FINISHED_JOBS последних, более
+// старые удаляются вместе с папками.
+const size_t SERVICE_THREADS_NUMBER (0);
+const double SERVICE_JOB_TIME_BUDGET_SECONDS (600);
+const size_t SERVICE_MAX_FINISHED_JOBS (1000);
+const std::string SERVICE_WORK_FOLDER (output_folder_path + "service/");
+
+// Параметры решения одной задачи
+struct SolveSettings {
+    // Бюджет времени на всю задачу; 0 -- не ограничен
+    double time_budget_seconds;
+    // Префикс файлов контрольных точек ABC; пустой -- не записывать
+    std::string checkpoint_path;
+    // nullptr -- без отчетов о ходе работы
+    std::shared_ptr<CProgressSink> progress_sink;
+    // Имя задачи в отчетах о ходе работы ( пустое -- единственная задача )
+    std::string job_name;
+    // Оптимизаторы останавливаются, когда флаг станет true
+    const std::atomic<bool>* cancel_flag;
+    // Получает лучшее решение ABC при каждом улучшении; nullptr -- не публиковать
+    CSolutionPublisher::ImprovementCallback on_improvement;
+};
+
+// Записать расписание групп и учителей в output_folder_path, приписав prefix к именам файлов
+void WriteTimeTable(const CTimeTable& table, const std::string& prefix = "") {
+    table.GroupsScheduleTex(output_folder_path + prefix + "GOutput.tex");
+    table.TeachersScheduleTex(output_folder_path + prefix + "TOutput.tex");
+}
+
+// Общий для всех компонент и задач пакетного режима приемник отчетов; отчеты в нем подписаны задачей и компонентой
+std::shared_ptr<CProgressSink> ProgressSink() {
+    static std::shared_ptr<CProgressSink> sink = PROGRESS_JSON_PATH.empty()
+            ? std::shared_ptr<CProgressSink>( std::make_shared<CConsoleProgressSink>() )
+            : std::shared_ptr<CProgressSink>( std::make_shared<CJsonLinesProgressSink>(PROGRESS_JSON_PATH) );
+    return sink;
+}
+
+// Выставляется извне ( например, обработчиком сигнала ), чтобы все оптимизаторы завершились с лучшим найденным решением
+std::atomic<bool> cancel_requested (false);
+
+extern "C" void RequestCancel(int) {
+    cancel_requested = true;
+}
+
+// Заменяет условия остановки, заданные конструктором оптимизатора, пределом итераций, бюджетом времени и общими
+// условиями
+template <class TOptimizer>
+void SetStoppingCriteria( TOptimizer& optimizer, size_t iteration_limit, double time_budget_seconds,
+                          const std::atomic<bool>* cancel_flag ) {
+    CStoppingCriteria criteria;
+    criteria.SetIterationLimit(iteration_limit).SetCancelFlag(cancel_flag);
+    if (time_budget_seconds > 0)
+        criteria.SetTimeBudget(time_budget_seconds);
+    if (STOP_TARGET_COST)
+        criteria.SetTargetCost(*STOP_TARGET_COST);
+    if (STOP_NO_IMPROVEMENT_ITERATIONS > 0)
+        criteria.SetNoImprovementIterations(STOP_NO_IMPROVEMENT_ITERATIONS);
+    if (STOP_NO_IMPROVEMENT_SECONDS > 0)
+        criteria.SetNoImprovementTime(STOP_NO_IMPROVEMENT_SECONDS);
+    optimizer.SetStoppingCriteria(criteria);
+}
+
+// Запускает оптимизатор компоненты component и сообщает, почему он остановился. Отчеты о ходе работы подписываются
+// задачей и компонентой: приемник бывает общим для нескольких задач пакетного режима.
+template <class TOptimizer>
+CTimeTable RunOptimizer(TOptimizer& optimizer, const SolveSettings& settings, size_t component) {
+    optimizer.SetProgressSink( settings.progress_sink
+                               ? std::make_shared<CLabelledProgressSink>(settings.progress_sink, settings.job_name,
+                                                                         component)
+                               : nullptr,
+                               PROGRESS_INTERVAL_SECONDS );
+    optimizer.FindOptimal();
+    WriteConsole( std::string("Stopped: ") + StopReasonName( optimizer.GetStopReason() ) + "\n" );
+    return optimizer.GetCurrentBestSolution().first;
+}
+
+// Продолжить с контрольной точки компоненты, если она есть, и записывать новые
+void SetCheckpoint(CABCOptimizer& optimizer, const std::string& checkpoint_path, size_t component) {
+    if ( checkpoint_path.empty() )
+        return;
+
+    std::string checkpoint = checkpoint_path + "." + std::to_string(component);
+    if ( std::ifstream(checkpoint).is_open() ) {
+        try {
+            optimizer.LoadCheckpoint(checkpoint);
+            WriteConsole("Resumed from " + checkpoint + "\n");
+        } catch (CBadCheckpoint &ex) {
+            WriteConsole(ex.GetMessage() + ", starting from scratch\n");
+        }
+    }
+    optimizer.SetCheckpoint(checkpoint, CHECKPOINT_INTERVAL_SECONDS);
+}
+
+CTimeTable Optimize(CTimeTable& table, size_t component, const SolveSettings& settings, double time_budget_seconds) {
+    switch (OPTIMIZER) {
+        case Optimizer::ABC: {
+            CABCOptimizer optimizer(table, POPULATION_SIZE, CYCLES_NUMBER, IMPROVEMENT_LIMIT,
+                                    SCOUT_MODE, SCOUT_PERTURBATION_FRACTION);
+            SetStoppingCriteria(optimizer, CYCLES_NUMBER, time_budget_seconds, settings.cancel_flag);
+            SetCheckpoint(optimizer, settings.checkpoint_path, component);
+            if (settings.on_improvement) {
+                // Начальное решение уже опубликовано конструктором, поэтому передается сразу
+                optimizer.SetImprovementCallback(settings.on_improvement);
+                settings.on_improvement( optimizer.GetBestSnapshot() );
+            }
+            CTimeTable solution = RunOptimizer(optimizer, settings, component);
+            if (PRINT_ABC_STATS) {
+                // Статистика -- несколько строк, они выводятся одним куском, чтобы их не разрывали другие компоненты
+                std::ostringstream stats;
+                stats << optimizer.GetStats();
+                WriteConsole( stats.str() );
+            }
+            return solution;
+        }
+        case Optimizer::SA: {
+            CSAOptimizer optimizer(table, INITIAL_TEMPERATURE, FINAL_TEMPERATURE, COOLING_RATE, COOLING_SCHEDULE,
+                                   ITERATIONS_NUMBER, REHEAT_LIMIT, REHEAT_RATIO, time_budget_seconds);
+            SetStoppingCriteria(optimizer, ITERATIONS_NUMBER, time_budget_seconds, settings.cancel_flag);
+            return RunOptimizer(optimizer, settings, component);
+        }
+        case Optimizer::Tabu: {
+            CTabuOptimizer optimizer(table, CANDIDATES_NUMBER, TABU_TENURE, TABU_ITERATIONS_NUMBER,
+                                     time_budget_seconds);
+            SetStoppingCriteria(optimizer, TABU_ITERATIONS_NUMBER, time_budget_seconds, settings.cancel_flag);
+            return RunOptimizer(optimizer, settings, component);
+        }
+        case Optimizer::LNS: {
+            CLNSOptimizer optimizer(table, LNS_ITERATIONS_NUMBER, time_budget_seconds);
+            SetStoppingCriteria(optimizer, LNS_ITERATIONS_NUMBER, time_budget_seconds, settings.cancel_flag);
+            return RunOptimizer(optimizer, settings, component);
+        }
+    }
+    return table;
+}
+
+// Прочитать задачу из папки input_folder ( четыре текстовых файла ) или из скомпилированного файла instance_file
+// ( см. instance_path ). Выкидывает CException при ошибке во входных данных.
+void ReadInstance(CTimeTableBuilder& table_builder, const std::string& input_folder, const std::string& instance_file) {
+    if ( !instance_file.empty() && std::ifstream(instance_file).is_open() ) {
+        table_builder.SetTimeTableInstance(instance_file);
+    } else {
+        table_builder.SetTimeTableTeachers(input_folder + "teachers.txt");
+        table_builder.SetTimeTableGroups(input_folder + "groups.txt");
+        table_builder.SetTimeTableCabinets(input_folder + "cabinets.txt");
+        table_builder.SetTimeTableSubjects(input_folder + "subjects.txt");
+        table_builder.SetTimeTableSize(DAYS_IN_WEEK, LESSONS_IN_DAY);
+        if ( !instance_file.empty() )
+            table_builder.CompileInstance(instance_file);
+    }
+    for (const auto& warning : table_builder.GetWarnings())
+        WriteConsole("Warning: " + warning + "\n");
+}
+
+// Решить задачу по компонентам. Бюджет времени общий. Параллельные компоненты работают одновременно, и каждая
+// получает весь бюджет. Последовательные делят остаток бюджета пропорционально количеству предметов среди еще не
+// решенных, поэтому первая компонента не может занять время остальных, а сэкономленное ею достается следующим.
+CTimeTable SolveInstance(CTimeTableBuilder& table_builder, const SolveSettings& settings, bool parallel_components) {
+    auto start = std::chrono::steady_clock::now();
+    size_t unsolved_subjects = table_builder.GetSubjectsNumber();
+    auto solve = [&settings, start, parallel_components, &unsolved_subjects] (CTimeTable& table, size_t component) {
+        double time_budget_seconds = settings.time_budget_seconds;
+        if (time_budget_seconds > 0) {
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            time_budget_seconds = std::max(time_budget_seconds - elapsed, 0.0);
+            if ( !parallel_components ) {
+                size_t subjects = table.GetConflictGraph().GetSubjectsNumber();
+                if (unsolved_subjects > subjects)
+                    time_budget_seconds *= static_cast<double>(subjects) / unsolved_subjects;
+                unsolved_subjects -= std::min(subjects, unsolved_subjects);
+            }
+            // Бюджет исчерпан -- компонента получает только начальное решение
+            time_budget_seconds = std::max(time_budget_seconds, 1e-9);
+        }
+        return Optimize(table, component, settings, time_budget_seconds);
+    };
+    return SolveByComponents(table_builder, solve, parallel_components);
+}
+
+// Итог одной задачи пакетного режима
+struct BatchResult {
+    std::string name;
+    bool solved = false;
+    size_t cost = 0;
+    double seconds = 0;
+    // Ошибка, если задача не решена
+    std::string message;
+};
+
+// Имя задачи -- последний элемент пути к ее папке
+std::string BatchJobName(std::string folder) {
+    while ( folder.size() > 1 && folder.back() == '/' )
+        folder.pop_back();
+    return folder.substr( folder.find_last_of('/') + 1 );
+}
+
+BatchResult SolveBatchJob(const std::string& folder) {
+    BatchResult result;
+    result.name = BatchJobName(folder);
+    auto start = std::chrono::steady_clock::now();
+
+    try {
+        CTimeTableBuilder table_builder;
+        ReadInstance(table_builder, folder + "/", "");
+
+        // Консольная строка состояния от нескольких задач сразу нечитаема, поэтому отчеты -- только в файл
+        SolveSettings settings { BATCH_JOB_TIME_BUDGET_SECONDS,
+                                 CHECKPOINT_PATH.empty() ? "" : CHECKPOINT_PATH + "." + result.name,
+                                 PROGRESS_JSON_PATH.empty() ? nullptr : ProgressSink(),
+                                 result.name,
+                                 &cancel_requested,
+                                 nullptr };
+        // Задачи уже занимают все потоки пула, поэтому компоненты одной задачи решаются по очереди
+        CTimeTable table = SolveInstance(table_builder, settings, false);
 
+        WriteTimeTable(table, result.name + "-");
+        result.cost = CObjectiveFunction().Value(table);
+        result.solved = true;
+    } catch (CException &ex) {
+        result.message = ex.GetMessage();
+    } catch (std::exception &ex) {
+        result.message = ex.what();
+    }
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+void WriteBatchSummary(const std::vector<BatchResult>& results, std::ostream& stream) {
+    stream << std::left << std::setw(24) << "instance" << std::setw(8) << "status"
+           << std::right << std::setw(12) << "cost" << std::setw(12) << "seconds" << "   message\n";
+    for (const auto& result : results) {
+        stream << std::left << std::setw(24) << result.name << std::setw(8) << (result.solved ? "ok" : "failed")
+               << std::right << std::setw(12) << result.cost
+               << std::setw(12) << std::fixed << std::setprecision(1) << result.seconds
+               << "   " << result.message << '\n';
+    }
+}
+
+// Решить задачи из папок folders на общем пуле потоков. Расписания записываются в output_folder_path с именем задачи
+// в начале имени файла, сводная таблица -- в консоль и в output_folder_path/summary.txt.
+void RunBatch(const std::vector<std::string>& folders) {
+    std::vector<BatchResult> results( folders.size() );
+    {
+        CThreadPool pool( BATCH_THREADS_NUMBER > 0 ? BATCH_THREADS_NUMBER : std::thread::hardware_concurrency() );
+        for (size_t i = 0; i < folders.size(); i++)
+            pool.Submit( [&results, &folders, i] () {
+                TRACE_SCOPE("Batch job");
+                results[i] = SolveBatchJob(folders[i]);
+            } );
+        pool.Wait();
+    }
+
+    WriteBatchSummary(results, std::cout);
+    std::ofstream summary(output_folder_path + "summary.txt");
+    WriteBatchSummary(results, summary);
+}
+
+// Решить задачу службы: input -- папка с текстовыми файлами или скомпилированный файл
+CTimeTable SolveServiceJob( const std::string& input, const std::atomic<bool>* cancel_flag,
+                            std::shared_ptr<CProgressSink> sink,
+                            CSolutionPublisher::ImprovementCallback on_improvement ) {
     CTimeTableBuilder table_builder;
+    bool is_folder = std::ifstream(input + "/teachers.txt").is_open();
+    ReadInstance(table_builder, input + "/", is_folder ? "" : input);
+
+    // Как и в пакетном режиме, потоки пула заняты задачами, поэтому компоненты решаются по очереди
+    // У каждой задачи службы свой приемник, поэтому имя задачи в отчетах не нужно
+    SolveSettings settings { SERVICE_JOB_TIME_BUDGET_SECONDS, "", std::move(sink), "", cancel_flag,
+                             std::move(on_improvement) };
+    return SolveInstance(table_builder, settings, false);
+}
 
-    table_builder.SetTimeTableTeachers(input_folder_path + "teachers.txt");
-    table_builder.SetTimeTableGroups(input_folder_path + "groups.txt");
-    table_builder.SetTimeTableCabinets(input_folder_path + "cabinets.txt");
+// Обслуживать запросы на сокете socket_path до команды SHUTDOWN или сигнала. Запущенные задачи при остановке
+// отменяются и записывают лучшее найденное расписание.
+void RunService(const std::string& socket_path) {
     try {
-        table_builder.SetTimeTableSubjects(input_folder_path + "subjects.txt");
+        CSchedulingService service( SERVICE_WORK_FOLDER,
+                                    SERVICE_THREADS_NUMBER > 0 ? SERVICE_THREADS_NUMBER
+                                                               : std::thread::hardware_concurrency(),
+                                    SolveServiceJob,
+                                    SERVICE_MAX_FINISHED_JOBS );
+        CSchedulingServer server(service, socket_path);
+        std::cout << "Listening on " << socket_path << std::endl;
+        server.Run(&cancel_requested);
+        service.CancelAll();
     } catch (CException &ex) {
         std::cout << ex.GetMessage() << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+
+    // Остановка по сигналу: оптимизаторы завершаются с лучшим найденным решением и записывают контрольные точки
+    std::signal(SIGTERM, RequestCancel);
+    std::signal(SIGINT, RequestCancel);
+
+    if ( argc > 1 && std::string(argv[1]) == "--serve" ) {
+        if (argc != 3) {
+            std::cout << "Usage: " << argv[0] << " --serve <socket>" << std::endl;
+            return 1;
+        }
+        RunService(argv[2]);
+        TRACE_WRITE(output_folder_path + "trace.json");
+        return 0;
+    }
+
+    if (argc > 1) {
+        RunBatch( std::vector<std::string>(argv + 1, argv + argc) );
+        TRACE_WRITE(output_folder_path + "trace.json");
         return 0;
     }
-    table_builder.SetTimeTableSize(DAYS_IN_WEEK, LESSONS_IN_DAY);
 
-    CTimeTable table = table_builder.Build();
+    CTimeTableBuilder table_builder;
 
-    CABCOptimizer optimizer(table, POPULATION_SIZE, CYCLES_NUMBER, IMPROVEMENT_LIMIT);
-    optimizer.FindOptimal();
+    try {
+        ReadInstance(table_builder, input_folder_path, instance_path);
+    } catch (CException &ex) {
+        std::cout << ex.GetMessage() << std::endl;
+        return 0;
+    }
+
+    // Независимые части школы ( например, разные здания без общих учителей ) решаются параллельно
+    try {
+        SolveSettings settings { TIME_BUDGET_SECONDS, CHECKPOINT_PATH, ProgressSink(), "", &cancel_requested, nullptr };
+        WriteTimeTable( SolveInstance(table_builder, settings, true) );
+    } catch (CException &ex) {
+        std::cout << ex.GetMessage() << std::endl;
+        return 0;
+    }
 
-    optimizer.GetCurrentBestSolution().first.GroupsScheduleTex(output_folder_path + "GOutput.tex");
-    optimizer.GetCurrentBestSolution().first.TeachersScheduleTex(output_folder_path + "TOutput.tex");
+    TRACE_WRITE(output_folder_path + "trace.json");
 
     return 0;
-}
\ No newline at end of file
+}